@@ -0,0 +1,509 @@
+#include "benchmarkreport.h"
+
+#include <build_options.h>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace octreebuilder {
+
+BenchmarkResult::BenchmarkResult() {
+}
+
+BenchmarkResult::BenchmarkResult(const std::string& benchmark, const std::string& unit) : benchmark(benchmark), unit(unit) {
+}
+
+double BenchmarkResult::mean() const {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    return std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+}
+
+double BenchmarkResult::min() const {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    return *std::min_element(samples.begin(), samples.end());
+}
+
+double BenchmarkResult::standardDeviation() const {
+    if (samples.size() < 2) {
+        return 0.0;
+    }
+
+    const double m = mean();
+    double sumOfSquares = 0.0;
+    for (const double sample : samples) {
+        sumOfSquares += (sample - m) * (sample - m);
+    }
+    return std::sqrt(sumOfSquares / static_cast<double>(samples.size() - 1));
+}
+
+static std::string cpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            const size_t colon = line.find(':');
+            if (colon != std::string::npos && colon + 2 <= line.size()) {
+                return line.substr(colon + 2);
+            }
+        }
+    }
+    return "unknown";
+}
+
+static std::string currentTime() {
+    const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    char buffer[32];
+    if (std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now)) == 0) {
+        return "unknown";
+    }
+    return buffer;
+}
+
+BenchmarkEnvironment BenchmarkEnvironment::detect() {
+    BenchmarkEnvironment environment;
+
+    std::vector<std::pair<std::string, std::string>>& p = environment.properties;
+    p.push_back(std::make_pair("time", currentTime()));
+    p.push_back(std::make_pair("cpu", cpuModel()));
+    p.push_back(std::make_pair("hardwareThreads", std::to_string(std::thread::hardware_concurrency())));
+    p.push_back(std::make_pair("ompMaxThreads", std::to_string(omp_get_max_threads())));
+#ifdef BENCHMARK_BUILD_TYPE
+    p.push_back(std::make_pair("buildType", std::string(BENCHMARK_BUILD_TYPE)));
+#endif
+#ifdef NDEBUG
+    p.push_back(std::make_pair("assertions", "off"));
+#else
+    p.push_back(std::make_pair("assertions", "on"));
+#endif
+#ifdef OCTREEBUILDER_USE_SSE
+    p.push_back(std::make_pair("sse", "on"));
+#else
+    p.push_back(std::make_pair("sse", "off"));
+#endif
+#ifdef BENCHMARK_WITH_TCMALLOC
+    p.push_back(std::make_pair("tcmalloc", "on"));
+#else
+    p.push_back(std::make_pair("tcmalloc", "off"));
+#endif
+#ifdef PROFILING_ENABLED
+    p.push_back(std::make_pair("profiling", "on"));
+#else
+    p.push_back(std::make_pair("profiling", "off"));
+#endif
+#ifdef __VERSION__
+    p.push_back(std::make_pair("compiler", std::string(__VERSION__)));
+#endif
+
+    return environment;
+}
+
+BaselineComparison::BaselineComparison() : missing(false), baselineMean(0.0), currentMean(0.0), relativeChange(0.0), pValue(1.0), slowdown(false) {
+}
+
+ReportOptions::ReportOptions() : alpha(0.05), toleratedSlowdown(0.05) {
+}
+
+BenchmarkReport::BenchmarkReport(const std::string& suite) : m_suite(suite), m_environment(BenchmarkEnvironment::detect()) {
+}
+
+void BenchmarkReport::add(const BenchmarkResult& result) {
+    m_results.push_back(result);
+}
+
+const std::vector<BenchmarkResult>& BenchmarkReport::results() const {
+    return m_results;
+}
+
+static void writeJSONString(std::ostream& os, const std::string& str) {
+    os << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+void BenchmarkReport::writeJson(std::ostream& os) const {
+    const std::streamsize precision = os.precision();
+    os << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    os << "{\"suite\":";
+    writeJSONString(os, m_suite);
+
+    os << ",\"environment\":{";
+    for (size_t i = 0; i < m_environment.properties.size(); i++) {
+        os << (i == 0 ? "" : ",");
+        writeJSONString(os, m_environment.properties[i].first);
+        os << ':';
+        writeJSONString(os, m_environment.properties[i].second);
+    }
+    os << "},\"results\":[";
+
+    for (size_t i = 0; i < m_results.size(); i++) {
+        const BenchmarkResult& result = m_results[i];
+        os << (i == 0 ? "" : ",") << "\n{\"benchmark\":";
+        writeJSONString(os, result.benchmark);
+        os << ",\"unit\":";
+        writeJSONString(os, result.unit);
+        os << ",\"mean\":" << result.mean() << ",\"min\":" << result.min() << ",\"standardDeviation\":" << result.standardDeviation() << ",\"samples\":[";
+        for (size_t s = 0; s < result.samples.size(); s++) {
+            os << (s == 0 ? "" : ",") << result.samples[s];
+        }
+        os << "]}";
+    }
+    os << "\n]}\n";
+
+    os << std::setprecision(static_cast<int>(precision));
+}
+
+static void writeCsvField(std::ostream& os, const std::string& field) {
+    os << '"';
+    for (const char c : field) {
+        if (c == '"') {
+            os << '"';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+void BenchmarkReport::writeCsv(std::ostream& os) const {
+    const std::streamsize precision = os.precision();
+    os << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    for (const std::pair<std::string, std::string>& property : m_environment.properties) {
+        os << "# " << property.first << ": " << property.second << '\n';
+    }
+
+    os << "suite,benchmark,unit,sample\n";
+    for (const BenchmarkResult& result : m_results) {
+        for (const double sample : result.samples) {
+            writeCsvField(os, m_suite);
+            os << ',';
+            writeCsvField(os, result.benchmark);
+            os << ',';
+            writeCsvField(os, result.unit);
+            os << ',' << sample << '\n';
+        }
+    }
+
+    os << std::setprecision(static_cast<int>(precision));
+}
+
+static std::vector<std::string> splitCsvLine(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+
+    for (size_t i = 0; i < line.size(); i++) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::string());
+        } else {
+            fields.back() += c;
+        }
+    }
+
+    if (quoted) {
+        throw std::runtime_error("Invalid CSV line (unterminated quote): " + line);
+    }
+
+    return fields;
+}
+
+std::vector<BenchmarkResult> BenchmarkReport::readCsv(std::istream& is) {
+    std::vector<BenchmarkResult> results;
+    std::map<std::string, size_t> indexOfBenchmark;
+
+    std::string line;
+    bool headerRead = false;
+    while (std::getline(is, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        if (!headerRead) {
+            if (line != "suite,benchmark,unit,sample") {
+                throw std::runtime_error("Invalid CSV header: " + line);
+            }
+            headerRead = true;
+            continue;
+        }
+
+        const std::vector<std::string> fields = splitCsvLine(line);
+        if (fields.size() != 4) {
+            throw std::runtime_error("Invalid CSV line (expected 4 fields): " + line);
+        }
+
+        auto it = indexOfBenchmark.find(fields[1]);
+        if (it == indexOfBenchmark.end()) {
+            it = indexOfBenchmark.insert(std::make_pair(fields[1], results.size())).first;
+            results.push_back(BenchmarkResult(fields[1], fields[2]));
+        }
+
+        char* end = nullptr;
+        const double sample = std::strtod(fields[3].c_str(), &end);
+        if (fields[3].empty() || *end != '\0') {
+            throw std::runtime_error("Invalid CSV line (sample is not a number): " + line);
+        }
+        results[it->second].samples.push_back(sample);
+    }
+
+    if (!headerRead) {
+        throw std::runtime_error("Invalid CSV file: no header found");
+    }
+
+    return results;
+}
+
+/**
+ * @brief Continued fraction of the regularized incomplete beta function (modified Lentz's method)
+ */
+static double incompleteBetaContinuedFraction(const double a, const double b, const double x) {
+    const double tiny = 1e-300;
+    const double epsilon = 1e-12;
+
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+    double result = d;
+
+    for (int m = 1; m <= 300; m++) {
+        const double m2 = 2.0 * m;
+
+        double numerator = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + numerator * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + numerator / (std::fabs(c) < tiny ? tiny : c);
+        result *= d * c;
+
+        numerator = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + numerator * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + numerator / (std::fabs(c) < tiny ? tiny : c);
+        const double delta = d * c;
+        result *= delta;
+
+        if (std::fabs(delta - 1.0) < epsilon) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+static double regularizedIncompleteBeta(const double a, const double b, const double x) {
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    if (x >= 1.0) {
+        return 1.0;
+    }
+
+    const double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+
+    // the continued fraction converges fast for x < (a + 1) / (a + b + 2), otherwise use the symmetry relation
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return front * incompleteBetaContinuedFraction(a, b, x) / a;
+    }
+    return 1.0 - front * incompleteBetaContinuedFraction(b, a, 1.0 - x) / b;
+}
+
+/**
+ * @brief P(T > t) for a student t distributed T with the degrees of freedom
+ */
+static double studentTUpperTail(const double t, const double degreesOfFreedom) {
+    const double tail = 0.5 * regularizedIncompleteBeta(degreesOfFreedom / 2.0, 0.5, degreesOfFreedom / (degreesOfFreedom + t * t));
+    return t > 0.0 ? tail : 1.0 - tail;
+}
+
+/**
+ * @brief One sided p-value of Welch's t-test for the hypothesis mean(current) > mean(baseline)
+ */
+static double welchSlowdownPValue(const BenchmarkResult& baseline, const BenchmarkResult& current) {
+    if (baseline.samples.size() < 2 || current.samples.size() < 2) {
+        // a test isn't possible... only the relative change counts
+        return current.mean() > baseline.mean() ? 0.0 : 1.0;
+    }
+
+    const double baselineVariance = baseline.standardDeviation() * baseline.standardDeviation() / static_cast<double>(baseline.samples.size());
+    const double currentVariance = current.standardDeviation() * current.standardDeviation() / static_cast<double>(current.samples.size());
+    const double variance = baselineVariance + currentVariance;
+    const double difference = current.mean() - baseline.mean();
+
+    if (!(variance > 0.0)) {
+        return difference > 0.0 ? 0.0 : 1.0;
+    }
+
+    const double t = difference / std::sqrt(variance);
+    const double degreesOfFreedom =
+        variance * variance / (baselineVariance * baselineVariance / static_cast<double>(baseline.samples.size() - 1) +
+                               currentVariance * currentVariance / static_cast<double>(current.samples.size() - 1));
+
+    return studentTUpperTail(t, degreesOfFreedom);
+}
+
+std::vector<BaselineComparison> compareWithBaseline(const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current, double alpha,
+                                                    double toleratedSlowdown) {
+    std::vector<BaselineComparison> comparisons;
+
+    for (const BenchmarkResult& currentResult : current) {
+        auto baselineResult = std::find_if(baseline.begin(), baseline.end(),
+                                           [&currentResult](const BenchmarkResult& result) { return result.benchmark == currentResult.benchmark; });
+        BaselineComparison comparison;
+        comparison.benchmark = currentResult.benchmark;
+
+        if (baselineResult == baseline.end() || baselineResult->samples.empty() || currentResult.samples.empty()) {
+            comparison.missing = true;
+            comparisons.push_back(comparison);
+            continue;
+        }
+
+        comparison.baselineMean = baselineResult->mean();
+        comparison.currentMean = currentResult.mean();
+        comparison.relativeChange = comparison.baselineMean > 0.0 ? (comparison.currentMean - comparison.baselineMean) / comparison.baselineMean : 0.0;
+        comparison.pValue = welchSlowdownPValue(*baselineResult, currentResult);
+        comparison.slowdown = comparison.pValue < alpha && comparison.relativeChange > toleratedSlowdown;
+        comparisons.push_back(comparison);
+    }
+
+    return comparisons;
+}
+
+int BenchmarkReport::finish(const ReportOptions& options) const {
+    if (!options.jsonFile.empty()) {
+        std::ofstream json(options.jsonFile);
+        writeJson(json);
+        if (!json) {
+            std::cerr << "Failed to write " << options.jsonFile << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.csvFile.empty()) {
+        std::ofstream csv(options.csvFile);
+        writeCsv(csv);
+        if (!csv) {
+            std::cerr << "Failed to write " << options.csvFile << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.baselineFile.empty()) {
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<BenchmarkResult> baseline;
+    try {
+        std::ifstream baselineFile(options.baselineFile);
+        if (!baselineFile) {
+            throw std::runtime_error("Can't open " + options.baselineFile);
+        }
+        baseline = readCsv(baselineFile);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to read the baseline: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<BaselineComparison> comparisons = compareWithBaseline(baseline, m_results, options.alpha, options.toleratedSlowdown);
+
+    std::cout << "\nComparison with baseline " << options.baselineFile << " (alpha = " << options.alpha << ", tolerated slowdown = " << options.toleratedSlowdown * 100.0
+              << "%)\n";
+
+    size_t numSlowdowns = 0;
+    size_t numMissing = 0;
+    for (const BaselineComparison& comparison : comparisons) {
+        if (comparison.missing) {
+            std::cout << "MISSING  " << comparison.benchmark << " (no samples in the baseline or in this run)\n";
+            numMissing++;
+            continue;
+        }
+
+        std::stringstream change;
+        change << std::fixed << std::setprecision(2) << std::showpos << comparison.relativeChange * 100.0 << '%';
+
+        std::cout << (comparison.slowdown ? "SLOWER   " : "ok       ") << std::left << std::setw(70) << comparison.benchmark << std::setw(12) << change.str()
+                  << "p=" << std::fixed << std::setprecision(4) << comparison.pValue << '\n';
+        if (comparison.slowdown) {
+            numSlowdowns++;
+        }
+    }
+    std::cout << comparisons.size() - numMissing << " benchmarks compared, " << numSlowdowns << " significantly slower, " << numMissing << " missing"
+              << std::endl;
+
+    // a baseline of another suite (or an outdated one) must not pass silently
+    return numSlowdowns > 0 || numMissing > 0 || comparisons.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * @brief Parses the whole string as a number
+ * @return false If the string is empty or not a number
+ */
+static bool parseNumber(const char* str, double& number) {
+    char* end = nullptr;
+    number = std::strtod(str, &end);
+    return end != str && *end == '\0' && std::isfinite(number);
+}
+
+bool parseReportOption(int argc, char* argv[], int& i, ReportOptions& options) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--json" && hasValue) {
+        options.jsonFile = argv[++i];
+    } else if (arg == "--csv" && hasValue) {
+        options.csvFile = argv[++i];
+    } else if (arg == "--baseline" && hasValue) {
+        options.baselineFile = argv[++i];
+    } else if (arg == "--alpha" && hasValue) {
+        return parseNumber(argv[++i], options.alpha) && options.alpha > 0.0 && options.alpha < 1.0;
+    } else if (arg == "--tolerated-slowdown" && hasValue) {
+        return parseNumber(argv[++i], options.toleratedSlowdown) && options.toleratedSlowdown >= 0.0;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+std::string reportOptionsUsage() {
+    return "  --json FILE                 write the results and the environment as JSON\n"
+           "  --csv FILE                  write all samples as CSV (usable as baseline)\n"
+           "  --baseline FILE             compare with a CSV file of a previous run, fails if a benchmark got significantly slower or is missing\n"
+           "  --alpha P                   significance level of the slowdown test (0 < P < 1), default 0.05\n"
+           "  --tolerated-slowdown R      relative slowdowns below R are ignored (R >= 0), default 0.05\n";
+}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Machine readable output of the benchmarks and comparison with a baseline
+ *
+ * The plain benchmark executables accept the options (see parseReportOption):
+ *  --json FILE       writes all results with the environment as JSON
+ *  --csv FILE        writes all samples as CSV (can be used as baseline)
+ *  --baseline FILE   compares the results with a CSV file written by a previous run. Exits with a failure if a benchmark got significantly slower or
+ *                    is missing in the baseline.
+ */
+namespace octreebuilder {
+
+/**
+ * @brief The samples (one per repetition) of a benchmark
+ *
+ * Smaller values are better (e.g. a time).
+ */
+struct BenchmarkResult {
+    BenchmarkResult();
+    BenchmarkResult(const std::string& benchmark, const std::string& unit);
+
+    std::string benchmark;
+    std::string unit;
+    std::vector<double> samples;
+
+    double mean() const;
+    double min() const;
+    double standardDeviation() const;
+};
+
+/**
+ * @brief The machine and build the benchmarks ran on
+ */
+struct BenchmarkEnvironment {
+    static BenchmarkEnvironment detect();
+
+    std::vector<std::pair<std::string, std::string>> properties;
+};
+
+/**
+ * @brief The result of the comparison of a benchmark with its baseline
+ */
+struct BaselineComparison {
+    BaselineComparison();
+
+    std::string benchmark;
+
+    /**
+     * @brief True if the benchmark has no samples in the baseline or in the current results (the other values are not set then)
+     */
+    bool missing;
+
+    double baselineMean;
+    double currentMean;
+
+    /**
+     * @brief (current - baseline) / baseline
+     */
+    double relativeChange;
+
+    /**
+     * @brief The one sided p-value of Welch's t-test for "current is slower than baseline"
+     */
+    double pValue;
+
+    /**
+     * @brief True if the slowdown is significant (pValue < alpha) and larger than the tolerated relative slowdown
+     */
+    bool slowdown;
+};
+
+struct ReportOptions {
+    ReportOptions();
+
+    std::string jsonFile;
+    std::string csvFile;
+    std::string baselineFile;
+
+    /**
+     * @brief The significance level of the slowdown test
+     */
+    double alpha;
+
+    /**
+     * @brief Slowdowns below this relative change are not reported (e.g. 0.05 = 5%)
+     */
+    double toleratedSlowdown;
+};
+
+class BenchmarkReport {
+public:
+    explicit BenchmarkReport(const std::string& suite);
+
+    void add(const BenchmarkResult& result);
+
+    const std::vector<BenchmarkResult>& results() const;
+
+    void writeJson(std::ostream& os) const;
+
+    /**
+     * @brief Writes one line per sample (columns: suite, benchmark, unit, sample), the environment is written as comment lines (starting with #)
+     */
+    void writeCsv(std::ostream& os) const;
+
+    /**
+     * @brief Reads the results of a file written by writeCsv
+     * @throws std::runtime_error If the file is invalid
+     */
+    static std::vector<BenchmarkResult> readCsv(std::istream& is);
+
+    /**
+     * @brief Writes the requested files and compares with the baseline (if any)
+     * @return EXIT_FAILURE if a benchmark got significantly slower or is missing in the baseline or a file couldn't be written/read, EXIT_SUCCESS otherwise
+     */
+    int finish(const ReportOptions& options) const;
+
+private:
+    std::string m_suite;
+    BenchmarkEnvironment m_environment;
+    std::vector<BenchmarkResult> m_results;
+};
+
+/**
+ * @brief Compares each current benchmark with the baseline (benchmarks without samples in both result lists are marked as missing)
+ */
+std::vector<BaselineComparison> compareWithBaseline(const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current, double alpha,
+                                                    double toleratedSlowdown);
+
+/**
+ * @brief Handles the report options (see above)
+ * @param i The index of the current argument, is advanced if the option has a value
+ * @return true If argv[i] is a report option with a valid value
+ */
+bool parseReportOption(int argc, char* argv[], int& i, ReportOptions& options);
+
+/**
+ * @brief The usage of the report options (for the help of the executables)
+ */
+std::string reportOptionsUsage();
+}
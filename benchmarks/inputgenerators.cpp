@@ -0,0 +1,303 @@
+#include "inputgenerators.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace octreebuilder {
+
+InputGenerator::~InputGenerator() {
+}
+
+static coord_t clampCoordinate(const double value, const coord_t maxCoord) {
+    const double rounded = std::round(value);
+    if (rounded < 0.0) {
+        return 0;
+    }
+    if (rounded > static_cast<double>(maxCoord)) {
+        return maxCoord;
+    }
+    return static_cast<coord_t>(rounded);
+}
+
+static size_t power(const size_t base, const unsigned int exponent) {
+    size_t result = 1;
+    for (unsigned int i = 0; i < exponent; i++) {
+        result *= base;
+    }
+    return result;
+}
+
+UniformGenerator::UniformGenerator(coord_t maxCoord, size_t numLeafs, size_t seed) : m_maxCoord(maxCoord), m_numLeafs(numLeafs), m_seed(seed) {
+}
+
+std::string UniformGenerator::name() const {
+    std::stringstream s;
+    s << "uniform(maxCoord=" << m_maxCoord << ", numLeafs=" << m_numLeafs << ")";
+    return s.str();
+}
+
+Vector3i UniformGenerator::maxXYZ() const {
+    return Vector3i(m_maxCoord);
+}
+
+size_t UniformGenerator::numLeafsHint() const {
+    return m_numLeafs;
+}
+
+void UniformGenerator::generate(const LeafConsumer& consumer) const {
+    std::default_random_engine generator(m_seed);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, m_maxCoord);
+
+    for (size_t i = 0; i < m_numLeafs; i++) {
+        const coord_t x = coordinateDistribution(generator);
+        const coord_t y = coordinateDistribution(generator);
+        const coord_t z = coordinateDistribution(generator);
+        consumer(Vector3i(x, y, z));
+    }
+}
+
+GaussianClustersGenerator::GaussianClustersGenerator(coord_t maxCoord, size_t numClusters, size_t numLeafs, double standardDeviation, size_t seed)
+    : m_maxCoord(maxCoord), m_numClusters(std::max<size_t>(numClusters, 1)), m_numLeafs(numLeafs), m_standardDeviation(standardDeviation), m_seed(seed) {
+}
+
+std::string GaussianClustersGenerator::name() const {
+    std::stringstream s;
+    s << "gaussianClusters(maxCoord=" << m_maxCoord << ", numClusters=" << m_numClusters << ", numLeafs=" << m_numLeafs
+      << ", standardDeviation=" << m_standardDeviation << ")";
+    return s.str();
+}
+
+Vector3i GaussianClustersGenerator::maxXYZ() const {
+    return Vector3i(m_maxCoord);
+}
+
+size_t GaussianClustersGenerator::numLeafsHint() const {
+    return m_numLeafs;
+}
+
+void GaussianClustersGenerator::generate(const LeafConsumer& consumer) const {
+    std::default_random_engine generator(m_seed);
+    std::uniform_real_distribution<double> centerDistribution(0.0, static_cast<double>(m_maxCoord));
+
+    std::vector<std::array<double, 3>> centers(m_numClusters);
+    for (std::array<double, 3>& center : centers) {
+        center = {{centerDistribution(generator), centerDistribution(generator), centerDistribution(generator)}};
+    }
+
+    std::normal_distribution<double> offsetDistribution(0.0, m_standardDeviation);
+    for (size_t i = 0; i < m_numLeafs; i++) {
+        const std::array<double, 3>& center = centers[i % m_numClusters];
+        const coord_t x = clampCoordinate(center[0] + offsetDistribution(generator), m_maxCoord);
+        const coord_t y = clampCoordinate(center[1] + offsetDistribution(generator), m_maxCoord);
+        const coord_t z = clampCoordinate(center[2] + offsetDistribution(generator), m_maxCoord);
+        consumer(Vector3i(x, y, z));
+    }
+}
+
+PlaneGenerator::PlaneGenerator(coord_t maxCoord, double slopeX, double slopeY, double offset, coord_t thickness)
+    : m_maxCoord(maxCoord), m_slopeX(slopeX), m_slopeY(slopeY), m_offset(offset), m_thickness(std::max(thickness, 1)) {
+}
+
+std::string PlaneGenerator::name() const {
+    std::stringstream s;
+    s << "plane(maxCoord=" << m_maxCoord << ", slopeX=" << m_slopeX << ", slopeY=" << m_slopeY << ", offset=" << m_offset << ", thickness=" << m_thickness << ")";
+    return s.str();
+}
+
+Vector3i PlaneGenerator::maxXYZ() const {
+    return Vector3i(m_maxCoord);
+}
+
+size_t PlaneGenerator::numLeafsHint() const {
+    const size_t sideLength = static_cast<size_t>(m_maxCoord) + 1;
+    return sideLength * sideLength * static_cast<size_t>(m_thickness);
+}
+
+void PlaneGenerator::generate(const LeafConsumer& consumer) const {
+    for (coord_t x = 0; x <= m_maxCoord; x++) {
+        for (coord_t y = 0; y <= m_maxCoord; y++) {
+            const double planeZ = std::floor(m_slopeX * x + m_slopeY * y + m_offset);
+            if (planeZ < -static_cast<double>(m_thickness) || planeZ > static_cast<double>(m_maxCoord)) {
+                continue;
+            }
+
+            const coord_t firstZ = static_cast<coord_t>(planeZ);
+            for (coord_t z = std::max(firstZ, 0); z < firstZ + m_thickness && z <= m_maxCoord; z++) {
+                consumer(Vector3i(x, y, z));
+            }
+        }
+    }
+}
+
+LinesGenerator::LinesGenerator(coord_t maxCoord, size_t numLines, size_t seed) : m_maxCoord(maxCoord), m_numLines(numLines), m_seed(seed) {
+}
+
+std::string LinesGenerator::name() const {
+    std::stringstream s;
+    s << "lines(maxCoord=" << m_maxCoord << ", numLines=" << m_numLines << ")";
+    return s.str();
+}
+
+Vector3i LinesGenerator::maxXYZ() const {
+    return Vector3i(m_maxCoord);
+}
+
+size_t LinesGenerator::numLeafsHint() const {
+    // the average length of a line (in voxels along its major axis) is roughly 2/3 of the side length
+    return m_numLines * ((2 * static_cast<size_t>(m_maxCoord)) / 3 + 1);
+}
+
+void LinesGenerator::generate(const LeafConsumer& consumer) const {
+    std::default_random_engine generator(m_seed);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, m_maxCoord);
+
+    for (size_t l = 0; l < m_numLines; l++) {
+        std::array<coord_t, 3> start;
+        std::array<coord_t, 3> end;
+        for (size_t i = 0; i < 3; i++) {
+            start[i] = coordinateDistribution(generator);
+            end[i] = coordinateDistribution(generator);
+        }
+
+        coord_t numSteps = 0;
+        for (size_t i = 0; i < 3; i++) {
+            numSteps = std::max(numSteps, std::abs(end[i] - start[i]));
+        }
+
+        for (coord_t step = 0; step <= numSteps; step++) {
+            const double t = numSteps > 0 ? static_cast<double>(step) / numSteps : 0.0;
+            std::array<coord_t, 3> voxel;
+            for (size_t i = 0; i < 3; i++) {
+                voxel[i] = clampCoordinate(start[i] + t * (end[i] - start[i]), m_maxCoord);
+            }
+            consumer(Vector3i(voxel[0], voxel[1], voxel[2]));
+        }
+    }
+}
+
+MengerSpongeGenerator::MengerSpongeGenerator(unsigned int iterations)
+    : m_iterations(iterations), m_sideLength(static_cast<coord_t>(power(3, iterations))) {
+}
+
+std::string MengerSpongeGenerator::name() const {
+    std::stringstream s;
+    s << "mengerSponge(iterations=" << m_iterations << ")";
+    return s.str();
+}
+
+Vector3i MengerSpongeGenerator::maxXYZ() const {
+    return Vector3i(m_sideLength - 1);
+}
+
+size_t MengerSpongeGenerator::numLeafsHint() const {
+    return power(20, m_iterations);
+}
+
+void MengerSpongeGenerator::generate(const LeafConsumer& consumer) const {
+    for (coord_t x = 0; x < m_sideLength; x++) {
+        for (coord_t y = 0; y < m_sideLength; y++) {
+            for (coord_t z = 0; z < m_sideLength; z++) {
+                // A voxel is removed if at any iteration (base 3 digit) at least two of its coordinates are in the middle third
+                bool removed = false;
+                for (coord_t dx = x, dy = y, dz = z; !removed && (dx > 0 || dy > 0 || dz > 0); dx /= 3, dy /= 3, dz /= 3) {
+                    removed = (dx % 3 == 1) + (dy % 3 == 1) + (dz % 3 == 1) >= 2;
+                }
+
+                if (!removed) {
+                    consumer(Vector3i(x, y, z));
+                }
+            }
+        }
+    }
+}
+
+SierpinskiTetrahedronGenerator::SierpinskiTetrahedronGenerator(unsigned int iterations)
+    : m_iterations(iterations), m_sideLength(static_cast<coord_t>(power(2, iterations))) {
+}
+
+std::string SierpinskiTetrahedronGenerator::name() const {
+    std::stringstream s;
+    s << "sierpinskiTetrahedron(iterations=" << m_iterations << ")";
+    return s.str();
+}
+
+Vector3i SierpinskiTetrahedronGenerator::maxXYZ() const {
+    return Vector3i(m_sideLength - 1);
+}
+
+size_t SierpinskiTetrahedronGenerator::numLeafsHint() const {
+    return power(4, m_iterations);
+}
+
+void SierpinskiTetrahedronGenerator::generate(const LeafConsumer& consumer) const {
+    for (coord_t x = 0; x < m_sideLength; x++) {
+        for (coord_t y = 0; y < m_sideLength; y++) {
+            if ((x & y) != 0) {
+                continue;
+            }
+
+            for (coord_t z = 0; z < m_sideLength; z++) {
+                if ((x & z) == 0 && (y & z) == 0) {
+                    consumer(Vector3i(x, y, z));
+                }
+            }
+        }
+    }
+}
+
+IsolatedDeepLeafGenerator::IsolatedDeepLeafGenerator(coord_t maxCoord, const Vector3i& leaf) : m_maxCoord(maxCoord), m_leaf(leaf) {
+}
+
+std::string IsolatedDeepLeafGenerator::name() const {
+    std::stringstream s;
+    s << "isolatedDeepLeaf(maxCoord=" << m_maxCoord << ", leaf=" << m_leaf << ")";
+    return s.str();
+}
+
+Vector3i IsolatedDeepLeafGenerator::maxXYZ() const {
+    return Vector3i(m_maxCoord);
+}
+
+size_t IsolatedDeepLeafGenerator::numLeafsHint() const {
+    return 1;
+}
+
+void IsolatedDeepLeafGenerator::generate(const LeafConsumer& consumer) const {
+    consumer(m_leaf);
+}
+
+RippleGenerator::RippleGenerator(coord_t maxCoord, coord_t spacing) : m_maxCoord(maxCoord), m_spacing(std::max(spacing, 1)) {
+}
+
+std::string RippleGenerator::name() const {
+    std::stringstream s;
+    s << "ripple(maxCoord=" << m_maxCoord << ", spacing=" << m_spacing << ")";
+    return s.str();
+}
+
+Vector3i RippleGenerator::maxXYZ() const {
+    return Vector3i(m_maxCoord);
+}
+
+size_t RippleGenerator::numLeafsHint() const {
+    const size_t numPerAxis = static_cast<size_t>(m_maxCoord / m_spacing) + 1;
+    return 3 * numPerAxis * numPerAxis;
+}
+
+void RippleGenerator::generate(const LeafConsumer& consumer) const {
+    const coord_t belowCenter = (m_maxCoord + 1) / 2 - 1;
+
+    for (coord_t u = 0; u <= m_maxCoord; u += m_spacing) {
+        for (coord_t v = 0; v <= m_maxCoord; v += m_spacing) {
+            consumer(Vector3i(belowCenter, u, v));
+            consumer(Vector3i(u, belowCenter, v));
+            consumer(Vector3i(u, v, belowCenter));
+        }
+    }
+}
+}
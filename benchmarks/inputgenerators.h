@@ -0,0 +1,191 @@
+#pragma once
+
+#include <octreebuilder/vector3i.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Generators of level zero leafs for benchmarks
+ *
+ * The generators stream the leafs to a consumer (instead of storing them), hence they can be used for very large inputs.
+ * The same leaf might be generated more than once. All generators are deterministic (for a given seed).
+ */
+namespace octreebuilder {
+
+typedef std::function<void(const Vector3i&)> LeafConsumer;
+
+class InputGenerator {
+public:
+    virtual ~InputGenerator();
+
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief The maximum coordinate of all generated leafs (the bounds of the octree)
+     */
+    virtual Vector3i maxXYZ() const = 0;
+
+    /**
+     * @brief The approximate number of leafs that are generated
+     */
+    virtual size_t numLeafsHint() const = 0;
+
+    virtual void generate(const LeafConsumer& consumer) const = 0;
+};
+
+/**
+ * @brief Leafs uniformly distributed in the cube [0, maxCoord]^3
+ */
+class UniformGenerator : public InputGenerator {
+public:
+    UniformGenerator(coord_t maxCoord, size_t numLeafs, size_t seed);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    coord_t m_maxCoord;
+    size_t m_numLeafs;
+    size_t m_seed;
+};
+
+/**
+ * @brief Leafs that are normally distributed around randomly placed cluster centers
+ *
+ * Leafs outside of the cube [0, maxCoord]^3 are clamped to its surface.
+ */
+class GaussianClustersGenerator : public InputGenerator {
+public:
+    GaussianClustersGenerator(coord_t maxCoord, size_t numClusters, size_t numLeafs, double standardDeviation, size_t seed);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    coord_t m_maxCoord;
+    size_t m_numClusters;
+    size_t m_numLeafs;
+    double m_standardDeviation;
+    size_t m_seed;
+};
+
+/**
+ * @brief A tilted plane z = slopeX * x + slopeY * y + offset with the given thickness (in voxels) through the cube [0, maxCoord]^3
+ */
+class PlaneGenerator : public InputGenerator {
+public:
+    PlaneGenerator(coord_t maxCoord, double slopeX, double slopeY, double offset, coord_t thickness);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    coord_t m_maxCoord;
+    double m_slopeX;
+    double m_slopeY;
+    double m_offset;
+    coord_t m_thickness;
+};
+
+/**
+ * @brief Rasterized line segments between random points of the cube [0, maxCoord]^3
+ */
+class LinesGenerator : public InputGenerator {
+public:
+    LinesGenerator(coord_t maxCoord, size_t numLines, size_t seed);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    coord_t m_maxCoord;
+    size_t m_numLines;
+    size_t m_seed;
+};
+
+/**
+ * @brief The voxels of a Menger sponge of the given iteration (the cube has a side length of 3^iterations)
+ */
+class MengerSpongeGenerator : public InputGenerator {
+public:
+    explicit MengerSpongeGenerator(unsigned int iterations);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    unsigned int m_iterations;
+    coord_t m_sideLength;
+};
+
+/**
+ * @brief The voxels of a Sierpinski tetrahedron of the given iteration (the cube has a side length of 2^iterations)
+ *
+ * A voxel is part of the tetrahedron if no two of its coordinates have a common bit.
+ */
+class SierpinskiTetrahedronGenerator : public InputGenerator {
+public:
+    explicit SierpinskiTetrahedronGenerator(unsigned int iterations);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    unsigned int m_iterations;
+    coord_t m_sideLength;
+};
+
+/**
+ * @brief A single leaf in a huge domain
+ *
+ * The balanced octree must refine all levels from the root down to the leaf.
+ */
+class IsolatedDeepLeafGenerator : public InputGenerator {
+public:
+    IsolatedDeepLeafGenerator(coord_t maxCoord, const Vector3i& leaf);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    coord_t m_maxCoord;
+    Vector3i m_leaf;
+};
+
+/**
+ * @brief Leafs directly below the planes x = y = z = (maxCoord + 1) / 2, that separate the octants of the root
+ *
+ * The leafs are placed on a grid with the given spacing (in voxels). The octants on the other side of the planes are
+ * coarse and must be split over many levels to balance the tree (the refinement ripples through the levels).
+ * In case of the parallel builder these octants are boundary octants of the blocks.
+ */
+class RippleGenerator : public InputGenerator {
+public:
+    RippleGenerator(coord_t maxCoord, coord_t spacing);
+
+    virtual std::string name() const override;
+    virtual Vector3i maxXYZ() const override;
+    virtual size_t numLeafsHint() const override;
+    virtual void generate(const LeafConsumer& consumer) const override;
+
+private:
+    coord_t m_maxCoord;
+    coord_t m_spacing;
+};
+}
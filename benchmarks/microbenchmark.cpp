@@ -0,0 +1,251 @@
+#include <octreebuilder/mortoncode_utils.h>
+#include <octreebuilder/octantid.h>
+#include <octreebuilder/linearoctree.h>
+#include <octreebuilder/octree_utils.h>
+#include <octreebuilder/paralleloctreebuilder.h>
+
+#include "inputgenerators.h"
+#include "benchmarkreport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace octreebuilder;
+
+/*
+ * Microbenchmarks of the morton code and OctantID primitives.
+ *
+ * Each primitive is applied once to every key of a fixed (seeded) key set, the fastest of all repetitions is reported in ns per operation.
+ * The key sets are:
+ *  - uniform: level zero leafs uniformly distributed in the space of all valid morton codes
+ *  - tree: the octants of a balanced octree of gaussian clusters (all levels, realistic neighbourhoods)
+ *  - points: float points uniformly distributed in a unit cube (quantized to 1024^3 leafs)
+ */
+
+constexpr size_t SEED = 4711;
+constexpr uint MORTON_CODE_DEPTH = 21;  // each component of a morton code has 21 bits
+constexpr size_t NUM_UNIFORM_KEYS = 1000000;
+constexpr coord_t TREE_MAX_COORD = 1023;
+constexpr size_t TREE_NUM_CLUSTERS = 16;
+constexpr size_t TREE_NUM_LEAFS = 20000;
+constexpr double TREE_CLUSTER_STANDARD_DEVIATION = 20.0;
+constexpr size_t NUM_POINTS = 10000000;
+
+// Results are accumulated here, so that the compiler can't remove the measured operations
+static volatile morton_t g_sink;
+
+struct KeySets {
+    std::vector<Vector3i> uniformCoordinates;
+    std::vector<morton_t> uniformMortonCodes;
+    std::vector<OctantID> uniformLevelZeroOctants;
+
+    LinearOctree tree;
+    std::vector<OctantID> treeOctants;
+    std::vector<OctantID> treeInnerOctants;
+
+    std::vector<float> points;
+};
+
+static KeySets createKeySets() {
+    KeySets keys;
+
+    const coord_t maxCoord = getMaxXYZForOctreeDepth(MORTON_CODE_DEPTH).x();
+    std::default_random_engine generator(SEED);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+
+    keys.uniformCoordinates.reserve(NUM_UNIFORM_KEYS);
+    keys.uniformMortonCodes.reserve(NUM_UNIFORM_KEYS);
+    keys.uniformLevelZeroOctants.reserve(NUM_UNIFORM_KEYS);
+    for (size_t i = 0; i < NUM_UNIFORM_KEYS; i++) {
+        const coord_t x = coordinateDistribution(generator);
+        const coord_t y = coordinateDistribution(generator);
+        const coord_t z = coordinateDistribution(generator);
+        const Vector3i coordinate(x, y, z);
+
+        keys.uniformCoordinates.push_back(coordinate);
+        keys.uniformMortonCodes.push_back(getMortonCodeForCoordinate(coordinate));
+    }
+
+    const GaussianClustersGenerator clusters(TREE_MAX_COORD, TREE_NUM_CLUSTERS, TREE_NUM_LEAFS, TREE_CLUSTER_STANDARD_DEVIATION, SEED);
+
+    std::unordered_set<morton_t> uniqueLeafs;
+    clusters.generate([&uniqueLeafs](const Vector3i& leaf) { uniqueLeafs.insert(getMortonCodeForCoordinate(leaf)); });
+
+    std::vector<OctantID> levelZeroLeafs;
+    levelZeroLeafs.reserve(uniqueLeafs.size());
+    for (const morton_t& mcode : uniqueLeafs) {
+        levelZeroLeafs.push_back(OctantID(mcode, 0));
+    }
+    std::sort(levelZeroLeafs.begin(), levelZeroLeafs.end());
+
+    keys.tree = createBalancedSubtree(OctantID(0, getOctreeDepthForBounding(clusters.maxXYZ())), levelZeroLeafs);
+    keys.treeOctants.assign(keys.tree.leafs().begin(), keys.tree.leafs().end());
+
+    for (const OctantID& octant : keys.treeOctants) {
+        if (octant.level() < keys.tree.depth()) {
+            keys.treeInnerOctants.push_back(octant.parent());
+        }
+    }
+
+    // siblings have the same parent... each inner octant is queried once
+    std::sort(keys.treeInnerOctants.begin(), keys.treeInnerOctants.end());
+    keys.treeInnerOctants.erase(std::unique(keys.treeInnerOctants.begin(), keys.treeInnerOctants.end()), keys.treeInnerOctants.end());
+
+    // queries for maximumLowerBound are level zero octants inside of the tree
+    std::uniform_int_distribution<coord_t> treeCoordinateDistribution(0, TREE_MAX_COORD);
+    for (size_t i = 0; i < NUM_UNIFORM_KEYS; i++) {
+        const coord_t x = treeCoordinateDistribution(generator);
+        const coord_t y = treeCoordinateDistribution(generator);
+        const coord_t z = treeCoordinateDistribution(generator);
+        keys.uniformLevelZeroOctants.push_back(OctantID(Vector3i(x, y, z), 0));
+    }
+
+    std::uniform_real_distribution<float> pointDistribution(0.0f, 1.0f);
+    keys.points.reserve(3 * NUM_POINTS);
+    for (size_t i = 0; i < 3 * NUM_POINTS; i++) {
+        keys.points.push_back(pointDistribution(generator));
+    }
+
+    return keys;
+}
+
+/**
+ * @brief Runs the benchmark (which executes numOps operations) repetitions times and prints the fastest time per operation
+ *
+ * The time per operation of every repetition is added to the report.
+ */
+template <typename Benchmark>
+static void measure(const std::string& primitive, const std::string& keySet, const size_t numOps, const size_t repetitions, BenchmarkReport& report,
+                    const Benchmark& benchmark) {
+    BenchmarkResult result(primitive + "/" + keySet, "ns/op");
+
+    for (size_t r = 0; r < repetitions; r++) {
+        const auto start = std::chrono::high_resolution_clock::now();
+        g_sink = g_sink + benchmark();
+        const auto time = std::chrono::high_resolution_clock::now() - start;
+        result.samples.push_back(std::chrono::duration<double, std::nano>(time).count() / static_cast<double>(std::max<size_t>(numOps, 1)));
+    }
+
+    const double nsPerOp = result.min();
+    report.add(result);
+
+    std::cout << std::left << std::setw(46) << primitive << std::setw(10) << keySet << std::setw(12) << numOps << std::fixed << std::setprecision(2) << nsPerOp
+              << std::endl;
+}
+
+static void runBenchmarks(const KeySets& keys, const size_t repetitions, BenchmarkReport& report) {
+    std::cout << std::left << std::setw(46) << "primitive" << std::setw(10) << "keys" << std::setw(12) << "ops"
+              << "ns/op" << '\n';
+
+    measure("getMortonCodeForCoordinate", "uniform", keys.uniformCoordinates.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const Vector3i& coordinate : keys.uniformCoordinates) {
+            sum += getMortonCodeForCoordinate(coordinate);
+        }
+        return sum;
+    });
+
+    measure("getCoordinateForMortonCode", "uniform", keys.uniformMortonCodes.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const morton_t& mcode : keys.uniformMortonCodes) {
+            sum += static_cast<morton_t>(getCoordinateForMortonCode(mcode).x());
+        }
+        return sum;
+    });
+
+    measure("getMortonCodeForCoordinate", "tree", keys.treeOctants.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const OctantID& octant : keys.treeOctants) {
+            sum += getMortonCodeForCoordinate(octant.coord());
+        }
+        return sum;
+    });
+
+    measure("getCoordinateForMortonCode", "tree", keys.treeOctants.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const OctantID& octant : keys.treeOctants) {
+            sum += static_cast<morton_t>(getCoordinateForMortonCode(octant.mcode()).x());
+        }
+        return sum;
+    });
+
+    measure("nearestCommonAncestor", "tree", keys.treeOctants.size() - 1, repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (size_t i = 0; i + 1 < keys.treeOctants.size(); i++) {
+            sum += nearestCommonAncestor(keys.treeOctants[i], keys.treeOctants[i + 1]).mcode();
+        }
+        return sum;
+    });
+
+    measure("OctantID::children", "tree", keys.treeInnerOctants.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const OctantID& octant : keys.treeInnerOctants) {
+            sum += octant.children().back().mcode();
+        }
+        return sum;
+    });
+
+    measure("OctantID::potentialNeighbours", "tree", keys.treeOctants.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const OctantID& octant : keys.treeOctants) {
+            sum += octant.potentialNeighbours(keys.tree).size();
+        }
+        return sum;
+    });
+
+    measure("OctantID::getSearchKeys", "tree", keys.treeOctants.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        for (const OctantID& octant : keys.treeOctants) {
+            sum += octant.getSearchKeys(keys.tree).size();
+        }
+        return sum;
+    });
+
+    measure("LinearOctree::maximumLowerBound", "uniform", keys.uniformLevelZeroOctants.size(), repetitions, report, [&keys]() {
+        morton_t sum = 0;
+        OctantID lowerBound;
+        for (const OctantID& octant : keys.uniformLevelZeroOctants) {
+            if (keys.tree.maximumLowerBound(octant, lowerBound)) {
+                sum += lowerBound.mcode();
+            }
+        }
+        return sum;
+    });
+
+    // quantization, encoding, sorting and deduplication of all points (with all threads)
+    measure("OctreeBuilder::addLevelZeroLeafsFromPoints", "points", NUM_POINTS, repetitions, report, [&keys]() {
+        const PointQuantization quantization({0, 0, 0}, {1, 1, 1}, 1.0 / 1024);
+        ParallelOctreeBuilder builder(Vector3i(1023));
+        return static_cast<morton_t>(builder.addLevelZeroLeafsFromPoints(keys.points.data(), NUM_POINTS, quantization));
+    });
+}
+
+int main(int argc, char* argv[]) {
+    size_t repetitions = 5;
+    ReportOptions reportOptions;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--repetitions" && i + 1 < argc) {
+            repetitions = std::max(std::strtoul(argv[++i], nullptr, 10), 1ul);
+        } else if (!parseReportOption(argc, argv, i, reportOptions)) {
+            std::cerr << "Usage: " << argv[0] << " [--repetitions N] [report options]\n" << reportOptionsUsage() << std::flush;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const KeySets keys = createKeySets();
+    std::cout << "uniform keys: " << keys.uniformCoordinates.size() << ", tree octants: " << keys.treeOctants.size() << " (depth " << keys.tree.depth()
+              << ")\n\n";
+
+    BenchmarkReport report("microbenchmark");
+    runBenchmarks(keys, repetitions, report);
+
+    return report.finish(reportOptions);
+}
@@ -5,9 +5,20 @@
 #include <octreebuilder/octree.h>
 #include <octreebuilder/box.h>
 #include <octreebuilder/vector_utils.h>
+#include <octreebuilder/hardwarecounters.h>
 
+#include "inputgenerators.h"
+#include "benchmarkreport.h"
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <string>
 #include <vector>
 #include <random>
+#include <functional>
+#include <iostream>
 
 #ifdef PROFILING_ENABLED
 #include <gperftools/profiler.h>
@@ -34,6 +45,18 @@ constexpr coord_t SPHERE_OUTER_SQUARED_SURFACE_DISTANCE = squared(SPHERE_RADIUS
 
 static_assert(SPHERE_OUTER_SQUARED_SURFACE_DISTANCE > SPHERE_INNER_SQUARED_SURFACE_DISTANCE, "Sphere surface to thin.");
 
+// Input distributions with different clustering and balancing (ripple) behaviour
+const GaussianClustersGenerator GAUSSIAN_CLUSTERS(MAX_COORD, 8, NUM_INPUT_LEAFS, 20.0, SEED);
+const PlaneGenerator THIN_PLANE(127, 0.3, 0.2, 20.0, 1);
+const LinesGenerator THIN_LINES(MAX_COORD, 16, SEED);
+const MengerSpongeGenerator MENGER_SPONGE(3);
+const SierpinskiTetrahedronGenerator SIERPINSKI_TETRAHEDRON(7);
+const IsolatedDeepLeafGenerator ISOLATED_DEEP_LEAF((1 << 20) - 1, Vector3i((1 << 19) + 1));
+const RippleGenerator RIPPLE(1023, 64);
+
+const std::vector<const InputGenerator*> INPUT_DISTRIBUTIONS = {&GAUSSIAN_CLUSTERS, &THIN_PLANE, &THIN_LINES, &MENGER_SPONGE, &SIERPINSKI_TETRAHEDRON,
+                                                                &ISOLATED_DEEP_LEAF, &RIPPLE};
+
 class OctreeBuilderBenchmark : public hayai::Fixture {
 public:
     OctreeBuilderBenchmark() {
@@ -61,6 +84,11 @@ public:
             }
         }
 
+        // Generate the inputs before the measurement starts
+        for (const InputGenerator* input : INPUT_DISTRIBUTIONS) {
+            getLeafs(*input);
+        }
+
 #ifdef PROFILING_ENABLED
         ProfilerStart("OctreeBuilderBenchmark.prof");
 #endif
@@ -80,39 +108,249 @@ public:
 #endif
     }
 
+    virtual void SetUp() override {
+        m_iterationCounters.clear();
+    }
+
+    virtual void TearDown() override {
+        // Print the hardware counters after the run... so that the output doesn't distort the measured time
+        for (size_t i = 0; i < m_iterationCounters.size(); i++) {
+            std::cout << "           Iteration " << i << " hardware counters: " << m_iterationCounters[i] << std::endl;
+        }
+    }
+
+protected:
+    /**
+     * @brief Starts measuring the hardware counters of a benchmark iteration
+     */
+    void startIteration() {
+        m_iterationStartCounters = m_hardwareCounters.read();
+    }
+
+    /**
+     * @brief Stops measuring the hardware counters of a benchmark iteration
+     */
+    void stopIteration() {
+        m_iterationCounters.push_back(difference(m_hardwareCounters.read(), m_iterationStartCounters));
+    }
+
+    /**
+     * @brief Builds an octree of the leafs of the input distribution (one benchmark iteration)
+     */
+    template <typename Builder>
+    void buildOctree(const InputGenerator& input) {
+        const std::vector<Vector3i>& leafs = getLeafs(input);
+
+        startIteration();
+        Builder builder(input.maxXYZ(), leafs.size());
+        for (const Vector3i& leaf : leafs) {
+            builder.addLevelZeroLeaf(leaf);
+        }
+        builder.finishBuilding();
+        stopIteration();
+    }
+
 private:
+    /**
+     * @brief The leafs of the input distribution (generated once per process)
+     */
+    static const std::vector<Vector3i>& getLeafs(const InputGenerator& input) {
+        static std::map<std::string, std::vector<Vector3i>> generatedLeafs;
+
+        const std::string name = input.name();
+        auto it = generatedLeafs.find(name);
+        if (it == generatedLeafs.end()) {
+            std::vector<Vector3i> leafs;
+            leafs.reserve(input.numLeafsHint());
+            input.generate([&leafs](const Vector3i& leaf) { leafs.push_back(leaf); });
+            it = generatedLeafs.insert(std::make_pair(name, std::move(leafs))).first;
+        }
+        return it->second;
+    }
+
+    HardwareCounters m_hardwareCounters;
+    HardwareCounterValues m_iterationStartCounters;
+    std::vector<HardwareCounterValues> m_iterationCounters;
     std::vector<Vector3i> m_uniformDistributedInputLeafs;
     std::vector<Vector3i> m_sphereSurfaceLeafs;
 };
 
 BENCHMARK_F(OctreeBuilderBenchmark, uniformDistributionBalancedSequentialOctreeBuilder, 5, 2) {
+    startIteration();
     SequentialOctreeBuilder builder(MAX_XYZ, NUM_INPUT_LEAFS);
     for (const Vector3i& leaf : getUniformDistributedInputLeafs()) {
         builder.addLevelZeroLeaf(leaf);
     }
     builder.finishBuilding();
+    stopIteration();
 }
 
 BENCHMARK_F(OctreeBuilderBenchmark, uniformDistributionBalancedParallelOctreeBuilder, 5, 2) {
+    startIteration();
     ParallelOctreeBuilder builder(MAX_XYZ, NUM_INPUT_LEAFS);
     for (const Vector3i& leaf : getUniformDistributedInputLeafs()) {
         builder.addLevelZeroLeaf(leaf);
     }
     builder.finishBuilding();
+    stopIteration();
 }
 
 BENCHMARK_F(OctreeBuilderBenchmark, sphereSurfaceLeafsBalancedSequentialOctreeBuilder, 5, 2) {
+    startIteration();
     SequentialOctreeBuilder builder(SPHERE_MAX_XYZ, getSphereSurfaceLeafs().size());
     for (const Vector3i& leaf : getSphereSurfaceLeafs()) {
         builder.addLevelZeroLeaf(leaf);
     }
     builder.finishBuilding();
+    stopIteration();
 }
 
 BENCHMARK_F(OctreeBuilderBenchmark, sphereSurfaceLeafsBalancedParallelOctreeBuilder, 5, 2) {
+    startIteration();
     ParallelOctreeBuilder builder(SPHERE_MAX_XYZ, getSphereSurfaceLeafs().size());
     for (const Vector3i& leaf : getSphereSurfaceLeafs()) {
         builder.addLevelZeroLeaf(leaf);
     }
     builder.finishBuilding();
+    stopIteration();
+}
+
+/**
+ * @brief The signed distance function of the sphere of the sphere benchmarks (the leafs closer than SPHERE_HALF_SURFACE_THICKNESS are the same)
+ */
+static double sphereSignedDistance(const std::array<double, 3>& p) {
+    const Vector3i center = SPHERE_BB.llf() + Vector3i(SPHERE_RADIUS);
+    const double dx = p[0] - static_cast<double>(center.x());
+    const double dy = p[1] - static_cast<double>(center.y());
+    const double dz = p[2] - static_cast<double>(center.z());
+
+    return std::sqrt(dx * dx + dy * dy + dz * dz) - static_cast<double>(SPHERE_RADIUS);
+}
+
+// Seeding from the signed distance function is part of the measurement (instead of testing every leaf of SPHERE_BB in advance)
+BENCHMARK_F(OctreeBuilderBenchmark, sphereSignedDistanceBalancedSequentialOctreeBuilder, 5, 2) {
+    startIteration();
+    SequentialOctreeBuilder builder(SPHERE_MAX_XYZ);
+    builder.addLevelZeroLeafsFromSignedDistance(sphereSignedDistance, 1.0, static_cast<double>(SPHERE_HALF_SURFACE_THICKNESS));
+    builder.finishBuilding();
+    stopIteration();
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, sphereSignedDistanceBalancedParallelOctreeBuilder, 5, 2) {
+    startIteration();
+    ParallelOctreeBuilder builder(SPHERE_MAX_XYZ);
+    builder.addLevelZeroLeafsFromSignedDistance(sphereSignedDistance, 1.0, static_cast<double>(SPHERE_HALF_SURFACE_THICKNESS));
+    builder.finishBuilding();
+    stopIteration();
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, gaussianClustersBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(GAUSSIAN_CLUSTERS);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, gaussianClustersBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(GAUSSIAN_CLUSTERS);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, thinPlaneBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(THIN_PLANE);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, thinPlaneBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(THIN_PLANE);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, thinLinesBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(THIN_LINES);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, thinLinesBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(THIN_LINES);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, mengerSpongeBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(MENGER_SPONGE);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, mengerSpongeBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(MENGER_SPONGE);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, sierpinskiTetrahedronBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(SIERPINSKI_TETRAHEDRON);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, sierpinskiTetrahedronBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(SIERPINSKI_TETRAHEDRON);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, isolatedDeepLeafBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(ISOLATED_DEEP_LEAF);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, isolatedDeepLeafBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(ISOLATED_DEEP_LEAF);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, rippleBalancedSequentialOctreeBuilder, 5, 2) {
+    buildOctree<SequentialOctreeBuilder>(RIPPLE);
+}
+
+BENCHMARK_F(OctreeBuilderBenchmark, rippleBalancedParallelOctreeBuilder, 5, 2) {
+    buildOctree<ParallelOctreeBuilder>(RIPPLE);
+}
+
+/**
+ * @brief Adds the results of the hayai benchmarks to a report (one sample per run, in ms per iteration)
+ */
+class BenchmarkReportOutputter : public hayai::Outputter {
+public:
+    explicit BenchmarkReportOutputter(BenchmarkReport& report) : m_report(report) {
+    }
+
+    virtual void Begin(const std::size_t&, const std::size_t&) override {
+    }
+
+    virtual void End(const std::size_t&, const std::size_t&) override {
+    }
+
+    virtual void BeginTest(const std::string&, const std::string&, const hayai::TestParametersDescriptor&, const std::size_t&, const std::size_t&) override {
+    }
+
+    virtual void SkipDisabledTest(const std::string&, const std::string&, const hayai::TestParametersDescriptor&, const std::size_t&,
+                                  const std::size_t&) override {
+    }
+
+    virtual void EndTest(const std::string& fixtureName, const std::string& testName, const hayai::TestParametersDescriptor&,
+                         const hayai::TestResult& result) override {
+        BenchmarkResult benchmarkResult(fixtureName + "." + testName, "ms");
+        for (const uint64_t runTime : result.RunTimes()) {
+            // hayai measures the run times in ns
+            benchmarkResult.samples.push_back(static_cast<double>(runTime) / static_cast<double>(result.IterationsCount()) / 1e6);
+        }
+        m_report.add(benchmarkResult);
+    }
+
+private:
+    BenchmarkReport& m_report;
+};
+
+int main(int argc, char* argv[]) {
+    ReportOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (!parseReportOption(argc, argv, i, options)) {
+            std::cerr << "Usage: " << argv[0] << " [report options]\n" << reportOptionsUsage() << std::flush;
+            return EXIT_FAILURE;
+        }
+    }
+
+    BenchmarkReport report("benchmarks");
+
+    hayai::ConsoleOutputter consoleOutputter;
+    BenchmarkReportOutputter reportOutputter(report);
+    hayai::Benchmarker::AddOutputter(consoleOutputter);
+    hayai::Benchmarker::AddOutputter(reportOutputter);
+    hayai::Benchmarker::RunAllTests();
+
+    return report.finish(options);
 }
@@ -0,0 +1,239 @@
+#include <octreebuilder/paralleloctreebuilder.h>
+#include <octreebuilder/octree.h>
+#include <octreebuilder/octreenode.h>
+
+#include "inputgenerators.h"
+#include "benchmarkreport.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace octreebuilder;
+
+/*
+ * Benchmarks of the queries on built octrees (single and multi threaded).
+ *
+ * The trees are built once. Each query is executed for all nodes of a tree (or a fixed set of random queries),
+ * the fastest of all repetitions is reported in ns per query and million queries per second.
+ * The lookup structure of the octree is built lazily by the first tryGetNodeAt, its cost is reported separately.
+ */
+
+constexpr size_t SEED = 8231;
+constexpr size_t NUM_RANDOM_QUERIES = 1000000;
+
+struct Options {
+    Options() : maxThreads(omp_get_max_threads()), repetitions(3) {
+    }
+
+    int maxThreads;
+    size_t repetitions;
+    ReportOptions report;
+};
+
+struct Tree {
+    std::string name;
+    std::unique_ptr<Octree> octree;
+
+    // random llf and level pairs (most of them are not a node of the tree)
+    std::vector<std::pair<Vector3i, uint>> randomQueries;
+};
+
+static Tree buildTree(const InputGenerator& input) {
+    Tree tree;
+    tree.name = input.name();
+
+    ParallelOctreeBuilder builder(input.maxXYZ(), input.numLeafsHint());
+    input.generate([&builder](const Vector3i& leaf) { builder.addLevelZeroLeaf(leaf); });
+    tree.octree = builder.finishBuilding();
+
+    std::default_random_engine generator(SEED);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, tree.octree->getMaxXYZ().x());
+    std::uniform_int_distribution<uint> levelDistribution(0, tree.octree->getMaxLevel());
+
+    tree.randomQueries.reserve(NUM_RANDOM_QUERIES);
+    for (size_t i = 0; i < NUM_RANDOM_QUERIES; i++) {
+        const uint level = levelDistribution(generator);
+        const coord_t x = coordinateDistribution(generator);
+        const coord_t y = coordinateDistribution(generator);
+        const coord_t z = coordinateDistribution(generator);
+
+        // align the llf to the level, so that the query is a valid octant
+        const coord_t mask = ~((coord_t(1) << level) - 1);
+        tree.randomQueries.push_back(std::make_pair(Vector3i(x & mask, y & mask, z & mask), level));
+    }
+
+    return tree;
+}
+
+static std::vector<int> threadCounts(const int maxThreads) {
+    std::vector<int> result;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        result.push_back(t);
+    }
+    result.push_back(maxThreads);
+    return result;
+}
+
+static BenchmarkResult createResult(const Tree& tree, const std::string& query, const int numThreads) {
+    return BenchmarkResult(tree.name + "/" + query + "/threads=" + std::to_string(numThreads), "ns/query");
+}
+
+static double nsPerQuery(const size_t numQueries, const std::chrono::high_resolution_clock::duration& time) {
+    return std::chrono::duration<double, std::nano>(time).count() / static_cast<double>(std::max<size_t>(numQueries, 1));
+}
+
+static void printRow(const std::string& query, const int numThreads, const size_t numQueries, const std::chrono::high_resolution_clock::duration& time) {
+    const double ns = std::chrono::duration<double, std::nano>(time).count();
+    const double millionQueriesPerSecond = ns > 0.0 ? static_cast<double>(numQueries) / ns * 1000.0 : 0.0;
+
+    std::cout << std::left << std::setw(36) << query << std::setw(9) << numThreads << std::setw(12) << numQueries << std::fixed << std::setprecision(2)
+              << std::setw(12) << nsPerQuery(numQueries, time) << millionQueriesPerSecond << std::endl;
+}
+
+/**
+ * @brief Executes query(i) for i in [0, numQueries) with numThreads threads and prints the fastest of all repetitions
+ *
+ * The time per query of every repetition is added to the report.
+ */
+template <typename Query>
+static void measure(const Tree& tree, const std::string& name, const size_t numQueries, const int numThreads, const Options& options, BenchmarkReport& report,
+                    const Query& query) {
+    std::chrono::high_resolution_clock::duration best = std::chrono::high_resolution_clock::duration::max();
+    BenchmarkResult result = createResult(tree, name, numThreads);
+    size_t checksum = 0;
+
+    for (size_t r = 0; r < options.repetitions; r++) {
+        size_t sum = 0;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel for num_threads(numThreads) reduction(+ : sum) schedule(static)
+        for (size_t i = 0; i < numQueries; i++) {
+            sum += query(i);
+        }
+        const auto time = std::chrono::high_resolution_clock::now() - start;
+
+        best = std::min(best, time);
+        result.samples.push_back(nsPerQuery(numQueries, time));
+        checksum += sum;
+    }
+
+    // the checksum keeps the compiler from removing the queries
+    if (checksum == std::numeric_limits<size_t>::max()) {
+        std::cout << "checksum: " << checksum << std::endl;
+    }
+
+    report.add(result);
+    printRow(name, numThreads, numQueries, best);
+}
+
+static void runBenchmarks(const Tree& tree, const Options& options, BenchmarkReport& report) {
+    const Octree& octree = *tree.octree;
+    const size_t numNodes = octree.getNumNodes();
+
+    std::cout << tree.name << ": " << numNodes << " nodes, depth " << octree.getDepth() << ", max level " << octree.getMaxLevel() << '\n';
+
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        octree.tryGetNodeAt(Vector3i(0), 0);
+        const auto time = std::chrono::high_resolution_clock::now() - start;
+        std::cout << "first tryGetNodeAt (builds the lookup structure): " << std::chrono::duration<double, std::milli>(time).count() << " ms\n";
+    }
+
+    std::cout << std::left << std::setw(36) << "query" << std::setw(9) << "threads" << std::setw(12) << "queries" << std::setw(12) << "ns/query"
+              << "Mqueries/s" << '\n';
+
+    for (const int numThreads : threadCounts(options.maxThreads)) {
+        measure(tree, "getNode", numNodes, numThreads, options, report, [&octree](const size_t i) { return static_cast<size_t>(octree.getNode(i).getLevel()); });
+
+        measure(tree, "tryGetNodeAt (existing nodes)", numNodes, numThreads, options, report, [&octree](const size_t i) {
+            const OctreeNode node = octree.getNode(i);
+            return static_cast<size_t>(octree.tryGetNodeAt(node.getLLF(), node.getLevel()).isValid());
+        });
+
+        measure(tree, "tryGetNodeAt (random octants)", tree.randomQueries.size(), numThreads, options, report, [&tree, &octree](const size_t i) {
+            const std::pair<Vector3i, uint>& query = tree.randomQueries[i];
+            return static_cast<size_t>(octree.tryGetNodeAt(query.first, query.second).isValid());
+        });
+
+        measure(tree, "getNeighbourNodes (all 6 faces)", numNodes, numThreads, options, report, [&octree](const size_t i) {
+            const OctreeNode node = octree.getNode(i);
+            size_t numNeighbours = 0;
+            for (const OctreeNode::Face& face : {OctreeNode::LEFT, OctreeNode::RIGHT, OctreeNode::FRONT, OctreeNode::BACK, OctreeNode::BOTTOM, OctreeNode::TOP}) {
+                numNeighbours += octree.getNeighbourNodes(node, face).size();
+            }
+            return numNeighbours;
+        });
+
+        measure(tree, "getAllNeighbourNodes", numNodes, numThreads, options, report,
+                [&octree](const size_t i) { return octree.getAllNeighbourNodes(octree.getNode(i)).size(); });
+    }
+
+    // checkState is parallelized internally
+    for (const int numThreads : threadCounts(options.maxThreads)) {
+        const int defaultNumThreads = omp_get_max_threads();
+        omp_set_num_threads(numThreads);
+
+        std::chrono::high_resolution_clock::duration best = std::chrono::high_resolution_clock::duration::max();
+        BenchmarkResult result = createResult(tree, "checkState (per node)", numThreads);
+        for (size_t r = 0; r < options.repetitions; r++) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            octree.checkState();
+            const auto time = std::chrono::high_resolution_clock::now() - start;
+            best = std::min(best, time);
+            result.samples.push_back(nsPerQuery(numNodes, time));
+        }
+        report.add(result);
+        printRow("checkState (per node)", numThreads, numNodes, best);
+
+        omp_set_num_threads(defaultNumThreads);
+    }
+
+    std::cout << '\n';
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--max-threads" && hasValue) {
+            options.maxThreads = std::atoi(argv[++i]);
+        } else if (arg == "--repetitions" && hasValue) {
+            options.repetitions = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!parseReportOption(argc, argv, i, options.report)) {
+            return false;
+        }
+    }
+
+    return options.maxThreads > 0 && options.repetitions > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--max-threads N] [--repetitions N] [report options]\n" << reportOptionsUsage() << std::flush;
+        return EXIT_FAILURE;
+    }
+
+    const UniformGenerator uniform(1000, 10000, SEED);
+    const GaussianClustersGenerator clusters(511, 8, 10000, 20.0, SEED);
+    const RippleGenerator ripple(511, 32);
+
+    BenchmarkReport report("querybenchmark");
+    for (const InputGenerator* input : std::vector<const InputGenerator*>{&uniform, &clusters, &ripple}) {
+        const Tree tree = buildTree(*input);
+        runBenchmarks(tree, options, report);
+    }
+
+    return report.finish(options.report);
+}
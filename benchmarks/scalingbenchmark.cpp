@@ -0,0 +1,272 @@
+#include <octreebuilder/sequentialoctreebuilder.h>
+#include <octreebuilder/paralleloctreebuilder.h>
+#include <octreebuilder/octree.h>
+#include <octreebuilder/buildstats.h>
+
+#include "benchmarkreport.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace octreebuilder;
+
+/*
+ * Strong and weak scaling of the octree builders.
+ *
+ * Strong scaling: The number of input leafs is fixed and the number of threads is increased.
+ * Weak scaling: The number of input leafs per thread is fixed and the number of threads is increased.
+ *
+ * The input leafs are uniformly distributed and generated on the fly (so that large inputs don't need to be stored).
+ * Only finishBuilding is measured, the best of all repetitions is reported.
+ */
+
+constexpr size_t SEED = 12492;
+
+// The fraction of the voxels of the domain that are level zero leafs
+constexpr double LEAF_DENSITY = 0.05;
+
+struct Options {
+    Options() : minLeafs(10000), maxLeafs(1000000), maxThreads(omp_get_max_threads()), repetitions(3), strong(true), weak(true), sequential(true) {
+    }
+
+    size_t minLeafs;
+    size_t maxLeafs;
+    int maxThreads;
+    size_t repetitions;
+    bool strong;
+    bool weak;
+    bool sequential;
+    ReportOptions report;
+};
+
+struct Measurement {
+    Measurement() : time(std::chrono::high_resolution_clock::duration::max()) {
+    }
+
+    std::chrono::high_resolution_clock::duration time;
+    BuildStats stats;
+
+    // the times (in ms) of all repetitions
+    std::vector<double> samples;
+};
+
+static double toMilliseconds(const std::chrono::high_resolution_clock::duration& time) {
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+static Vector3i maxXYZForNumLeafs(const size_t numLeafs) {
+    const double numVoxels = static_cast<double>(numLeafs) / LEAF_DENSITY;
+    return Vector3i(static_cast<coord_t>(std::ceil(std::cbrt(numVoxels))));
+}
+
+template <typename Builder>
+static Measurement measureBuild(const size_t numLeafs, const Options& options) {
+    const Vector3i maxXYZ = maxXYZForNumLeafs(numLeafs);
+
+    Measurement best;
+    for (size_t r = 0; r < options.repetitions; r++) {
+        Builder builder(maxXYZ, numLeafs);
+
+        std::default_random_engine generator(SEED);
+        std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxXYZ.x());
+        auto genCoord = std::bind(coordinateDistribution, generator);
+
+        for (size_t i = 0; i < numLeafs; i++) {
+            builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        builder.finishBuilding();
+        const auto time = std::chrono::high_resolution_clock::now() - start;
+        best.samples.push_back(toMilliseconds(time));
+
+        if (time < best.time) {
+            best.time = time;
+            best.stats = builder.buildStats();
+        }
+    }
+
+    return best;
+}
+
+static Measurement measureParallelBuild(const size_t numLeafs, const int numThreads, const Options& options) {
+    const int defaultNumThreads = omp_get_max_threads();
+    omp_set_num_threads(numThreads);
+    const Measurement result = measureBuild<ParallelOctreeBuilder>(numLeafs, options);
+    omp_set_num_threads(defaultNumThreads);
+    return result;
+}
+
+static std::vector<int> threadCounts(const int maxThreads) {
+    std::vector<int> result;
+    for (int t = 1; t < maxThreads; t *= 2) {
+        result.push_back(t);
+    }
+    result.push_back(maxThreads);
+    return result;
+}
+
+static void printHeader() {
+    std::cout << std::left << std::setw(12) << "leafs" << std::setw(12) << "builder" << std::setw(9) << "threads" << std::setw(14) << "time (ms)"
+              << std::setw(20) << "speedup (vs seq)" << std::setw(20) << "speedup (vs 1 thr)" << std::setw(12) << "efficiency" << '\n';
+}
+
+static void printRow(const size_t numLeafs, const std::string& builder, const int numThreads, const Measurement& measurement, const double speedupSequential,
+                     const double speedupOneThread, const double efficiency) {
+    std::cout << std::left << std::setw(12) << numLeafs << std::setw(12) << builder << std::setw(9) << numThreads << std::setw(14) << std::fixed
+              << std::setprecision(2) << toMilliseconds(measurement.time) << std::setw(20) << speedupSequential << std::setw(20) << speedupOneThread
+              << std::setw(12) << efficiency << '\n';
+
+    std::cout << "    phases (ms):";
+    for (size_t i = 0; i < BuildStats::NUM_PHASES; i++) {
+        const BuildStats::Phase phase = static_cast<BuildStats::Phase>(i);
+        if (measurement.stats.phaseTime(phase) > std::chrono::high_resolution_clock::duration::zero()) {
+            std::cout << ' ' << phase << '=' << toMilliseconds(measurement.stats.phaseTime(phase));
+        }
+    }
+    std::cout << "\n    load imbalance (max / mean busy time of SUBTREE_BUILD): " << measurement.stats.subtreeBuildLoad.imbalanceRatio() << std::endl;
+}
+
+static void addToReport(BenchmarkReport& report, const std::string& scaling, const size_t numLeafs, const std::string& builder, const int numThreads,
+                        const Measurement& measurement) {
+    BenchmarkResult result(scaling + "/leafs=" + std::to_string(numLeafs) + "/" + builder + "/threads=" + std::to_string(numThreads), "ms");
+    result.samples = measurement.samples;
+    report.add(result);
+}
+
+static double ratio(const Measurement& numerator, const Measurement& denominator) {
+    return toMilliseconds(numerator.time) / toMilliseconds(denominator.time);
+}
+
+static void runStrongScaling(const Options& options, BenchmarkReport& report) {
+    std::cout << "Strong scaling (fixed number of leafs)\n";
+    printHeader();
+
+    for (size_t numLeafs = options.minLeafs; numLeafs <= options.maxLeafs; numLeafs *= 10) {
+        Measurement sequential;
+        if (options.sequential) {
+            sequential = measureBuild<SequentialOctreeBuilder>(numLeafs, options);
+            printRow(numLeafs, "sequential", 1, sequential, 1.0, 0.0, 1.0);
+            addToReport(report, "strong", numLeafs, "sequential", 1, sequential);
+        }
+
+        Measurement oneThread;
+        for (const int numThreads : threadCounts(options.maxThreads)) {
+            const Measurement parallel = measureParallelBuild(numLeafs, numThreads, options);
+            if (numThreads == 1) {
+                oneThread = parallel;
+            }
+
+            const double speedupSequential = options.sequential ? ratio(sequential, parallel) : 0.0;
+            const double speedupOneThread = ratio(oneThread, parallel);
+            printRow(numLeafs, "parallel", numThreads, parallel, speedupSequential, speedupOneThread, speedupOneThread / numThreads);
+            addToReport(report, "strong", numLeafs, "parallel", numThreads, parallel);
+        }
+        std::cout << '\n';
+    }
+}
+
+static void runWeakScaling(const Options& options, BenchmarkReport& report) {
+    std::cout << "Weak scaling (fixed number of leafs per thread)\n";
+    printHeader();
+
+    for (size_t numLeafsPerThread = options.minLeafs; numLeafsPerThread <= options.maxLeafs; numLeafsPerThread *= 10) {
+        Measurement oneThread;
+        for (const int numThreads : threadCounts(options.maxThreads)) {
+            const size_t numLeafs = numLeafsPerThread * static_cast<size_t>(numThreads);
+
+            Measurement sequential;
+            if (options.sequential) {
+                sequential = measureBuild<SequentialOctreeBuilder>(numLeafs, options);
+                printRow(numLeafs, "sequential", 1, sequential, 1.0, 0.0, 1.0);
+                addToReport(report, "weak", numLeafs, "sequential", 1, sequential);
+            }
+
+            const Measurement parallel = measureParallelBuild(numLeafs, numThreads, options);
+            if (numThreads == 1) {
+                oneThread = parallel;
+            }
+
+            // Ideally the time stays constant... hence the efficiency is the time of one thread divided by the time of numThreads
+            const double efficiency = ratio(oneThread, parallel);
+            const double speedupSequential = options.sequential ? ratio(sequential, parallel) : 0.0;
+            printRow(numLeafs, "parallel", numThreads, parallel, speedupSequential, efficiency * numThreads, efficiency);
+            addToReport(report, "weak", numLeafs, "parallel", numThreads, parallel);
+        }
+        std::cout << '\n';
+    }
+}
+
+static void printUsage(const char* executable) {
+    std::cerr << "Usage: " << executable << " [options]\n"
+              << "  --min-leafs N      smallest number of input leafs (per thread for weak scaling), default 10000\n"
+              << "  --max-leafs N      largest number of input leafs (increased by factors of 10), default 1000000\n"
+              << "  --max-threads N    largest number of threads, default omp_get_max_threads()\n"
+              << "  --repetitions N    number of builds per configuration (the fastest is reported), default 3\n"
+              << "  --strong-only      only run the strong scaling benchmark\n"
+              << "  --weak-only        only run the weak scaling benchmark\n"
+              << "  --no-sequential    don't run the sequential builder (e.g. for very large inputs)\n"
+              << reportOptionsUsage();
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--min-leafs" && hasValue) {
+            options.minLeafs = std::stoul(argv[++i]);
+        } else if (arg == "--max-leafs" && hasValue) {
+            options.maxLeafs = std::stoul(argv[++i]);
+        } else if (arg == "--max-threads" && hasValue) {
+            options.maxThreads = std::stoi(argv[++i]);
+        } else if (arg == "--repetitions" && hasValue) {
+            options.repetitions = std::stoul(argv[++i]);
+        } else if (arg == "--strong-only") {
+            options.weak = false;
+        } else if (arg == "--weak-only") {
+            options.strong = false;
+        } else if (arg == "--no-sequential") {
+            options.sequential = false;
+        } else if (!parseReportOption(argc, argv, i, options.report)) {
+            return false;
+        }
+    }
+
+    return options.minLeafs > 0 && options.minLeafs <= options.maxLeafs && options.maxThreads > 0 && options.repetitions > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    BenchmarkReport report("scalingbenchmark");
+
+    if (options.strong) {
+        runStrongScaling(options, report);
+    }
+
+    if (options.weak) {
+        runWeakScaling(options, report);
+    }
+
+    return report.finish(options.report);
+}
@@ -58,6 +58,10 @@ bool Box::contains(const Vector3i& point) const {
            m_urb.z() >= point.z();
 }
 
+Box Box::intersection(const Box& other) const {
+    return Box(max(m_llf, other.llf()), min(m_urb, other.urb()));
+}
+
 ::std::ostream& operator<<(::std::ostream& s, const Box& b) {
     s << "{ llf: " << b.llf() << ", urb: " << b.urb() << " }";
     return s;
@@ -33,6 +33,11 @@ public:
 
     bool contains(const Vector3i& point) const;
 
+    /**
+     * @brief The common part of both boxes (not valid if they don't overlap)
+     */
+    Box intersection(const Box& other) const;
+
 private:
     Vector3i m_llf;
     Vector3i m_urb;
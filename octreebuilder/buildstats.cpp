@@ -0,0 +1,225 @@
+#include "buildstats.h"
+
+#include "tracer.h"
+
+#include <ostream>
+#include <algorithm>
+#include <sstream>
+
+namespace octreebuilder {
+
+MemoryStats::MemoryStats() : peakLiveBytes(0), liveBytes(0) {
+}
+
+MemoryStats::MemoryStats(size_t peakLiveBytes, size_t liveBytes) : peakLiveBytes(peakLiveBytes), liveBytes(liveBytes) {
+}
+
+BlockStats::BlockStats() : numInputOctants(0), numOutputOctants(0), thread(0), time(::std::chrono::high_resolution_clock::duration::zero()) {
+}
+
+LoadBalanceStats::LoadBalanceStats() : wallTime(duration::zero()) {
+}
+
+LoadBalanceStats::duration LoadBalanceStats::maxBusyTime() const {
+    duration maxTime = duration::zero();
+    for (const duration& busyTime : busyTimePerThread) {
+        maxTime = ::std::max(maxTime, busyTime);
+    }
+    return maxTime;
+}
+
+LoadBalanceStats::duration LoadBalanceStats::meanBusyTime() const {
+    if (busyTimePerThread.empty()) {
+        return duration::zero();
+    }
+
+    duration sum = duration::zero();
+    for (const duration& busyTime : busyTimePerThread) {
+        sum += busyTime;
+    }
+    return sum / static_cast<duration::rep>(busyTimePerThread.size());
+}
+
+double LoadBalanceStats::imbalanceRatio() const {
+    const duration mean = meanBusyTime();
+    if (mean.count() <= 0) {
+        return 1.0;
+    }
+
+    return static_cast<double>(maxBusyTime().count()) / static_cast<double>(mean.count());
+}
+
+double LoadBalanceStats::blockImbalanceRatio() const {
+    duration maxTime = duration::zero();
+    duration sum = duration::zero();
+    for (const BlockStats& block : blocks) {
+        maxTime = ::std::max(maxTime, block.time);
+        sum += block.time;
+    }
+
+    if (sum.count() <= 0) {
+        return 1.0;
+    }
+
+    return static_cast<double>(maxTime.count()) * static_cast<double>(blocks.size()) / static_cast<double>(sum.count());
+}
+
+LoadBalanceStats::duration LoadBalanceStats::idleTime() const {
+    duration idle = duration::zero();
+    for (const duration& busyTime : busyTimePerThread) {
+        idle += ::std::max(duration::zero(), wallTime - busyTime);
+    }
+    return idle;
+}
+
+const size_t BuildStats::NUM_PHASES;
+
+BuildStats::BuildStats() : numLevelZeroLeafs(0), numLeafs(0), numBlocks(0), numBoundaryOctants(0), numSplits(0), m_liveBytes(0) {
+    m_phaseTimes.fill(duration::zero());
+}
+
+BuildStats::duration BuildStats::phaseTime(const BuildStats::Phase& phase) const {
+    return m_phaseTimes.at(static_cast<size_t>(phase));
+}
+
+void BuildStats::addPhaseTime(const BuildStats::Phase& phase, const BuildStats::duration& time) {
+    m_phaseTimes.at(static_cast<size_t>(phase)) += time;
+
+    if (Tracer::activeTracer() != nullptr) {
+        ::std::ostringstream name;
+        name << phase;
+        Tracer::recordCompletedEvent(name.str(), "phase", ::std::chrono::duration_cast<Tracer::clock::duration>(time));
+    }
+}
+
+BuildStats::duration BuildStats::totalTime() const {
+    duration total = duration::zero();
+    for (const duration& time : m_phaseTimes) {
+        total += time;
+    }
+    return total;
+}
+
+const HardwareCounterValues& BuildStats::phaseCounters(const BuildStats::Phase& phase) const {
+    return m_phaseCounters.at(static_cast<size_t>(phase));
+}
+
+void BuildStats::addPhaseCounters(const BuildStats::Phase& phase, const HardwareCounterValues& values) {
+    m_phaseCounters.at(static_cast<size_t>(phase)) += values;
+}
+
+HardwareCounterValues BuildStats::totalCounters() const {
+    HardwareCounterValues total;
+    for (const HardwareCounterValues& values : m_phaseCounters) {
+        total += values;
+    }
+    return total;
+}
+
+const MemoryStats& BuildStats::phaseMemory(const BuildStats::Phase& phase) const {
+    return m_phaseMemory.at(static_cast<size_t>(phase));
+}
+
+void BuildStats::addPhaseMemory(const BuildStats::Phase& phase, const MemoryStats& memory) {
+    MemoryStats& phaseMemory = m_phaseMemory.at(static_cast<size_t>(phase));
+    phaseMemory.peakLiveBytes = ::std::max(phaseMemory.peakLiveBytes, memory.peakLiveBytes);
+    phaseMemory.liveBytes = memory.liveBytes;
+    m_liveBytes = memory.liveBytes;
+}
+
+size_t BuildStats::peakLiveBytes() const {
+    size_t peak = 0;
+    for (const MemoryStats& memory : m_phaseMemory) {
+        peak = ::std::max(peak, memory.peakLiveBytes);
+    }
+    return peak;
+}
+
+size_t BuildStats::liveBytes() const {
+    return m_liveBytes;
+}
+
+::std::ostream& operator<<(::std::ostream& s, const MemoryStats& stats) {
+    s << "{ peakLiveBytes: " << stats.peakLiveBytes << ", liveBytes: " << stats.liveBytes << " }";
+    return s;
+}
+
+::std::ostream& operator<<(::std::ostream& s, const LoadBalanceStats& stats) {
+    s << "{ numThreads: " << stats.busyTimePerThread.size() << ", numBlocks: " << stats.blocks.size() << ", imbalanceRatio: " << stats.imbalanceRatio()
+      << ", blockImbalanceRatio: " << stats.blockImbalanceRatio()
+      << ", wallTime (ms): " << ::std::chrono::duration<double, ::std::milli>(stats.wallTime).count()
+      << ", idleTime (ms): " << ::std::chrono::duration<double, ::std::milli>(stats.idleTime()).count() << " }";
+    return s;
+}
+
+::std::ostream& operator<<(::std::ostream& s, const BuildStats::Phase& phase) {
+    switch (phase) {
+        case BuildStats::Phase::CREATE_INPUT:
+            s << "CREATE_INPUT";
+            break;
+        case BuildStats::Phase::SORT_INPUT:
+            s << "SORT_INPUT";
+            break;
+        case BuildStats::Phase::PARTITION:
+            s << "PARTITION";
+            break;
+        case BuildStats::Phase::SUBTREE_BUILD:
+            s << "SUBTREE_BUILD";
+            break;
+        case BuildStats::Phase::BOUNDARY_COLLECT:
+            s << "BOUNDARY_COLLECT";
+            break;
+        case BuildStats::Phase::BOUNDARY_TREE:
+            s << "BOUNDARY_TREE";
+            break;
+        case BuildStats::Phase::BOUNDARY_BALANCE:
+            s << "BOUNDARY_BALANCE";
+            break;
+        case BuildStats::Phase::FLATTEN:
+            s << "FLATTEN";
+            break;
+        case BuildStats::Phase::MERGE:
+            s << "MERGE";
+            break;
+        case BuildStats::Phase::INDEX_FILL:
+            s << "INDEX_FILL";
+            break;
+    }
+
+    return s;
+}
+
+::std::ostream& operator<<(::std::ostream& s, const BuildStats& stats) {
+    s << "{ numLevelZeroLeafs: " << stats.numLevelZeroLeafs << ", numLeafs: " << stats.numLeafs << ", numBlocks: " << stats.numBlocks
+      << ", numBoundaryOctants: " << stats.numBoundaryOctants << ", numSplits: " << stats.numSplits << ", phaseTimes (ms): { ";
+
+    for (size_t i = 0; i < BuildStats::NUM_PHASES; i++) {
+        const BuildStats::Phase phase = static_cast<BuildStats::Phase>(i);
+        s << phase << ": " << ::std::chrono::duration<double, ::std::milli>(stats.phaseTime(phase)).count() << ", ";
+    }
+
+    s << "total: " << ::std::chrono::duration<double, ::std::milli>(stats.totalTime()).count() << " }";
+    if (stats.totalCounters().valid) {
+        s << ", hardwareCounters: { ";
+        for (size_t i = 0; i < BuildStats::NUM_PHASES; i++) {
+            const BuildStats::Phase phase = static_cast<BuildStats::Phase>(i);
+            if (stats.phaseCounters(phase).valid) {
+                s << phase << ": " << stats.phaseCounters(phase) << ", ";
+            }
+        }
+        s << "total: " << stats.totalCounters() << " }";
+    }
+
+    if (stats.peakLiveBytes() > 0) {
+        s << ", memory: { ";
+        for (size_t i = 0; i < BuildStats::NUM_PHASES; i++) {
+            const BuildStats::Phase phase = static_cast<BuildStats::Phase>(i);
+            s << phase << ": " << stats.phaseMemory(phase) << ", ";
+        }
+        s << "peakLiveBytes: " << stats.peakLiveBytes() << " }";
+    }
+
+    s << ", subtreeBuildLoad: " << stats.subtreeBuildLoad << ", boundaryCollectLoad: " << stats.boundaryCollectLoad << " }";
+    return s;
+}
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+#include "hardwarecounters.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace octreebuilder {
+
+/**
+ * @brief The estimated memory of the containers owned by a build during a phase
+ *
+ * The builders sample the sizes of their containers at the phase boundaries (and where a phase holds intermediate copies),
+ * hence short lived allocations inside of a phase aren't part of the peak.
+ */
+struct OCTREEBUILDER_API MemoryStats {
+    MemoryStats();
+
+    MemoryStats(size_t peakLiveBytes, size_t liveBytes);
+
+    /**
+     * @brief The maximum number of bytes that were live at the same time
+     */
+    size_t peakLiveBytes;
+
+    /**
+     * @brief The number of bytes live at the end of the phase
+     */
+    size_t liveBytes;
+};
+
+/**
+ * @brief The work done for one block (subtree) in a parallel phase
+ */
+struct OCTREEBUILDER_API BlockStats {
+    BlockStats();
+
+    /**
+     * @brief The number of octants of the block before the phase
+     */
+    size_t numInputOctants;
+
+    /**
+     * @brief The number of octants of the block after the phase
+     */
+    size_t numOutputOctants;
+
+    /**
+     * @brief The OpenMP thread number of the thread that processed the block
+     */
+    int thread;
+
+    ::std::chrono::high_resolution_clock::duration time;
+};
+
+/**
+ * @brief The distribution of the work of a parallel phase over the threads and blocks
+ */
+struct OCTREEBUILDER_API LoadBalanceStats {
+    typedef ::std::chrono::high_resolution_clock::duration duration;
+
+    LoadBalanceStats();
+
+    /**
+     * @brief The ratio of the maximum and the mean busy time of all threads (1 is perfectly balanced)
+     */
+    double imbalanceRatio() const;
+
+    /**
+     * @brief The ratio of the maximum and the mean time of all blocks
+     */
+    double blockImbalanceRatio() const;
+
+    /**
+     * @brief The sum of the time each thread waited for the other threads (wallTime - busy time of the thread)
+     */
+    duration idleTime() const;
+
+    duration maxBusyTime() const;
+
+    duration meanBusyTime() const;
+
+    /**
+     * @brief The wall time of the parallel region
+     */
+    duration wallTime;
+
+    /**
+     * @brief The time each thread of the parallel region spent processing blocks
+     */
+    ::std::vector<duration> busyTimePerThread;
+
+    /**
+     * @brief The i-th entry belongs to the i-th block
+     */
+    ::std::vector<BlockStats> blocks;
+};
+
+/**
+ * @brief Statistics of the creation of an octree (wall time of each phase and sizes of the intermediate results)
+ *
+ * Phases that are not part of a builder's algorithm have a time of zero.
+ */
+struct OCTREEBUILDER_API BuildStats {
+    typedef ::std::chrono::high_resolution_clock::duration duration;
+
+    enum class Phase {
+        CREATE_INPUT = 0,  // create the list of level zero leafs
+        SORT_INPUT,
+        PARTITION,
+        SUBTREE_BUILD,  // create the balanced subtree of each block
+        BOUNDARY_COLLECT,
+        BOUNDARY_TREE,  // create the tree of all boundary octants
+        BOUNDARY_BALANCE,
+        FLATTEN,
+        MERGE,
+        INDEX_FILL  // create the octree from the linear octree
+    };
+
+    static const size_t NUM_PHASES = 10;
+
+    BuildStats();
+
+    duration phaseTime(const Phase& phase) const;
+
+    /**
+     * @brief Adds the time to the phase and records a trace event for the phase (that ended now) if a tracer is active
+     */
+    void addPhaseTime(const Phase& phase, const duration& time);
+
+    /**
+     * @brief The sum of the times of all phases
+     */
+    duration totalTime() const;
+
+    /**
+     * @brief The hardware counter values of the phase (invalid if hardware counters were disabled or unavailable)
+     */
+    const HardwareCounterValues& phaseCounters(const Phase& phase) const;
+
+    void addPhaseCounters(const Phase& phase, const HardwareCounterValues& values);
+
+    /**
+     * @brief The sum of the hardware counter values of all phases
+     */
+    HardwareCounterValues totalCounters() const;
+
+    /**
+     * @brief The estimated memory of the containers of the build during the phase (all zero if the phase isn't part of the algorithm)
+     */
+    const MemoryStats& phaseMemory(const Phase& phase) const;
+
+    /**
+     * @brief Adds the memory to the phase: the peak is the maximum of both and the live bytes are replaced
+     */
+    void addPhaseMemory(const Phase& phase, const MemoryStats& memory);
+
+    /**
+     * @brief The maximum peak of all phases
+     */
+    size_t peakLiveBytes() const;
+
+    /**
+     * @brief The live bytes of the phase that was added last (see addPhaseMemory)
+     */
+    size_t liveBytes() const;
+
+    /**
+     * @brief The number of unique level zero leafs added to the builder
+     */
+    size_t numLevelZeroLeafs;
+
+    /**
+     * @brief The number of leafs of the final octree
+     */
+    size_t numLeafs;
+
+    /**
+     * @brief The number of blocks (subtrees that are created in parallel)
+     */
+    size_t numBlocks;
+
+    /**
+     * @brief The number of leafs at the boundary of the blocks
+     */
+    size_t numBoundaryOctants;
+
+    /**
+     * @brief The number of boundary octants that were split to balance the boundary tree
+     */
+    size_t numSplits;
+
+    /**
+     * @brief The load distribution of the creation of the balanced subtrees of all blocks (SUBTREE_BUILD)
+     */
+    LoadBalanceStats subtreeBuildLoad;
+
+    /**
+     * @brief The load distribution of the collection of the boundary octants of all blocks (BOUNDARY_COLLECT)
+     */
+    LoadBalanceStats boundaryCollectLoad;
+
+private:
+    ::std::array<duration, NUM_PHASES> m_phaseTimes;
+    ::std::array<HardwareCounterValues, NUM_PHASES> m_phaseCounters;
+    ::std::array<MemoryStats, NUM_PHASES> m_phaseMemory;
+    size_t m_liveBytes;
+};
+
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const MemoryStats& stats);
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const LoadBalanceStats& stats);
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const BuildStats::Phase& phase);
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const BuildStats& stats);
+}
@@ -0,0 +1,33 @@
+#include "checksum.h"
+
+#include <array>
+
+namespace octreebuilder {
+
+static ::std::array<uint32_t, 256> createCrc32Table() {
+    ::std::array<uint32_t, 256> table;
+
+    for (uint32_t i = 0; i < table.size(); i++) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+        }
+        table[i] = value;
+    }
+
+    return table;
+}
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+    static const ::std::array<uint32_t, 256> table = createCrc32Table();
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+}
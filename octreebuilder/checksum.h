@@ -0,0 +1,15 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace octreebuilder {
+
+/**
+ * @brief Computes the CRC-32 (IEEE 802.3) of the data
+ * @param crc The checksum of the preceding data (to compute the checksum of non contiguous data in steps), 0 for the first step
+ */
+OCTREEBUILDER_API uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
+}
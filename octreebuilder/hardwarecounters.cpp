@@ -0,0 +1,171 @@
+#include "hardwarecounters.h"
+
+#include <array>
+#include <ostream>
+
+#include <omp.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace octreebuilder {
+
+HardwareCounterValues::HardwareCounterValues()
+    : valid(false), instructions(0), cycles(0), cacheReferences(0), cacheMisses(0), branchInstructions(0), branchMisses(0) {
+}
+
+HardwareCounterValues& HardwareCounterValues::operator+=(const HardwareCounterValues& other) {
+    if (other.valid) {
+        valid = true;
+        instructions += other.instructions;
+        cycles += other.cycles;
+        cacheReferences += other.cacheReferences;
+        cacheMisses += other.cacheMisses;
+        branchInstructions += other.branchInstructions;
+        branchMisses += other.branchMisses;
+    }
+    return *this;
+}
+
+static unsigned long long difference(const unsigned long long& end, const unsigned long long& start) {
+    // scaled (multiplexed) counter values are not strictly monotonic
+    return end > start ? end - start : 0;
+}
+
+HardwareCounterValues difference(const HardwareCounterValues& end, const HardwareCounterValues& start) {
+    HardwareCounterValues result;
+    if (!end.valid || !start.valid) {
+        return result;
+    }
+
+    result.valid = true;
+    result.instructions = difference(end.instructions, start.instructions);
+    result.cycles = difference(end.cycles, start.cycles);
+    result.cacheReferences = difference(end.cacheReferences, start.cacheReferences);
+    result.cacheMisses = difference(end.cacheMisses, start.cacheMisses);
+    result.branchInstructions = difference(end.branchInstructions, start.branchInstructions);
+    result.branchMisses = difference(end.branchMisses, start.branchMisses);
+    return result;
+}
+
+::std::ostream& operator<<(::std::ostream& s, const HardwareCounterValues& values) {
+    if (!values.valid) {
+        s << "{ unavailable }";
+        return s;
+    }
+
+    s << "{ instructions: " << values.instructions << ", cycles: " << values.cycles << ", cacheReferences: " << values.cacheReferences
+      << ", cacheMisses: " << values.cacheMisses << ", branchInstructions: " << values.branchInstructions << ", branchMisses: " << values.branchMisses << " }";
+    return s;
+}
+
+#ifdef __linux__
+
+static const ::std::array<unsigned long long, 6> EVENTS = {{PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_REFERENCES,
+                                                          PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES}};
+
+/**
+ * @brief Opens a counter for the calling thread (returns -1 on failure)
+ */
+static int openCounter(const unsigned long long event) {
+    perf_event_attr attr;
+    ::std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+HardwareCounters::HardwareCounters() {
+    const size_t numThreads = static_cast<size_t>(omp_get_max_threads());
+    m_fds = ::std::vector<int>(numThreads * EVENTS.size(), -1);
+
+    bool failed = false;
+
+// Counters are bound to the thread that opens them... hence each thread of the pool opens its own counters
+#pragma omp parallel num_threads(static_cast<int>(numThreads)) reduction(|| : failed)
+    {
+        const size_t thread = static_cast<size_t>(omp_get_thread_num());
+        for (size_t i = 0; i < EVENTS.size(); i++) {
+            const int fd = openCounter(EVENTS[i]);
+            m_fds[thread * EVENTS.size() + i] = fd;
+            failed = failed || fd < 0;
+        }
+    }
+
+    if (failed) {
+        for (const int fd : m_fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        m_fds.clear();
+    }
+}
+
+HardwareCounters::~HardwareCounters() {
+    for (const int fd : m_fds) {
+        close(fd);
+    }
+}
+
+HardwareCounterValues HardwareCounters::read() const {
+    HardwareCounterValues values;
+    if (!available()) {
+        return values;
+    }
+
+    ::std::array<unsigned long long, 6> sums;
+    sums.fill(0);
+
+    for (size_t i = 0; i < m_fds.size(); i++) {
+        // value, time enabled, time running
+        ::std::array<unsigned long long, 3> data;
+        if (::read(m_fds[i], data.data(), sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            return HardwareCounterValues();
+        }
+
+        unsigned long long value = data[0];
+        if (data[2] > 0 && data[2] < data[1]) {
+            // the counter was multiplexed... extrapolate
+            value = static_cast<unsigned long long>(static_cast<double>(value) * static_cast<double>(data[1]) / static_cast<double>(data[2]));
+        }
+        sums[i % EVENTS.size()] += value;
+    }
+
+    values.valid = true;
+    values.instructions = sums[0];
+    values.cycles = sums[1];
+    values.cacheReferences = sums[2];
+    values.cacheMisses = sums[3];
+    values.branchInstructions = sums[4];
+    values.branchMisses = sums[5];
+    return values;
+}
+
+#else
+
+HardwareCounters::HardwareCounters() {
+}
+
+HardwareCounters::~HardwareCounters() {
+}
+
+HardwareCounterValues HardwareCounters::read() const {
+    return HardwareCounterValues();
+}
+
+#endif
+
+bool HardwareCounters::available() const {
+    return !m_fds.empty();
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include <vector>
+#include <iosfwd>
+
+namespace octreebuilder {
+
+/**
+ * @brief Values of the hardware performance counters (summed over all threads)
+ */
+struct OCTREEBUILDER_API HardwareCounterValues {
+    HardwareCounterValues();
+
+    /**
+     * @brief False if the counters were not available (e.g. not supported by the platform or not permitted)
+     */
+    bool valid;
+
+    unsigned long long instructions;
+    unsigned long long cycles;
+    unsigned long long cacheReferences;
+    unsigned long long cacheMisses;
+    unsigned long long branchInstructions;
+    unsigned long long branchMisses;
+
+    /**
+     * @brief Adds the values of other (ignored if other is invalid)
+     */
+    HardwareCounterValues& operator+=(const HardwareCounterValues& other);
+};
+
+/**
+ * @brief The counter values between start and end (invalid if one of them is invalid)
+ * @note Scaled (multiplexed) counter values are not strictly monotonic, a counter that decreased yields 0.
+ */
+OCTREEBUILDER_API HardwareCounterValues difference(const HardwareCounterValues& end, const HardwareCounterValues& start);
+
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const HardwareCounterValues& values);
+
+/**
+ * @brief Counts hardware events (instructions, cycles, cache misses, branch misses) of the calling thread and the threads of the OpenMP thread pool
+ *
+ * Uses perf_event_open on Linux. The counters of user space events are opened on construction and counting starts immediately.
+ * If the counters can't be opened (unsupported platform, missing permissions, e.g. in containers or with a restrictive perf_event_paranoid setting)
+ * available() is false and all read values are invalid.
+ * Threads that are created after construction are not counted.
+ */
+class OCTREEBUILDER_API HardwareCounters {
+public:
+    HardwareCounters();
+
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    ~HardwareCounters();
+
+    bool available() const;
+
+    /**
+     * @brief The current values (summed over all threads), scaled if the kernel had to multiplex the counters
+     */
+    HardwareCounterValues read() const;
+
+private:
+    // file descriptors of the counters (NUM_EVENTS per thread)
+    ::std::vector<int> m_fds;
+};
+}
@@ -4,10 +4,27 @@
 #include <octreebuilder.h>
 #include <sequentialoctreebuilder.h>
 #include <paralleloctreebuilder.h>
+#include <octreefile.h>
+#include <outofcoreoctreebuilder.h>
 
 #include <vector_utils.h>
-
+#include <mortoncode_utils.h>
+#include <tracer.h>
+
+#include <omp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <random>
+#include <limits>
+#include <map>
+#include <set>
 
 using namespace octreebuilder;
 
@@ -66,13 +83,69 @@ static bool sortByYXZ(const OctreeNode& ln, const OctreeNode& rn) {
     return l.y() < r.y();
 }
 
+/**
+ * @brief Compares the leafs of both octrees
+ */
+static void expectSameLeafs(const Octree& expected, const Octree& result) {
+    ASSERT_EQ(expected.getNumNodes(), result.getNumNodes());
+    for (size_t i = 0; i < expected.getNumNodes(); i++) {
+        ASSERT_EQ(expected.getNode(i), result.getNode(i)) << "leaf " << i;
+    }
+}
+
+/**
+ * @brief Removes the files created by a test (see createTemporaryPath)
+ */
+class TemporaryFilesTest : public ::testing::Test {
+public:
+    /**
+     * @brief A path in the working directory (prefixed with the name of the test) which is removed after the test
+     */
+    std::string createTemporaryPath(const std::string& extension) {
+        const std::string path = std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + "." +
+                                 std::to_string(m_temporaryPaths.size()) + extension;
+        m_temporaryPaths.push_back(path);
+        return path;
+    }
+
+protected:
+    virtual void TearDown() override {
+        for (const std::string& path : m_temporaryPaths) {
+            std::remove(path.c_str());
+        }
+        m_temporaryPaths.clear();
+    }
+
+private:
+    std::vector<std::string> m_temporaryPaths;
+};
+
+/**
+ * @brief The memory budget of the out of core builders of the tests... 4096 leafs, hence most tests spill several runs
+ */
+static const size_t OUT_OF_CORE_MEMORY_BUDGET = 32 * 1024;
+
+template <class T>
+struct BuilderFactory {
+    static OctreeBuilder* create(const Vector3i& maxXYZ, uint maxLevel, const std::string&) {
+        return new T(maxXYZ, 0, maxLevel);
+    }
+};
+
+template <>
+struct BuilderFactory<OutOfCoreOctreeBuilder> {
+    static OctreeBuilder* create(const Vector3i& maxXYZ, uint maxLevel, const std::string& outputPath) {
+        return new OutOfCoreOctreeBuilder(maxXYZ, outputPath, OUT_OF_CORE_MEMORY_BUDGET, ".", maxLevel);
+    }
+};
+
 using testing::Types;
 
 template<class T>
-class OctreeBuilderTest : public ::testing::Test {
+class OctreeBuilderTest : public TemporaryFilesTest {
 public:
     OctreeBuilder& createInstance(const Vector3i& maxXYZ, uint maxLevel = std::numeric_limits<uint>::max()) {
-        OctreeBuilder* newInstance = new T(maxXYZ, 0, maxLevel);
+        OctreeBuilder* newInstance = BuilderFactory<T>::create(maxXYZ, maxLevel, createTemporaryPath(".octree"));
         m_instances.push_back(std::unique_ptr<OctreeBuilder>(newInstance));
         return *newInstance;
     }
@@ -80,8 +153,9 @@ public:
 protected:
     std::vector<std::unique_ptr<OctreeBuilder>> m_instances;
 
-    virtual void TearDown() {
+    virtual void TearDown() override {
         m_instances.clear();
+        TemporaryFilesTest::TearDown();
     }
 };
 
@@ -631,3 +705,1103 @@ TYPED_TEST(OctreeBuilderTest, fromRandomSequence_4_IntegrationTest) {
 
     ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
 }
+
+TYPED_TEST(OctreeBuilderTest, allNeighbourNodesAreSymmetricIntegrationTest) {
+
+    const coord_t maxCoord = 63;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(9174);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 50; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    const std::vector<std::vector<OctreeNode>> neighbourNodesOfAllNodes = result->getAllNeighbourNodesOfAllNodes();
+
+    std::map<std::pair<morton_t, uint>, size_t> nodeIndices;
+    for (size_t i = 0; i < result->getNumNodes(); i++) {
+        const OctreeNode node = result->getNode(i);
+        nodeIndices[std::make_pair(node.getMortonEncodedLLF(), node.getLevel())] = i;
+    }
+
+    for (size_t i = 0; i < result->getNumNodes(); i++) {
+        const OctreeNode node = result->getNode(i);
+
+        for (const OctreeNode& neighbour : neighbourNodesOfAllNodes.at(i)) {
+            ASSERT_LE(std::max(node.getLevel(), neighbour.getLevel()) - std::min(node.getLevel(), neighbour.getLevel()), 1u);
+
+            auto it = nodeIndices.find(std::make_pair(neighbour.getMortonEncodedLLF(), neighbour.getLevel()));
+            ASSERT_NE(nodeIndices.end(), it);
+            ASSERT_THAT(neighbourNodesOfAllNodes.at(it->second), ::testing::Contains(node));
+        }
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, computeVertexNumberingIntegrationTest) {
+
+    const coord_t maxCoord = 31;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(2231);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 10; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    const VertexNumbering numbering = result->computeVertexNumbering();
+
+    // Brute force: collect the vertices of all nodes and test each vertex against all nodes
+    std::map<morton_t, bool> expectedVertices;
+    for (size_t i = 0; i < result->getNumNodes(); i++) {
+        const OctreeNode node = result->getNode(i);
+        for (const Vector3i& offset : VectorSpace(Vector3i(2))) {
+            expectedVertices[getMortonCodeForCoordinate(node.getLLF() + offset * node.getSize())] = false;
+        }
+    }
+
+    for (auto& vertex : expectedVertices) {
+        const Vector3i v = getCoordinateForMortonCode(vertex.first);
+
+        for (size_t i = 0; i < result->getNumNodes() && !vertex.second; i++) {
+            const OctreeNode node = result->getNode(i);
+            const Vector3i relative = v - node.getLLF();
+
+            bool onNode = true;
+            bool isVertexOfNode = true;
+            for (uint axis = 0; axis < 3; axis++) {
+                onNode = onNode && relative[axis] >= 0 && relative[axis] <= node.getSize();
+                isVertexOfNode = isVertexOfNode && (relative[axis] == 0 || relative[axis] == node.getSize());
+            }
+
+            vertex.second = onNode && !isVertexOfNode;
+        }
+    }
+
+    ASSERT_EQ(expectedVertices.size(), numbering.vertices.size());
+    ASSERT_EQ(expectedVertices.size(), numbering.isHanging.size());
+
+    size_t i = 0;
+    for (const auto& vertex : expectedVertices) {
+        EXPECT_EQ(vertex.first, numbering.vertices.at(i));
+        EXPECT_EQ(vertex.second, numbering.isHanging.at(i)) << "at vertex " << getCoordinateForMortonCode(vertex.first);
+        i++;
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, traceRayIntegrationTest) {
+
+    const coord_t maxCoord = 63;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(4711);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 20; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    const double treeSize = static_cast<double>(result->getMaxXYZ().x() + 1);
+
+    // Random rays from outside and inside of the tree (including axis aligned rays through node boundaries)
+    std::uniform_real_distribution<double> originDistribution(-0.5 * treeSize, 1.5 * treeSize);
+    std::uniform_int_distribution<int> directionDistribution(-4, 4);
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < 500; i++) {
+        Ray ray{{{originDistribution(generator), originDistribution(generator), originDistribution(generator)}},
+                {{double(directionDistribution(generator)), double(directionDistribution(generator)), double(directionDistribution(generator))}}};
+        if (i % 5 == 0) {
+            ray.origin = {{double(genCoord()), double(genCoord()), double(genCoord())}};
+        }
+        if (ray.direction == std::array<double, 3>{{0, 0, 0}}) {
+            ray.direction[0] = 1;
+        }
+        rays.push_back(ray);
+    }
+
+    const std::vector<RayTraversal> traversals = result->traceRayBatch(rays);
+    ASSERT_EQ(rays.size(), traversals.size());
+
+    for (size_t r = 0; r < rays.size(); r++) {
+        const Ray& ray = rays[r];
+        const RayTraversal& traversal = traversals[r];
+
+        const RayTraversal expected = result->traceRay(ray);
+        EXPECT_EQ(expected.nodeIndices, traversal.nodeIndices);
+
+        ASSERT_EQ(traversal.nodeIndices.size(), traversal.entry.size());
+        ASSERT_EQ(traversal.nodeIndices.size(), traversal.exit.size());
+
+        // Brute force: clip the ray against the bounding box of the tree
+        double tEnter = 0;
+        double tLeave = std::numeric_limits<double>::infinity();
+        for (uint i = 0; i < 3; i++) {
+            if (ray.direction[i] > 0 || ray.direction[i] < 0) {
+                const double t0 = -ray.origin[i] / ray.direction[i];
+                const double t1 = (treeSize - ray.origin[i]) / ray.direction[i];
+                tEnter = std::max(tEnter, std::min(t0, t1));
+                tLeave = std::min(tLeave, std::max(t0, t1));
+            } else if (ray.origin[i] < 0 || ray.origin[i] >= treeSize) {
+                tLeave = -1;
+            }
+        }
+
+        if (tEnter >= tLeave) {
+            EXPECT_TRUE(traversal.nodeIndices.empty()) << "ray " << r;
+            continue;
+        }
+
+        ASSERT_FALSE(traversal.nodeIndices.empty()) << "ray " << r;
+        EXPECT_NEAR(tEnter, traversal.entry.front(), 1e-9) << "ray " << r;
+        EXPECT_NEAR(tLeave, traversal.exit.back(), 1e-9) << "ray " << r;
+
+        for (size_t i = 0; i < traversal.nodeIndices.size(); i++) {
+            EXPECT_LE(traversal.entry[i], traversal.exit[i]) << "ray " << r;
+            if (i > 0) {
+                EXPECT_DOUBLE_EQ(traversal.exit[i - 1], traversal.entry[i]) << "ray " << r;
+                EXPECT_NE(traversal.nodeIndices[i - 1], traversal.nodeIndices[i]) << "ray " << r;
+            }
+
+            // The ray must be inside of the node between entry and exit
+            const OctreeNode node = result->getNode(traversal.nodeIndices[i]);
+            const double t = 0.5 * (traversal.entry[i] + traversal.exit[i]);
+            for (uint axis = 0; axis < 3; axis++) {
+                const double p = ray.origin[axis] + t * ray.direction[axis];
+                EXPECT_GE(p, double(node.getLLF()[axis]) - 1e-9) << "ray " << r << " node " << node;
+                EXPECT_LE(p, double(node.getLLF()[axis] + node.getSize()) + 1e-9) << "ray " << r << " node " << node;
+            }
+        }
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, traceRayPacketIntegrationTest) {
+
+    const coord_t maxCoord = 63;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(1337);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 50; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    // Coherent rays of a camera in front of the tree (the packets share most of their leafs)
+    std::vector<Ray> rays;
+    for (int y = 0; y < 20; y++) {
+        for (int x = 0; x < 20; x++) {
+            rays.push_back(Ray{{{-10.0, 20.0, 30.0}}, {{1.0, (x - 10) / 40.0, (y - 10) / 40.0}}});
+        }
+    }
+
+    const std::vector<RayTraversal> traversals = result->traceRayBatch(rays);
+    ASSERT_EQ(rays.size(), traversals.size());
+
+    for (size_t r = 0; r < rays.size(); r++) {
+        const RayTraversal expected = result->traceRay(rays[r]);
+        EXPECT_FALSE(expected.nodeIndices.empty()) << "ray " << r;
+        EXPECT_EQ(expected.nodeIndices, traversals[r].nodeIndices) << "ray " << r;
+        EXPECT_EQ(expected.entry, traversals[r].entry) << "ray " << r;
+        EXPECT_EQ(expected.exit, traversals[r].exit) << "ray " << r;
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, buildStatsIntegrationTest) {
+
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(815);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    std::set<morton_t> levelZeroLeafs;
+    for (size_t i = 0; i < 2000; i++) {
+        levelZeroLeafs.insert(builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord())));
+    }
+
+    auto result = builder.finishBuilding();
+    const BuildStats& stats = builder.buildStats();
+
+    EXPECT_EQ(levelZeroLeafs.size(), stats.numLevelZeroLeafs);
+    EXPECT_EQ(result->getNumNodes(), stats.numLeafs);
+    EXPECT_GE(stats.numBlocks, 1);
+    EXPECT_LE(stats.numBoundaryOctants, stats.numLeafs);
+    EXPECT_GT(stats.totalTime().count(), 0);
+    EXPECT_GT(stats.phaseTime(BuildStats::Phase::SUBTREE_BUILD).count(), 0);
+
+    BuildStats::duration sumOfPhaseTimes = BuildStats::duration::zero();
+    for (size_t i = 0; i < BuildStats::NUM_PHASES; i++) {
+        sumOfPhaseTimes += stats.phaseTime(static_cast<BuildStats::Phase>(i));
+    }
+    EXPECT_EQ(sumOfPhaseTimes, stats.totalTime());
+    EXPECT_FALSE(stats.totalCounters().valid) << "hardware counters are disabled by default";
+
+    const LoadBalanceStats& subtreeBuildLoad = stats.subtreeBuildLoad;
+    ASSERT_EQ(stats.numBlocks, subtreeBuildLoad.blocks.size());
+    ASSERT_FALSE(subtreeBuildLoad.busyTimePerThread.empty());
+
+    size_t numInputOctants = 0;
+    LoadBalanceStats::duration sumOfBlockTimes = LoadBalanceStats::duration::zero();
+    for (const BlockStats& block : subtreeBuildLoad.blocks) {
+        numInputOctants += block.numInputOctants;
+        sumOfBlockTimes += block.time;
+        EXPECT_GE(block.numOutputOctants, block.numInputOctants);
+        EXPECT_GE(block.thread, 0);
+        EXPECT_LT(static_cast<size_t>(block.thread), subtreeBuildLoad.busyTimePerThread.size());
+    }
+    EXPECT_EQ(stats.numLevelZeroLeafs, numInputOctants);
+
+    LoadBalanceStats::duration sumOfBusyTimes = LoadBalanceStats::duration::zero();
+    for (const LoadBalanceStats::duration& busyTime : subtreeBuildLoad.busyTimePerThread) {
+        sumOfBusyTimes += busyTime;
+        EXPECT_LE(busyTime, subtreeBuildLoad.wallTime);
+    }
+    EXPECT_EQ(sumOfBlockTimes, sumOfBusyTimes);
+    EXPECT_GE(subtreeBuildLoad.imbalanceRatio(), 1.0);
+    EXPECT_GE(subtreeBuildLoad.blockImbalanceRatio(), 1.0);
+    EXPECT_LE(subtreeBuildLoad.idleTime(), subtreeBuildLoad.wallTime * static_cast<int>(subtreeBuildLoad.busyTimePerThread.size()));
+}
+
+TYPED_TEST(OctreeBuilderTest, traceBuildIntegrationTest) {
+
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(42);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 2000; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    Tracer tracer;
+    tracer.activate();
+    auto result = builder.finishBuilding();
+    result->tryGetNodeAt(Vector3i(0), 0);
+    tracer.deactivate();
+
+    std::map<std::string, size_t> numEventsByName;
+    for (const Tracer::Event& event : tracer.events()) {
+        numEventsByName[event.name]++;
+    }
+
+    EXPECT_EQ(1, numEventsByName.count("SequentialOctreeBuilder::finishBuilding") + numEventsByName.count("ParallelOctreeBuilder::finishBuilding"));
+    EXPECT_EQ(1, numEventsByName["SUBTREE_BUILD"]);
+    EXPECT_EQ(1, numEventsByName["INDEX_FILL"]);
+    EXPECT_EQ(1, numEventsByName["OctreeImpl: fill set tree"]);
+
+    if (numEventsByName.count("createBalancedOctreeParallel")) {
+        EXPECT_EQ(builder.buildStats().numBlocks, numEventsByName["SUBTREE_BUILD block"]);
+        EXPECT_EQ(builder.buildStats().numBlocks, numEventsByName["BOUNDARY_COLLECT block"]);
+        EXPECT_EQ(1, numEventsByName["MERGE"]);
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, hardwareCountersIntegrationTest) {
+
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(7);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 2000; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    builder.setHardwareCountersEnabled(true);
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    // The counters might not be available (e.g. in containers)... then the build must still succeed
+    const BuildStats& stats = builder.buildStats();
+    if (HardwareCounters().available()) {
+        ASSERT_TRUE(stats.phaseCounters(BuildStats::Phase::SUBTREE_BUILD).valid);
+        EXPECT_GT(stats.phaseCounters(BuildStats::Phase::SUBTREE_BUILD).instructions, 0);
+        EXPECT_GE(stats.totalCounters().instructions, stats.phaseCounters(BuildStats::Phase::SUBTREE_BUILD).instructions);
+    } else {
+        EXPECT_FALSE(stats.totalCounters().valid);
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, memoryStatsIntegrationTest) {
+
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(11);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 2000; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    const BuildStats& stats = builder.buildStats();
+    const MemoryStats& subtreeMemory = stats.phaseMemory(BuildStats::Phase::SUBTREE_BUILD);
+    EXPECT_GE(subtreeMemory.peakLiveBytes, result->getNumNodes() * sizeof(morton_t));
+    EXPECT_GE(subtreeMemory.peakLiveBytes, subtreeMemory.liveBytes);
+    EXPECT_GE(stats.peakLiveBytes(), subtreeMemory.peakLiveBytes);
+
+    // the stats belong to the build... a second build records the same numbers
+    const size_t peakLiveBytes = stats.peakLiveBytes();
+    builder.finishBuilding();
+    EXPECT_EQ(peakLiveBytes, builder.buildStats().peakLiveBytes());
+}
+
+TYPED_TEST(OctreeBuilderTest, mappedOctreeFileIntegrationTest) {
+
+    const coord_t maxCoord = 63;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(5113);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 100; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    const std::string path = this->createTemporaryPath(".octree");
+    writeOctreeFile(*result, path);
+    const std::unique_ptr<Octree> mapped = mapOctreeFile(path, true);
+
+    ASSERT_EQ(Octree::OctreeState::VALID, mapped->checkState());
+    ASSERT_EQ(result->getNumNodes(), mapped->getNumNodes());
+    EXPECT_EQ(result->getMaxLevel(), mapped->getMaxLevel());
+
+    EXPECT_EQ(result->getAllNeighbourNodesOfAllNodes(), mapped->getAllNeighbourNodesOfAllNodes());
+
+    const VertexNumbering expectedNumbering = result->computeVertexNumbering();
+    const VertexNumbering numbering = mapped->computeVertexNumbering();
+    EXPECT_EQ(expectedNumbering.vertices, numbering.vertices);
+    EXPECT_EQ(expectedNumbering.nodeVertices, numbering.nodeVertices);
+    EXPECT_EQ(expectedNumbering.isHanging, numbering.isHanging);
+
+    const double treeSize = static_cast<double>(maxCoord + 1);
+    std::uniform_real_distribution<double> originDistribution(0.0, treeSize);
+    std::uniform_real_distribution<double> directionDistribution(-1.0, 1.0);
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < 100; i++) {
+        rays.push_back(Ray{{{originDistribution(generator), originDistribution(generator), originDistribution(generator)}},
+                           {{directionDistribution(generator), directionDistribution(generator), 1.0}}});
+    }
+
+    const std::vector<RayTraversal> expectedTraversals = result->traceRayBatch(rays);
+    const std::vector<RayTraversal> traversals = mapped->traceRayBatch(rays);
+    for (size_t r = 0; r < rays.size(); r++) {
+        EXPECT_EQ(expectedTraversals[r].nodeIndices, traversals[r].nodeIndices) << "ray " << r;
+    }
+}
+
+TYPED_TEST(OctreeBuilderTest, compressedOctreeFileIntegrationTest) {
+
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(8081);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 1000; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+    const std::string path = this->createTemporaryPath(".octree");
+    writeCompressedOctreeFile(*result, path);
+    const std::unique_ptr<Octree> read = readOctreeFile(path, true);
+
+    ASSERT_EQ(Octree::OctreeState::VALID, read->checkState());
+    expectSameLeafs(*result, *read);
+
+    EXPECT_EQ(result->getAllNeighbourNodesOfAllNodes(), read->getAllNeighbourNodesOfAllNodes());
+}
+
+/**
+ * @brief The tests of the input functions also run with the out of core builder (which only supports leafs of level zero)
+ */
+template <class T>
+class LevelZeroLeafInputTest : public OctreeBuilderTest<T> {};
+
+typedef Types<SequentialOctreeBuilder, ParallelOctreeBuilder, OutOfCoreOctreeBuilder> AllImplementations;
+
+TYPED_TEST_CASE(LevelZeroLeafInputTest, AllImplementations);
+
+TYPED_TEST(LevelZeroLeafInputTest, levelZeroLeafsFromFileIntegrationTest) {
+
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+    OctreeBuilder& expectedBuilder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(4242);
+    std::uniform_int_distribution<int32_t> denseDistribution(0, 15);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    // many duplicates in a dense region (spans several chunks)
+    const std::string xyzPath = this->createTemporaryPath(".xyz");
+    {
+        std::ofstream file(xyzPath, std::ios::binary);
+        for (size_t i = 0; i < 300000; i++) {
+            const int32_t xyz[3] = {denseDistribution(generator), denseDistribution(generator), denseDistribution(generator)};
+            file.write(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+            expectedBuilder.addLevelZeroLeaf(Vector3i(xyz[0], xyz[1], xyz[2]));
+        }
+    }
+
+    const std::string mortonPath = this->createTemporaryPath(".morton");
+    {
+        std::ofstream file(mortonPath, std::ios::binary);
+        for (size_t i = 0; i < 2000; i++) {
+            const morton_t mcode = expectedBuilder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+            file.write(reinterpret_cast<const char*>(&mcode), sizeof(mcode));
+        }
+    }
+
+    for (size_t i = 0; i < 100; i++) {
+        const Vector3i c(genCoord(), genCoord(), genCoord());
+        builder.addLevelZeroLeaf(c);
+        expectedBuilder.addLevelZeroLeaf(c);
+    }
+
+    EXPECT_EQ(300000, builder.addLevelZeroLeafsFromFile(xyzPath, LevelZeroLeafFileFormat::INT32_XYZ));
+    EXPECT_EQ(2000, builder.addLevelZeroLeafsFromFile(mortonPath, LevelZeroLeafFileFormat::MORTON_CODES));
+
+    auto result = builder.finishBuilding();
+    auto expected = expectedBuilder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    EXPECT_EQ(expectedBuilder.buildStats().numLevelZeroLeafs, builder.buildStats().numLevelZeroLeafs);
+    expectSameLeafs(*expected, *result);
+
+    // invalid files don't add any leafs
+    {
+        std::ofstream file(xyzPath, std::ios::binary | std::ios::app);
+        const int32_t xyz[3] = {0, static_cast<int32_t>(maxCoord + 1), 0};
+        file.write(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+    }
+    EXPECT_THROW(builder.addLevelZeroLeafsFromFile(xyzPath, LevelZeroLeafFileFormat::INT32_XYZ), std::runtime_error);
+    EXPECT_THROW(builder.addLevelZeroLeafsFromFile(xyzPath, LevelZeroLeafFileFormat::MORTON_CODES), std::runtime_error);
+    EXPECT_THROW(builder.addLevelZeroLeafsFromFile("does_not_exist.xyz", LevelZeroLeafFileFormat::INT32_XYZ), std::runtime_error);
+
+    // the coordinates of a code with bits above the bits of the coordinates are inside... the code isn't
+    for (const morton_t& invalidCode : {morton_t(1) << 63, getMortonCodeForCoordinate(Vector3i(maxCoord)) | morton_t(1) << 63}) {
+        {
+            std::ofstream file(mortonPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&invalidCode), sizeof(invalidCode));
+        }
+        EXPECT_THROW(builder.addLevelZeroLeafsFromFile(mortonPath, LevelZeroLeafFileFormat::MORTON_CODES), std::runtime_error);
+    }
+
+    ASSERT_EQ(expected->getNumNodes(), builder.finishBuilding()->getNumNodes());
+}
+
+/**
+ * @brief Creates a random occupancy volume (see OctreeBuilder::addLevelZeroLeafsFromOccupancy), the padding bits are set too
+ */
+static std::vector<uint64_t> createRandomOccupancy(const Vector3i& size, std::default_random_engine& generator) {
+    std::bernoulli_distribution occupiedDistribution(0.1);
+    std::bernoulli_distribution emptyRowDistribution(0.5);
+
+    const size_t wordsPerRow = OctreeBuilder::occupancyWordsPerRow(size.x());
+    std::vector<uint64_t> occupancy(wordsPerRow * static_cast<size_t>(size.y() * size.z()), 0);
+
+    for (size_t row = 0; row < occupancy.size(); row += wordsPerRow) {
+        if (emptyRowDistribution(generator)) {
+            continue;
+        }
+
+        for (size_t bit = 0; bit < wordsPerRow * 64; bit++) {
+            if (occupiedDistribution(generator)) {
+                occupancy[row + bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+
+    return occupancy;
+}
+
+TYPED_TEST(LevelZeroLeafInputTest, occupancyIntegrationTest) {
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+    OctreeBuilder& expectedBuilder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(6161);
+    const Vector3i size(100, 64, 20);
+    const Vector3i llf(5, 60, 100);
+    const std::vector<uint64_t> occupancy = createRandomOccupancy(size, generator);
+
+    size_t numOccupiedVoxels = 0;
+    for (coord_t z = 0; z < size.z(); z++) {
+        for (coord_t y = 0; y < size.y(); y++) {
+            for (coord_t x = 0; x < size.x(); x++) {
+                const size_t row = static_cast<size_t>(z * size.y() + y) * OctreeBuilder::occupancyWordsPerRow(size.x());
+                if ((occupancy[row + static_cast<size_t>(x) / 64] >> (x % 64)) & 1) {
+                    expectedBuilder.addLevelZeroLeaf(llf + Vector3i(x, y, z));
+                    numOccupiedVoxels++;
+                }
+            }
+        }
+    }
+
+    // some leafs are added twice
+    builder.addLevelZeroLeaf(llf);
+    expectedBuilder.addLevelZeroLeaf(llf);
+    builder.addLevelZeroLeaf(Vector3i(0));
+    expectedBuilder.addLevelZeroLeaf(Vector3i(0));
+
+    // the out of core builder spills the leafs several times
+    EXPECT_LT(OUT_OF_CORE_MEMORY_BUDGET / sizeof(morton_t), numOccupiedVoxels);
+    EXPECT_EQ(numOccupiedVoxels, builder.addLevelZeroLeafsFromOccupancy(occupancy.data(), size, llf));
+    EXPECT_EQ(numOccupiedVoxels, builder.addLevelZeroLeafsFromOccupancy(occupancy.data(), size, llf));
+
+    auto result = builder.finishBuilding();
+    auto expected = expectedBuilder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    EXPECT_EQ(expectedBuilder.buildStats().numLevelZeroLeafs, builder.buildStats().numLevelZeroLeafs);
+    expectSameLeafs(*expected, *result);
+
+    EXPECT_THROW(builder.addLevelZeroLeafsFromOccupancy(occupancy.data(), size, Vector3i(5, 60, 110)), std::runtime_error);
+    EXPECT_THROW(builder.addLevelZeroLeafsFromOccupancy(occupancy.data(), size, Vector3i(-1, 0, 0)), std::runtime_error);
+    EXPECT_EQ(0, builder.addLevelZeroLeafsFromOccupancy(nullptr, Vector3i(0), Vector3i(0)));
+}
+
+/**
+ * @brief Creates random points in and around the bounding box of the quantization (a few points are NaN)
+ */
+template <typename T>
+static std::vector<T> createRandomPoints(const size_t numPoints, const PointQuantization& quantization, std::default_random_engine& generator) {
+    std::vector<T> xyz;
+    xyz.reserve(3 * numPoints);
+
+    for (size_t i = 0; i < 3 * numPoints; i++) {
+        const double llf = quantization.worldLLF[i % 3];
+        const double urb = quantization.worldURB[i % 3];
+        const double margin = (urb - llf) / 10;
+
+        xyz.push_back(static_cast<T>(std::uniform_real_distribution<double>(llf - margin, urb + margin)(generator)));
+    }
+
+    xyz[7] = std::numeric_limits<T>::quiet_NaN();
+    return xyz;
+}
+
+/**
+ * @brief The leaf of a point (see PointQuantization)
+ */
+static Vector3i quantizePoint(const double* xyz, const PointQuantization& quantization, const Vector3i& maxXYZ) {
+    coord_t leaf[3];
+    for (uint i = 0; i < 3; i++) {
+        const double numLeafs = std::ceil((quantization.worldURB[i] - quantization.worldLLF[i]) / quantization.voxelSize);
+        const double c = std::floor((xyz[i] - quantization.worldLLF[i]) / quantization.voxelSize);
+        const double max = std::min(numLeafs - 1, static_cast<double>(maxXYZ[i]));
+
+        leaf[i] = std::isnan(c) || c < 0 ? 0 : static_cast<coord_t>(std::min(c, max));
+    }
+    return Vector3i(leaf[0], leaf[1], leaf[2]);
+}
+
+TYPED_TEST(LevelZeroLeafInputTest, pointCloudIntegrationTest) {
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+    OctreeBuilder& expectedBuilder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(8181);
+
+    // the bounding box is larger than the octree in z
+    const PointQuantization quantization({-10.5, 2.0, 100.0}, {9.5, 12.0, 200.0}, 0.5);
+    const std::vector<double> doublePoints = createRandomPoints<double>(100000, quantization, generator);
+    const std::vector<float> floatPoints = createRandomPoints<float>(100000, quantization, generator);
+
+    for (size_t i = 0; i < doublePoints.size(); i += 3) {
+        expectedBuilder.addLevelZeroLeaf(quantizePoint(&doublePoints[i], quantization, Vector3i(maxCoord)));
+
+        const double floatPoint[3] = {floatPoints[i], floatPoints[i + 1], floatPoints[i + 2]};
+        expectedBuilder.addLevelZeroLeaf(quantizePoint(floatPoint, quantization, Vector3i(maxCoord)));
+    }
+
+    EXPECT_EQ(100000, builder.addLevelZeroLeafsFromPoints(doublePoints.data(), 100000, quantization));
+    EXPECT_EQ(100000, builder.addLevelZeroLeafsFromPoints(floatPoints.data(), 100000, quantization));
+
+    auto result = builder.finishBuilding();
+    auto expected = expectedBuilder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    EXPECT_EQ(expectedBuilder.buildStats().numLevelZeroLeafs, builder.buildStats().numLevelZeroLeafs);
+    expectSameLeafs(*expected, *result);
+
+    EXPECT_THROW(builder.addLevelZeroLeafsFromPoints(doublePoints.data(), 1, PointQuantization({0, 0, 0}, {1, 1, 1}, 0)), std::runtime_error);
+    EXPECT_THROW(builder.addLevelZeroLeafsFromPoints(doublePoints.data(), 1, PointQuantization({0, 0, 0}, {1, -1, 1}, 1)), std::runtime_error);
+}
+
+/**
+ * @brief Creates the 12 triangles of the surface of an axis aligned cube
+ */
+static void createCubeMesh(const float llf, const float urb, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    for (uint32_t v = 0; v < 8; v++) {
+        vertices.push_back(v & 1 ? urb : llf);
+        vertices.push_back(v & 2 ? urb : llf);
+        vertices.push_back(v & 4 ? urb : llf);
+    }
+
+    // two triangles per face (the corners of a face differ in two of the three bits)
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        const uint32_t a = 1u << ((axis + 1) % 3);
+        const uint32_t b = 1u << ((axis + 2) % 3);
+
+        for (uint32_t side : {0u, 1u << axis}) {
+            indices.insert(indices.end(), {side, side | a, side | a | b});
+            indices.insert(indices.end(), {side, side | a | b, side | b});
+        }
+    }
+}
+
+TYPED_TEST(LevelZeroLeafInputTest, triangleMeshIntegrationTest) {
+    const coord_t maxCoord = 63;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+    OctreeBuilder& expectedBuilder = this->createInstance(Vector3i(maxCoord));
+
+    // the faces are inside of the leafs 10 and 20 (in voxel space the cube spans 10.5 to 20.5)
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    createCubeMesh(5.25f, 10.25f, vertices, indices);
+
+    // a large triangle outside of the bounding box
+    vertices.insert(vertices.end(), {-100.0f, -100.0f, -100.0f, -50.0f, -100.0f, -100.0f, -100.0f, -50.0f, -100.0f});
+    indices.insert(indices.end(), {8, 9, 10});
+
+    const PointQuantization quantization({0, 0, 0}, {32, 32, 32}, 0.5);
+
+    for (const Vector3i& c : VectorSpace(Vector3i(11))) {
+        const Vector3i leaf = c + Vector3i(10);
+        if (c.x() % 10 == 0 || c.y() % 10 == 0 || c.z() % 10 == 0) {
+            expectedBuilder.addLevelZeroLeaf(leaf);
+        }
+    }
+
+    EXPECT_EQ(13, builder.addLevelZeroLeafsFromTriangles(vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3, quantization));
+
+    auto result = builder.finishBuilding();
+    auto expected = expectedBuilder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    EXPECT_EQ(expectedBuilder.buildStats().numLevelZeroLeafs, builder.buildStats().numLevelZeroLeafs);
+    expectSameLeafs(*expected, *result);
+
+    indices.back() = 11;
+    EXPECT_THROW(builder.addLevelZeroLeafsFromTriangles(vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3, quantization),
+                 std::runtime_error);
+
+    // many small random triangles are voxelized in several chunks... the leafs are the same as the leafs of the sequential builder
+    OctreeBuilder& chunkedBuilder = this->createInstance(Vector3i(maxCoord));
+    SequentialOctreeBuilder referenceBuilder{Vector3i(maxCoord)};
+
+    std::default_random_engine generator(4343);
+    std::uniform_real_distribution<float> coordinateDistribution(0.0f, 64.0f);
+    std::uniform_real_distribution<float> offsetDistribution(-2.0f, 2.0f);
+
+    std::vector<float> randomVertices;
+    std::vector<uint32_t> randomIndices;
+    for (uint32_t t = 0; t < 1500; t++) {
+        const float c[3] = {coordinateDistribution(generator), coordinateDistribution(generator), coordinateDistribution(generator)};
+        for (uint32_t v = 0; v < 3; v++) {
+            for (uint32_t i = 0; i < 3; i++) {
+                randomVertices.push_back(c[i] + offsetDistribution(generator));
+            }
+            randomIndices.push_back(3 * t + v);
+        }
+    }
+
+    const PointQuantization randomQuantization({0, 0, 0}, {64, 64, 64}, 1.0);
+    const size_t numLeafs =
+        referenceBuilder.addLevelZeroLeafsFromTriangles(randomVertices.data(), randomVertices.size() / 3, randomIndices.data(), 1500, randomQuantization);
+    EXPECT_EQ(numLeafs,
+              chunkedBuilder.addLevelZeroLeafsFromTriangles(randomVertices.data(), randomVertices.size() / 3, randomIndices.data(), 1500, randomQuantization));
+
+    auto chunkedResult = chunkedBuilder.finishBuilding();
+    auto reference = referenceBuilder.finishBuilding();
+
+    EXPECT_LT(OUT_OF_CORE_MEMORY_BUDGET / sizeof(morton_t), referenceBuilder.buildStats().numLevelZeroLeafs);
+    EXPECT_EQ(referenceBuilder.buildStats().numLevelZeroLeafs, chunkedBuilder.buildStats().numLevelZeroLeafs);
+    expectSameLeafs(*reference, *chunkedResult);
+}
+
+TYPED_TEST(LevelZeroLeafInputTest, signedDistanceIntegrationTest) {
+    const coord_t maxCoord = 63;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+    OctreeBuilder& expectedBuilder = this->createInstance(Vector3i(maxCoord));
+
+    // a sphere which is cut by the bounding of the octree
+    const std::array<double, 3> center = {40.3, 35.7, 50.1};
+    const double radius = 20.0;
+    auto distance = [&center, radius](const std::array<double, 3>& p) {
+        return std::sqrt((p[0] - center[0]) * (p[0] - center[0]) + (p[1] - center[1]) * (p[1] - center[1]) + (p[2] - center[2]) * (p[2] - center[2])) -
+               radius;
+    };
+
+    size_t numExpectedLeafs = 0;
+    for (const Vector3i& c : VectorSpace(Vector3i(maxCoord + 1))) {
+        if (std::abs(distance({static_cast<double>(c.x()), static_cast<double>(c.y()), static_cast<double>(c.z())})) < 1.5) {
+            expectedBuilder.addLevelZeroLeaf(c);
+            numExpectedLeafs++;
+        }
+    }
+
+    // only the octants near the surface are evaluated
+    std::atomic<size_t> numCalls(0);
+    EXPECT_EQ(numExpectedLeafs, builder.addLevelZeroLeafsFromSignedDistance(
+                                    [&](const std::array<double, 3>& p) {
+                                        numCalls++;
+                                        return distance(p);
+                                    },
+                                    1.0, 1.5));
+    EXPECT_LT(numCalls, static_cast<size_t>(maxCoord * maxCoord * maxCoord / 4));
+
+    // a scaled distance with the scaled bound finds the same leafs
+    EXPECT_EQ(numExpectedLeafs,
+              builder.addLevelZeroLeafsFromSignedDistance([&](const std::array<double, 3>& p) { return 2.5 * distance(p); }, 2.5, 2.5 * 1.5));
+
+    auto result = builder.finishBuilding();
+    auto expected = expectedBuilder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    EXPECT_EQ(numExpectedLeafs, builder.buildStats().numLevelZeroLeafs);
+    expectSameLeafs(*expected, *result);
+
+    EXPECT_THROW(builder.addLevelZeroLeafsFromSignedDistance(distance, 0.0, 1.0), std::runtime_error);
+    EXPECT_THROW(builder.addLevelZeroLeafsFromSignedDistance(distance, 1.0, -1.0), std::runtime_error);
+}
+
+TYPED_TEST(OctreeBuilderTest, addLeafAboveLevelZeroTest) {
+    OctreeBuilder& builder = this->createInstance(Vector3i(15));
+
+    // a single leaf of level 2... only its siblings and the siblings of its parent are created
+    builder.addLeaf(Vector3i(0), 2);
+
+    std::unique_ptr<Octree> tree(builder.finishBuilding());
+
+    ASSERT_EQ(Octree::OctreeState::VALID, tree->checkState());
+    EXPECT_EQ(15, tree->getNumNodes());
+    EXPECT_EQ(OctreeNode(Vector3i(0), 2), tree->getNode(0));
+
+    EXPECT_THROW(builder.addLeaf(Vector3i(2, 0, 0), 2), std::runtime_error);
+    EXPECT_THROW(builder.addLeaf(Vector3i(16, 0, 0), 0), std::runtime_error);
+    EXPECT_THROW(builder.addLeaf(Vector3i(0), 5), std::runtime_error);
+}
+
+TYPED_TEST(OctreeBuilderTest, addLeafAboveLevelZeroIntegrationTest) {
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+    OctreeBuilder& cappedBuilder = this->createInstance(Vector3i(maxCoord), 2);
+    SequentialOctreeBuilder expectedBuilder((Vector3i(maxCoord)));
+
+    std::default_random_engine generator(6262);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    std::uniform_int_distribution<uint> levelDistribution(0, 4);
+
+    // leafs of random levels (some of them contain others)
+    std::vector<std::pair<Vector3i, uint>> leafs;
+    for (size_t i = 0; i < 400; i++) {
+        const uint level = levelDistribution(generator);
+        const coord_t mask = ~(getOctantSizeForLevel(level) - 1);
+        const Vector3i llf(coordinateDistribution(generator) & mask, coordinateDistribution(generator) & mask, coordinateDistribution(generator) & mask);
+
+        EXPECT_EQ(getMortonCodeForCoordinate(llf), builder.addLeaf(llf, level));
+        cappedBuilder.addLeaf(llf, level);
+        expectedBuilder.addLeaf(llf, level);
+        leafs.push_back(std::make_pair(llf, level));
+    }
+
+    auto result = builder.finishBuilding();
+    auto capped = cappedBuilder.finishBuilding();
+    auto expected = expectedBuilder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    ASSERT_EQ(Octree::OctreeState::VALID, capped->checkState());
+    EXPECT_GE(2, capped->getMaxLevel());
+
+    expectSameLeafs(*expected, *result);
+
+    // the node at the llf of each added leaf is the leaf itself or a descendant (hence the leaf is covered by nodes of its level or below)
+    std::vector<morton_t> mortonCodes;
+    for (size_t i = 0; i < result->getNumNodes(); i++) {
+        mortonCodes.push_back(result->getNode(i).getMortonEncodedLLF());
+    }
+
+    size_t numRetainedLeafs = 0;
+    for (const std::pair<Vector3i, uint>& leaf : leafs) {
+        auto it = std::lower_bound(mortonCodes.begin(), mortonCodes.end(), getMortonCodeForCoordinate(leaf.first));
+        ASSERT_NE(mortonCodes.end(), it);
+
+        const OctreeNode node = result->getNode(static_cast<size_t>(it - mortonCodes.begin()));
+        ASSERT_EQ(leaf.first, node.getLLF());
+        ASSERT_LE(node.getLevel(), leaf.second);
+
+        if (node.getLevel() == leaf.second) {
+            numRetainedLeafs++;
+        }
+    }
+    EXPECT_LT(0, numRetainedLeafs);
+}
+
+TYPED_TEST(OctreeBuilderTest, leafSinkIntegrationTest) {
+    const coord_t maxCoord = 127;
+
+    OctreeBuilder& builder = this->createInstance(Vector3i(maxCoord));
+
+    std::default_random_engine generator(5151);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 2000; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    auto expected = builder.finishBuilding();
+    const size_t expectedNumLeafs = builder.buildStats().numLeafs;
+
+    std::vector<OctreeNode> leafs;
+    size_t numChunks = 0;
+    builder.finishBuilding([&](const OctreeNode* chunk, size_t numLeafs) {
+        ASSERT_LT(0, numLeafs);
+        leafs.insert(leafs.end(), chunk, chunk + numLeafs);
+        numChunks++;
+    });
+
+    EXPECT_EQ(expectedNumLeafs, builder.buildStats().numLeafs);
+    EXPECT_LE(1, numChunks);
+    ASSERT_EQ(expected->getNumNodes(), leafs.size());
+    for (size_t i = 0; i < leafs.size(); i++) {
+        ASSERT_EQ(expected->getNode(i), leafs[i]);
+    }
+
+    // the exception of the sink is passed to the caller, the sink isn't called anymore
+    size_t numCalls = 0;
+    EXPECT_THROW(builder.finishBuilding([&](const OctreeNode*, size_t) {
+        numCalls++;
+        throw std::runtime_error("sink failed");
+    }),
+                 std::runtime_error);
+    EXPECT_EQ(1, numCalls);
+}
+
+TEST(ParallelOctreeBuilderTest, leafSinkMemoryIntegrationTest) {
+    const coord_t maxCoord = 127;
+
+    ParallelOctreeBuilder builder{Vector3i(maxCoord)};
+
+    std::default_random_engine generator(6262);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 5000; i++) {
+        builder.addLevelZeroLeaf(Vector3i(genCoord(), genCoord(), genCoord()));
+    }
+
+    builder.finishBuilding();
+    const size_t octreePeakBytes = builder.buildStats().peakLiveBytes();
+
+    // only the boundary octants and the subtrees of the current blocks are stored
+    builder.finishBuilding([](const OctreeNode*, size_t) {});
+    EXPECT_LT(builder.buildStats().peakLiveBytes(), octreePeakBytes / 2);
+}
+
+class OutOfCoreOctreeBuilderTest : public TemporaryFilesTest {};
+
+TEST_F(OutOfCoreOctreeBuilderTest, outOfCoreIntegrationTest) {
+    const coord_t maxCoord = 63;
+    const std::string outputPath = createTemporaryPath(".octree");
+    const std::string leafsPath = createTemporaryPath(".xyz");
+
+    const Vector3i maxXYZ(maxCoord);
+
+    // a small budget... many runs and pieces of neighbourhoods
+    const size_t memoryBudget = 256 * 1024;
+    OutOfCoreOctreeBuilder builder(maxXYZ, outputPath, memoryBudget, ".");
+    ParallelOctreeBuilder expectedBuilder(maxXYZ);
+
+    std::default_random_engine generator(9091);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    for (size_t i = 0; i < 50000; i++) {
+        const Vector3i c(genCoord(), genCoord(), genCoord());
+        builder.addLevelZeroLeaf(c);
+        expectedBuilder.addLevelZeroLeaf(c);
+    }
+
+    {
+        std::ofstream file(leafsPath, std::ios::binary);
+        for (size_t i = 0; i < 50000; i++) {
+            const int32_t xyz[3] = {static_cast<int32_t>(genCoord()), static_cast<int32_t>(genCoord()), static_cast<int32_t>(genCoord())};
+            file.write(reinterpret_cast<const char*>(xyz), sizeof(xyz));
+            expectedBuilder.addLevelZeroLeaf(Vector3i(xyz[0], xyz[1], xyz[2]));
+        }
+    }
+    EXPECT_EQ(50000, builder.addLevelZeroLeafsFromFile(leafsPath, LevelZeroLeafFileFormat::INT32_XYZ));
+
+    auto expected = expectedBuilder.finishBuilding();
+
+    for (size_t repetition = 0; repetition < 2; repetition++) {
+        auto result = builder.finishBuilding();
+
+        // one level at a time
+        EXPECT_EQ(getOctreeDepthForBounding(maxXYZ), builder.buildStats().subtreeBuildLoad.blocks.size());
+        EXPECT_EQ(expectedBuilder.buildStats().numLevelZeroLeafs, builder.buildStats().numLevelZeroLeafs);
+        EXPECT_LE(builder.buildStats().peakLiveBytes(), memoryBudget);
+        EXPECT_EQ(Octree::OctreeState::VALID, result->checkState());
+
+        expectSameLeafs(*expected, *result);
+    }
+
+    // the leafs passed to a sink are the same... without creating the output file
+    std::remove(outputPath.c_str());
+
+    size_t numLeafs = 0;
+    builder.finishBuilding([&](const OctreeNode* chunk, size_t numLeafsOfChunk) {
+        for (size_t i = 0; i < numLeafsOfChunk; i++) {
+            ASSERT_EQ(expected->getNode(numLeafs), chunk[i]);
+            numLeafs++;
+        }
+    });
+
+    EXPECT_EQ(expected->getNumNodes(), numLeafs);
+    EXPECT_EQ(numLeafs, builder.buildStats().numLeafs);
+    EXPECT_LE(builder.buildStats().peakLiveBytes(), memoryBudget);
+    EXPECT_FALSE(std::ifstream(outputPath).good());
+}
+
+TEST_F(OutOfCoreOctreeBuilderTest, mergeManyRunsIntegrationTest) {
+    const coord_t maxCoord = 63;
+    const std::string outputPath = createTemporaryPath(".octree");
+    const std::string tempDirectory = createTemporaryPath(".temp");
+    ASSERT_EQ(0, ::mkdir(tempDirectory.c_str(), 0700));
+
+    const Vector3i maxXYZ(maxCoord);
+    ParallelOctreeBuilder expectedBuilder(maxXYZ);
+
+    {
+        // the buffer holds 1536 leafs and 11 runs are merged at once... the 40000 leafs are spilled to 27 runs which are merged in several passes
+        OutOfCoreOctreeBuilder builder(maxXYZ, outputPath, OUT_OF_CORE_MEMORY_BUDGET, tempDirectory);
+
+        std::default_random_engine generator(1313);
+        std::uniform_int_distribution<coord_t> coordinateDistribution(0, maxCoord);
+        auto genCoord = std::bind(coordinateDistribution, generator);
+
+        for (size_t i = 0; i < 40000; i++) {
+            const Vector3i c(genCoord(), genCoord(), genCoord());
+            builder.addLevelZeroLeaf(c);
+            expectedBuilder.addLevelZeroLeaf(c);
+        }
+
+        auto expected = expectedBuilder.finishBuilding();
+
+        // the runs are kept for the next finishBuilding
+        for (size_t repetition = 0; repetition < 2; repetition++) {
+            auto result = builder.finishBuilding();
+
+            EXPECT_EQ(expectedBuilder.buildStats().numLevelZeroLeafs, builder.buildStats().numLevelZeroLeafs);
+            EXPECT_LE(builder.buildStats().peakLiveBytes(), OUT_OF_CORE_MEMORY_BUDGET);
+            expectSameLeafs(*expected, *result);
+        }
+    }
+
+    // the builder removed all temporary files (the intermediate runs too)
+    EXPECT_EQ(0, ::rmdir(tempDirectory.c_str()));
+}
+
+TEST_F(OutOfCoreOctreeBuilderTest, maxLevelIntegrationTest) {
+    const Vector3i maxXYZ(40, 20, 33);
+
+    std::default_random_engine generator(4242);
+    std::uniform_int_distribution<coord_t> coordinateDistribution(0, 20);
+    auto genCoord = std::bind(coordinateDistribution, generator);
+
+    // the octree is filled with leafs of the max level (or is only the root without leafs)
+    for (const size_t numLeafs : {0, 500}) {
+        for (const uint maxLevel : {0u, 2u, 4u}) {
+            SequentialOctreeBuilder expectedBuilder(maxXYZ, 0, maxLevel);
+            OutOfCoreOctreeBuilder builder(maxXYZ, createTemporaryPath(".octree"), OUT_OF_CORE_MEMORY_BUDGET, ".", maxLevel);
+
+            for (size_t i = 0; i < numLeafs; i++) {
+                const Vector3i c(genCoord(), genCoord(), genCoord());
+                builder.addLevelZeroLeaf(c);
+                expectedBuilder.addLevelZeroLeaf(c);
+            }
+
+            auto expected = expectedBuilder.finishBuilding();
+            auto result = builder.finishBuilding();
+
+            EXPECT_EQ(Octree::OctreeState::VALID, result->checkState());
+            expectSameLeafs(*expected, *result);
+        }
+    }
+}
+
+TEST_F(OutOfCoreOctreeBuilderTest, addLeafTest) {
+    OutOfCoreOctreeBuilder builder(Vector3i(15), createTemporaryPath(".octree"), OUT_OF_CORE_MEMORY_BUDGET, ".");
+
+    // the runs only store leafs of level zero
+    EXPECT_EQ(getMortonCodeForCoordinate(Vector3i(1, 2, 3)), builder.addLeaf(Vector3i(1, 2, 3), 0));
+    EXPECT_THROW(builder.addLeaf(Vector3i(0), 1), std::runtime_error);
+
+    auto result = builder.finishBuilding();
+
+    ASSERT_EQ(Octree::OctreeState::VALID, result->checkState());
+    EXPECT_EQ(1, builder.buildStats().numLevelZeroLeafs);
+}
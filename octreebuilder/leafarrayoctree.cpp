@@ -0,0 +1,703 @@
+#include "leafarrayoctree.h"
+
+#include "mappedoctree.h"
+#include "octree_impl.h"
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <assert.h>
+#include <limits>
+#include <stdexcept>
+
+#include "mortoncode_utils.h"
+#include "parallel_stable_sort.h"
+
+namespace octreebuilder {
+
+template <typename Derived>
+LeafArrayOctree<Derived>::LeafArrayOctree(uint depth) : m_bounds(OctantID(0, depth)), m_bounding(getMaxXYZForOctreeDepth(depth)) {
+}
+
+template <typename Derived>
+Vector3i LeafArrayOctree<Derived>::getMaxXYZ() const {
+    return m_bounding.urb();
+}
+
+template <typename Derived>
+uint LeafArrayOctree<Derived>::getDepth() const {
+    return m_bounds.depth();
+}
+
+template <typename Derived>
+uint LeafArrayOctree<Derived>::getMaxLevel() const {
+    for (uint level = getDepth(); level > 0; level--) {
+        if (m_numLeafsPerLevel.at(level) > 0) {
+            return level;
+        }
+    }
+
+    if (!m_numLeafsPerLevel.empty() && m_numLeafsPerLevel.front() > 0) {
+        return 0;
+    }
+
+    throw ::std::runtime_error("Can't determine the maximum level of an empty octree.");
+}
+
+template <typename Derived>
+OctreeNode LeafArrayOctree<Derived>::getNode(const size_t& i) const {
+    if (i >= getNumNodes()) {
+        throw ::std::out_of_range("LeafArrayOctree::getNode: Invalid parameter i out of range.");
+    }
+
+    const OctantID octant = derived().leaf(i);
+
+    OctreeNode n(octant.mcode(), octant.level());
+
+    return n;
+}
+
+template <typename Derived>
+OctreeNode LeafArrayOctree<Derived>::tryGetNodeAt(const Vector3i& llf, uint level) const {
+    // levels without leafs (e.g. above the max level) don't need a lookup
+    if (level >= m_numLeafsPerLevel.size() || m_numLeafsPerLevel[level] == 0) {
+        return OctreeNode();
+    }
+
+    morton_t mcode = getMortonCodeForCoordinate(llf);
+
+    if (derived().hasNode(OctantID(mcode, level))) {
+        return OctreeNode(mcode, level);
+    }
+
+    return OctreeNode();
+}
+
+template <typename Derived>
+::std::vector<OctreeNode> LeafArrayOctree<Derived>::getNeighbourNodesInDirection(const OctreeNode& n, const Vector3i& direction) const {
+    ::std::vector<OctreeNode> neighbourNodes;
+
+    if (n.getLevel() == getDepth()) {
+        // n is root node... no neighbours (note: this should rarely happen as it means that the tree is empty)
+        return neighbourNodes;
+    }
+
+    // we only have to check 3 levels for neighbours: the parent level, the same level and the child level (in respect to n's level)
+    // (this is because the level difference of adjacent nodes must never be greater 1)
+
+    // check for neighbours on the same level
+    Vector3i neighbourLLF = n.getLLF() + direction * n.getSize();
+
+    if (!m_bounding.contains(neighbourLLF)) {
+        // if the direct neighbour of n (wether it exists or not) is outside of the tree then neither the neighbours on the child level nor
+        // on the parent level are inside the tree and hence can't exist
+        return neighbourNodes;
+    }
+
+    OctantID possibleNeighbour(neighbourLLF, n.getLevel());
+
+    if (derived().hasNode(possibleNeighbour)) {
+        neighbourNodes.push_back(OctreeNode(possibleNeighbour.mcode(), possibleNeighbour.level()));
+        return neighbourNodes;
+    }
+
+    OctantID possibleParentNeighbour = possibleNeighbour.parent();
+
+    if (derived().hasNode(possibleParentNeighbour)) {
+        neighbourNodes.push_back(OctreeNode(possibleParentNeighbour.mcode(), possibleParentNeighbour.level()));
+        return neighbourNodes;
+    }
+
+    if (n.getLevel() == 0) {
+        throw ::std::runtime_error("Invalid parameter 'n' or invalid octree.");
+    }
+
+    // check child level... obviously the neighbours at the child level must be children of the neighbour node at n's level.
+    // Only the children that touch n are neighbours: 4 at a face, 2 at an edge and 1 at a vertex.
+    const ::std::array<morton_t, 8> possibleChildren = getMortonCodesForChildren(possibleNeighbour.mcode(), possibleNeighbour.level());
+    const uint childLevel = n.getLevel() - 1;
+
+    neighbourNodes.reserve(4);
+    for (size_t index = 0; index < possibleChildren.size(); index++) {
+        // the child index encodes the position of the child inside its parent (see getMortonCodesForChildren)
+        const Vector3i childPosition(index & 4 ? 1 : 0, index & 2 ? 1 : 0, index & 1 ? 1 : 0);
+
+        bool touchesN = true;
+        for (uint axis = 0; axis < 3; axis++) {
+            // a child touches n if it lies at the side of the neighbour that faces n (or the axis is not part of the direction)
+            if ((direction[axis] < 0 && childPosition[axis] == 0) || (direction[axis] > 0 && childPosition[axis] == 1)) {
+                touchesN = false;
+                break;
+            }
+        }
+
+        if (!touchesN) {
+            continue;
+        }
+
+        const morton_t childNeighbourCode = possibleChildren.at(index);
+
+        if (!derived().hasNode(OctantID(childNeighbourCode, childLevel))) {
+            // a neighbour must exist in a valid tree (we have checked above that n is not at the boundary)... since
+            // neither a neighbour on the same level nor on the parent level exists there must be
+            // neighbours at the child level
+            throw ::std::runtime_error("Invalid parameter 'n' or invalid octree.");
+        }
+
+        neighbourNodes.push_back(OctreeNode(childNeighbourCode, childLevel));
+    }
+
+    return neighbourNodes;
+}
+
+template <typename Derived>
+::std::vector<OctreeNode> LeafArrayOctree<Derived>::getNeighbourNodes(const OctreeNode& n, OctreeNode::Face sharedFace) const {
+    return getNeighbourNodesInDirection(n, OctreeNode::getNormalOfFace(sharedFace));
+}
+
+template <typename Derived>
+::std::vector<OctreeNode> LeafArrayOctree<Derived>::getNeighbourNodes(const OctreeNode& n, OctreeNode::Edge sharedEdge) const {
+    return getNeighbourNodesInDirection(n, OctreeNode::getDirectionOfEdge(sharedEdge));
+}
+
+template <typename Derived>
+::std::vector<OctreeNode> LeafArrayOctree<Derived>::getNeighbourNodes(const OctreeNode& n, OctreeNode::Vertex sharedVertex) const {
+    return getNeighbourNodesInDirection(n, OctreeNode::getDirectionOfVertex(sharedVertex));
+}
+
+template <typename Derived>
+::std::vector<OctreeNode> LeafArrayOctree<Derived>::getAllNeighbourNodes(const OctreeNode& n) const {
+    ::std::vector<OctreeNode> neighbourNodes;
+    neighbourNodes.reserve(26);
+
+    for (coord_t x = -1; x <= 1; x++) {
+        for (coord_t y = -1; y <= 1; y++) {
+            for (coord_t z = -1; z <= 1; z++) {
+                const Vector3i direction(x, y, z);
+
+                if (direction == Vector3i(0)) {
+                    continue;
+                }
+
+                const ::std::vector<OctreeNode> neighboursInDirection = getNeighbourNodesInDirection(n, direction);
+                neighbourNodes.insert(neighbourNodes.end(), neighboursInDirection.begin(), neighboursInDirection.end());
+            }
+        }
+    }
+
+    // A neighbour of the parent level can touch n at a face and some of its edges and vertices... hence remove duplicates
+    ::std::sort(neighbourNodes.begin(), neighbourNodes.end(), [](const OctreeNode& a, const OctreeNode& b) {
+        return OctantID(a.getMortonEncodedLLF(), a.getLevel()) < OctantID(b.getMortonEncodedLLF(), b.getLevel());
+    });
+    neighbourNodes.erase(::std::unique(neighbourNodes.begin(), neighbourNodes.end()), neighbourNodes.end());
+
+    return neighbourNodes;
+}
+
+template <typename Derived>
+::std::vector<::std::vector<OctreeNode>> LeafArrayOctree<Derived>::getAllNeighbourNodesOfAllNodes() const {
+    ::std::vector<::std::vector<OctreeNode>> neighbourNodesOfAllNodes(getNumNodes());
+
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t i = 0; i < neighbourNodesOfAllNodes.size(); i++) {
+        neighbourNodesOfAllNodes[i] = getAllNeighbourNodes(getNode(i));
+    }
+
+    return neighbourNodesOfAllNodes;
+}
+
+template <typename Derived>
+VertexNumbering LeafArrayOctree<Derived>::computeVertexNumbering() const {
+    const size_t numLeafs = getNumNodes();
+
+    if (!fitsInMortonCode(Vector3i(getOctantSizeForLevel(getDepth())))) {
+        throw ::std::runtime_error("Can't number the vertices of the octree. The vertices at its upper bounds can't be morton encoded.");
+    }
+
+    VertexNumbering result;
+
+    // Compute the morton encoded vertices of each node (in the order of OctreeNode::Vertex)
+    ::std::vector<morton_t> nodeVertexCodes(8 * numLeafs);
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < numLeafs; i++) {
+        const OctantID octant = derived().leaf(i);
+        const Vector3i llf = octant.coord();
+        const coord_t size = getOctantSizeForLevel(octant.level());
+
+        for (size_t v = 0; v < 8; v++) {
+            const Vector3i vertex = llf + Vector3i(v & 4 ? size : 0, v & 2 ? size : 0, v & 1 ? size : 0);
+            nodeVertexCodes[8 * i + v] = getMortonCodeForCoordinate(vertex);
+        }
+    }
+
+    // The unique vertices are the sorted vertex codes without duplicates
+    result.vertices = nodeVertexCodes;
+    pss::parallel_stable_sort(result.vertices.begin(), result.vertices.end());
+    result.vertices.erase(::std::unique(result.vertices.begin(), result.vertices.end()), result.vertices.end());
+
+    result.nodeVertices.resize(nodeVertexCodes.size());
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < nodeVertexCodes.size(); i++) {
+        auto it = ::std::lower_bound(result.vertices.begin(), result.vertices.end(), nodeVertexCodes[i]);
+        assert(it != result.vertices.end() && *it == nodeVertexCodes[i]);
+        result.nodeVertices[i] = static_cast<size_t>(it - result.vertices.begin());
+    }
+
+    nodeVertexCodes = ::std::vector<morton_t>();
+
+    // In a 2:1 balanced tree a hanging vertex is always the midpoint of an edge or a face of a node whose
+    // adjacent nodes are of the next lower level. Hence we only have to search for the 12 edge midpoints
+    // and the 6 face midpoints of each node in the list of vertices.
+    result.isHanging.assign(result.vertices.size(), false);
+    ::std::vector<size_t> hangingVertices;
+
+#pragma omp parallel
+    {
+        ::std::vector<size_t> hangingVerticesOfThread;
+
+#pragma omp for schedule(static)
+        for (size_t i = 0; i < numLeafs; i++) {
+            const OctantID octant = derived().leaf(i);
+            if (octant.level() == 0) {
+                continue;
+            }
+
+            const Vector3i llf = octant.coord();
+            const coord_t halfSize = getOctantSizeForLevel(octant.level() - 1);
+
+            for (coord_t x = 0; x < 3; x++) {
+                for (coord_t y = 0; y < 3; y++) {
+                    for (coord_t z = 0; z < 3; z++) {
+                        const int numMidCoordinates = (x == 1 ? 1 : 0) + (y == 1 ? 1 : 0) + (z == 1 ? 1 : 0);
+
+                        if (numMidCoordinates == 0 || numMidCoordinates == 3) {
+                            // a vertex or the center of the node
+                            continue;
+                        }
+
+                        const morton_t midpoint = getMortonCodeForCoordinate(llf + Vector3i(x, y, z) * halfSize);
+                        auto it = ::std::lower_bound(result.vertices.begin(), result.vertices.end(), midpoint);
+
+                        if (it != result.vertices.end() && *it == midpoint) {
+                            hangingVerticesOfThread.push_back(static_cast<size_t>(it - result.vertices.begin()));
+                        }
+                    }
+                }
+            }
+        }
+
+#pragma omp critical
+        hangingVertices.insert(hangingVertices.end(), hangingVerticesOfThread.begin(), hangingVerticesOfThread.end());
+    }
+
+    for (const size_t& vertex : hangingVertices) {
+        result.isHanging[vertex] = true;
+    }
+
+    return result;
+}
+
+template <typename Derived>
+bool LeafArrayOctree<Derived>::findLeafContaining(const Vector3i& voxel, uint minLevel, uint maxLevel, OctantID& leaf) const {
+    const morton_t voxelCode = getMortonCodeForCoordinate(voxel);
+
+    for (uint level = minLevel; level <= maxLevel; level++) {
+        const OctantID candidate(voxelCode & (~morton_t(0) << 3 * level), level);
+        if (derived().hasNode(candidate)) {
+            leaf = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief The index of the first leaf that isn't less than octant (getNumNodes() if there is none)
+ */
+template <typename Leaf>
+static size_t indexOfLowerBound(const size_t numLeafs, const OctantID& octant, const Leaf& leaf) {
+    size_t first = 0;
+    size_t count = numLeafs;
+
+    while (count > 0) {
+        const size_t step = count / 2;
+        if (leaf(first + step) < octant) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+template <typename Derived>
+size_t LeafArrayOctree<Derived>::indexOfLeaf(const OctantID& octant) const {
+    const size_t index = indexOfLowerBound(getNumNodes(), octant, [this](const size_t i) { return derived().leaf(i); });
+    assert(index < getNumNodes() && derived().leaf(index) == octant);
+
+    return index;
+}
+
+template <typename Derived>
+bool LeafArrayOctree<Derived>::maximumLowerBound(const OctantID& octant, OctantID& lowerBound) const {
+    const size_t index = indexOfLowerBound(getNumNodes(), octant, [this](const size_t i) { return derived().leaf(i); });
+
+    if (index == 0) {
+        return false;
+    }
+
+    lowerBound = derived().leaf(index - 1);
+
+    return true;
+}
+
+static bool isNullVector(const ::std::array<double, 3>& v) {
+    return !(v[0] < 0 || v[0] > 0 || v[1] < 0 || v[1] > 0 || v[2] < 0 || v[2] > 0);
+}
+
+/**
+ * @brief The level zero octant that the ray enters at point (on the boundary of the octant if the ray leaves another octant there)
+ */
+static Vector3i getVoxelEnteredAt(const ::std::array<double, 3>& point, const ::std::array<double, 3>& direction) {
+    ::std::array<coord_t, 3> voxel;
+    for (uint i = 0; i < 3; i++) {
+        if (direction[i] < 0) {
+            voxel[i] = static_cast<coord_t>(::std::ceil(point[i])) - 1;
+        } else {
+            voxel[i] = static_cast<coord_t>(::std::floor(point[i]));
+        }
+    }
+    return Vector3i(voxel[0], voxel[1], voxel[2]);
+}
+
+/**
+ * @brief The leaf cache of a packet has 2^LEAF_CACHE_BITS slots
+ */
+static const uint LEAF_CACHE_BITS = 10;
+
+/**
+ * @brief The number of consecutive rays traced by one thread
+ */
+static const size_t RAYS_PER_PACKET = 64;
+
+template <typename Derived>
+class LeafArrayOctree<Derived>::LeafCache {
+public:
+    LeafCache() : m_entries(size_t(1) << LEAF_CACHE_BITS) {
+    }
+
+    /**
+     * @brief Finds a leaf of the cache that contains the level zero octant at voxel
+     */
+    bool find(const Vector3i& voxel, uint minLevel, uint maxLevel, OctantID& leaf, size_t& index) const {
+        const morton_t voxelCode = getMortonCodeForCoordinate(voxel);
+
+        // the candidates are nested and the leafs don't overlap... a cached candidate is the leaf no matter which level is checked first
+        for (uint level = minLevel; level <= maxLevel; level++) {
+            const OctantID candidate(voxelCode & (~morton_t(0) << 3 * level), level);
+            const Entry& entry = m_entries[slot(candidate)];
+            if (entry.index != EMPTY && entry.leaf == candidate) {
+                leaf = candidate;
+                index = entry.index;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Adds the leaf (replaces the leaf of its slot)
+     */
+    void insert(const OctantID& leaf, size_t index) {
+        Entry& entry = m_entries[slot(leaf)];
+        entry.leaf = leaf;
+        entry.index = index;
+    }
+
+private:
+    static const size_t EMPTY = ::std::numeric_limits<size_t>::max();
+
+    struct Entry {
+        OctantID leaf;
+        size_t index = EMPTY;
+    };
+
+    static size_t slot(const OctantID& octant) {
+        // fibonacci hashing... the high bits of the product depend on all bits of the code
+        const uint64_t hash = (octant.mcode() + octant.level()) * UINT64_C(0x9E3779B97F4A7C15);
+        return static_cast<size_t>(hash >> (64 - LEAF_CACHE_BITS));
+    }
+
+    ::std::vector<Entry> m_entries;
+};
+
+template <typename Derived>
+bool LeafArrayOctree<Derived>::findLeafContaining(const Vector3i& voxel, uint minLevel, uint maxLevel, LeafCache* cache, OctantID& leaf,
+                                                  size_t& index) const {
+    if (cache != nullptr && cache->find(voxel, minLevel, maxLevel, leaf, index)) {
+        return true;
+    }
+
+    if (!findLeafContaining(voxel, minLevel, maxLevel, leaf)) {
+        return false;
+    }
+
+    index = indexOfLeaf(leaf);
+    if (cache != nullptr) {
+        cache->insert(leaf, index);
+    }
+
+    return true;
+}
+
+template <typename Derived>
+RayTraversal LeafArrayOctree<Derived>::traceRay(const Ray& ray) const {
+    return traceRay(ray, nullptr);
+}
+
+template <typename Derived>
+RayTraversal LeafArrayOctree<Derived>::traceRay(const Ray& ray, LeafCache* cache) const {
+    const ::std::array<double, 3>& o = ray.origin;
+    const ::std::array<double, 3>& d = ray.direction;
+
+    if (isNullVector(d)) {
+        throw ::std::runtime_error("Invalid ray: The direction must not be the null vector.");
+    }
+
+    RayTraversal traversal;
+
+    if (getNumNodes() == 0) {
+        return traversal;
+    }
+
+    const coord_t treeSize = getOctantSizeForLevel(getDepth());
+
+    // Clip the ray against the bounding cube of the tree
+    double tEnter = 0;
+    double tLeave = ::std::numeric_limits<double>::infinity();
+    for (uint i = 0; i < 3; i++) {
+        if (d[i] > 0) {
+            tEnter = ::std::max(tEnter, -o[i] / d[i]);
+            tLeave = ::std::min(tLeave, (static_cast<double>(treeSize) - o[i]) / d[i]);
+        } else if (d[i] < 0) {
+            tEnter = ::std::max(tEnter, (static_cast<double>(treeSize) - o[i]) / d[i]);
+            tLeave = ::std::min(tLeave, -o[i] / d[i]);
+        } else if (o[i] < 0 || !(o[i] < static_cast<double>(treeSize))) {
+            return traversal;
+        }
+    }
+
+    if (!(tEnter < tLeave)) {
+        return traversal;
+    }
+
+    ::std::array<double, 3> point;
+    for (uint i = 0; i < 3; i++) {
+        point[i] = ::std::min(::std::max(o[i] + tEnter * d[i], 0.0), static_cast<double>(treeSize));
+    }
+
+    const Vector3i firstVoxel = getVoxelEnteredAt(point, d);
+    const Vector3i maxVoxel(treeSize - 1);
+
+    OctantID leaf;
+    size_t leafIndex;
+    if (!findLeafContaining(max(Vector3i(0), min(firstVoxel, maxVoxel)), 0, getDepth(), cache, leaf, leafIndex)) {
+        throw ::std::runtime_error("Invalid octree: The octree doesn't contain a leaf at the entry point of the ray.");
+    }
+
+    double t = tEnter;
+    for (;;) {
+        const Vector3i llf = leaf.coord();
+        const coord_t size = getOctantSizeForLevel(leaf.level());
+
+        // The ray parameters where the ray leaves the slabs of the leaf
+        ::std::array<double, 3> tSlab;
+        for (uint i = 0; i < 3; i++) {
+            if (d[i] > 0) {
+                tSlab[i] = (static_cast<double>(llf[i] + size) - o[i]) / d[i];
+            } else if (d[i] < 0) {
+                tSlab[i] = (static_cast<double>(llf[i]) - o[i]) / d[i];
+            } else {
+                tSlab[i] = ::std::numeric_limits<double>::infinity();
+            }
+        }
+        const double tSlabMin = ::std::min(tSlab[0], ::std::min(tSlab[1], tSlab[2]));
+        const double tExit = ::std::max(t, tSlabMin);
+
+        traversal.nodeIndices.push_back(leafIndex);
+        traversal.entry.push_back(t);
+        traversal.exit.push_back(tExit);
+
+        // The exit point is on the boundary of the leaf: use the exact face coordinates for the slabs that are left
+        for (uint i = 0; i < 3; i++) {
+            if (!(tSlab[i] > tSlabMin)) {
+                point[i] = static_cast<double>(d[i] > 0 ? llf[i] + size : llf[i]);
+            } else {
+                point[i] = ::std::min(::std::max(o[i] + tExit * d[i], static_cast<double>(llf[i])), static_cast<double>(llf[i] + size));
+            }
+        }
+
+        const Vector3i voxel = getVoxelEnteredAt(point, d);
+        if (voxel != max(Vector3i(0), min(voxel, maxVoxel))) {
+            // left the tree
+            break;
+        }
+
+        // The next leaf touches the current leaf at the exit point, hence (2:1 balance) its level differs by at most one
+        const uint minLevel = leaf.level() > 0 ? leaf.level() - 1 : 0;
+        const uint maxLevel = ::std::min(leaf.level() + 1, getDepth());
+        if (!findLeafContaining(voxel, minLevel, maxLevel, cache, leaf, leafIndex)) {
+            throw ::std::runtime_error("Invalid octree: The octree isn't complete or balanced.");
+        }
+
+        t = tExit;
+    }
+
+    return traversal;
+}
+
+template <typename Derived>
+::std::vector<RayTraversal> LeafArrayOctree<Derived>::traceRayBatch(const ::std::vector<Ray>& rays) const {
+    for (const Ray& ray : rays) {
+        if (isNullVector(ray.direction)) {
+            throw ::std::runtime_error("Invalid ray: The direction must not be the null vector.");
+        }
+    }
+
+    // Build the lookup structure before the threads start to trace
+    derived().prepareNodeLookup();
+
+    ::std::vector<RayTraversal> traversals(rays.size());
+    const size_t numPackets = (rays.size() + RAYS_PER_PACKET - 1) / RAYS_PER_PACKET;
+
+#pragma omp parallel
+    {
+        // the leafs are immutable... the cache of a thread stays valid for all of its packets
+        LeafCache cache;
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t packet = 0; packet < numPackets; packet++) {
+            const size_t end = ::std::min(rays.size(), (packet + 1) * RAYS_PER_PACKET);
+            for (size_t i = packet * RAYS_PER_PACKET; i < end; i++) {
+                traversals[i] = traceRay(rays[i], &cache);
+            }
+        }
+    }
+
+    return traversals;
+}
+
+/**
+ * @brief Evaluates hasFailed for all indices in [0, n) in parallel and returns the smallest index for which hasFailed is true
+ * @return The smallest failed index or n if there is none
+ *
+ * The indices are processed in ordered chunks. A thread stops as soon as a failure at a smaller index is known to all threads,
+ * hence the work after the first failure is small while the result is the same as for a sequential search.
+ */
+template <typename Predicate>
+static size_t parallelFindFirst(const size_t n, const Predicate& hasFailed) {
+    constexpr size_t chunkSize = 4096;
+    const size_t numChunks = (n + chunkSize - 1) / chunkSize;
+
+    ::std::atomic<size_t> firstFailed(n);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t chunk = 0; chunk < numChunks; chunk++) {
+        const size_t end = ::std::min(n, (chunk + 1) * chunkSize);
+
+        for (size_t i = chunk * chunkSize; i < end && i < firstFailed.load(::std::memory_order_relaxed); i++) {
+            if (!hasFailed(i)) {
+                continue;
+            }
+
+            size_t currentFirstFailed = firstFailed.load();
+            while (i < currentFirstFailed && !firstFailed.compare_exchange_weak(currentFirstFailed, i)) {
+            }
+            break;
+        }
+    }
+
+    return firstFailed.load();
+}
+
+template <typename Derived>
+Octree::OctreeState LeafArrayOctree<Derived>::checkState() const {
+    if (getDepth() == 0) {
+        return Octree::OctreeState::VALID;
+    }
+
+    const size_t numLeafs = getNumNodes();
+
+    // Check sorted
+    if (numLeafs > 0) {
+        const size_t numPairs = numLeafs - 1;
+
+        if (parallelFindFirst(numPairs, [this](const size_t i) { return derived().leaf(i) > derived().leaf(i + 1); }) < numPairs) {
+            return Octree::OctreeState::UNSORTED;
+        }
+    }
+
+    // Check complete and not overlapping
+    if (numLeafs == 0 || derived().leaf(0).mcode() != 0) {
+        return Octree::OctreeState::INCOMPLETE;
+    }
+
+    const OctantID lastLeaf = derived().leaf(numLeafs - 1);
+    if (getMortonCodeForDeepestLastDecendant(lastLeaf.mcode(), lastLeaf.level()) != m_bounds.deepestLastDecendant().mcode()) {
+        return Octree::OctreeState::INCOMPLETE;
+    }
+
+    // In a complete linear octree each octant directly follows the deepest last decendant of its predecessor
+    auto nextExpectedMortonCode = [this](const size_t i) {
+        const OctantID octant = derived().leaf(i);
+        return getMortonCodeForDeepestLastDecendant(octant.mcode(), octant.level()) + 1;
+    };
+
+    const size_t numPairs = numLeafs - 1;
+    const size_t firstGap = parallelFindFirst(
+        numPairs, [this, &nextExpectedMortonCode](const size_t i) { return derived().leaf(i + 1).mcode() != nextExpectedMortonCode(i); });
+
+    if (firstGap < numPairs) {
+        if (derived().leaf(firstGap + 1).mcode() > nextExpectedMortonCode(firstGap)) {
+            return Octree::OctreeState::INCOMPLETE;
+        }
+        return Octree::OctreeState::OVERLAPPING;
+    }
+
+    // Check balanced
+    auto isUnbalanced = [this](const size_t i) {
+        const OctantID octant = derived().leaf(i);
+
+        for (const OctantID& searchKey : octant.getSearchKeys(m_bounds)) {
+            OctantID neighbour;
+            if (!maximumLowerBound(searchKey, neighbour) || !searchKey.isDecendantOf(neighbour)) {
+                continue;
+            }
+
+            if ((neighbour.level() > octant.level() && neighbour.level() - octant.level() > 1) ||
+                (neighbour.level() < octant.level() && octant.level() - neighbour.level() > 1)) {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    if (parallelFindFirst(numLeafs, isUnbalanced) < numLeafs) {
+        return Octree::OctreeState::UNBALANCED;
+    }
+
+    return Octree::OctreeState::VALID;
+}
+
+// the only octrees on top of a leaf array (see LeafArrayOctree)
+template class LeafArrayOctree<OctreeImpl>;
+template class LeafArrayOctree<MappedOctree>;
+}
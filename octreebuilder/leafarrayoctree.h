@@ -0,0 +1,123 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+#include "octree.h"
+#include "box.h"
+#include "linearoctree.h"
+#include "octantid.h"
+#include "ray.h"
+
+#include <vector>
+
+namespace octreebuilder {
+
+/**
+ * @brief Implements the queries of an octree on top of a sorted array of leafs
+ *
+ * The subclass Derived provides the storage of the leafs (in the order of OctantID) and the lookup of a node:
+ *  - OctantID leaf(size_t i) const: The i-th leaf (i < getNumNodes())
+ *  - bool hasNode(const OctantID& octant) const: Checks whether the octant (inside the tree bounds) is a leaf of the tree
+ *  - void prepareNodeLookup() const: Called before many threads start to call hasNode, e.g. to create a lookup structure (optional)
+ *
+ * The queries call them without a virtual call per probed octant. The template is instantiated for OctreeImpl and MappedOctree.
+ */
+template <typename Derived>
+class OCTREEBUILDER_API LeafArrayOctree : public Octree {
+public:
+    virtual Vector3i getMaxXYZ() const override;
+
+    virtual uint getDepth() const override;
+
+    virtual uint getMaxLevel() const override;
+
+    virtual OctreeNode getNode(const size_t& i) const override;
+
+    virtual OctreeNode tryGetNodeAt(const Vector3i& llf, uint level) const override;
+
+    virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Face sharedFace) const override;
+
+    virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Edge sharedEdge) const override;
+
+    virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Vertex sharedVertex) const override;
+
+    virtual ::std::vector<OctreeNode> getAllNeighbourNodes(const OctreeNode& n) const override;
+
+    virtual ::std::vector<::std::vector<OctreeNode>> getAllNeighbourNodesOfAllNodes() const override;
+
+    virtual VertexNumbering computeVertexNumbering() const override;
+
+    virtual RayTraversal traceRay(const Ray& ray) const override;
+
+    virtual ::std::vector<RayTraversal> traceRayBatch(const ::std::vector<Ray>& rays) const override;
+
+    virtual OctreeState checkState() const override;
+
+protected:
+    /**
+     * @param depth The depth of the octree
+     */
+    explicit LeafArrayOctree(uint depth);
+
+    /**
+     * @brief The number of leafs of each level (must be filled by the subclass)
+     */
+    ::std::vector<size_t> m_numLeafsPerLevel;
+
+    /**
+     * @brief Does nothing (the default if Derived needs no lookup structure)
+     */
+    void prepareNodeLookup() const {
+    }
+
+private:
+    const Derived& derived() const {
+        return static_cast<const Derived&>(*this);
+    }
+
+    /**
+     * @brief Finds the neighbours of n in direction (each component of direction must be -1, 0 or 1)
+     *
+     * The neighbours touch n at the face, edge or vertex selected by direction.
+     */
+    ::std::vector<OctreeNode> getNeighbourNodesInDirection(const OctreeNode& n, const Vector3i& direction) const;
+
+    /**
+     * @brief Finds the leaf that contains the level zero octant at voxel
+     * @param voxel The llf of the level zero octant
+     * @param minLevel The minimum level of the candidate leafs
+     * @param maxLevel The maximum level of the candidate leafs
+     * @param leaf On success will refer to the leaf when the function returns. Otherwise the reference will be unchanged.
+     * @return true If one of the candidates is a leaf, false otherwise
+     */
+    bool findLeafContaining(const Vector3i& voxel, uint minLevel, uint maxLevel, OctantID& leaf) const;
+
+    /**
+     * @brief The index of the leaf in the linear tree
+     */
+    size_t indexOfLeaf(const OctantID& leaf) const;
+
+    /**
+     * @brief The leafs found by the rays of a packet and their indices (see traceRayBatch)
+     */
+    class LeafCache;
+
+    /**
+     * @brief Like findLeafContaining, but also returns the index of the leaf (the leafs of the cache are checked first if it isn't null)
+     */
+    bool findLeafContaining(const Vector3i& voxel, uint minLevel, uint maxLevel, LeafCache* cache, OctantID& leaf, size_t& index) const;
+
+    /**
+     * @brief See traceRay (the leafs are looked up in the cache first if it isn't null)
+     */
+    RayTraversal traceRay(const Ray& ray, LeafCache* cache) const;
+
+    /**
+     * @brief See LinearOctree::maximumLowerBound
+     */
+    bool maximumLowerBound(const OctantID& octant, OctantID& lowerBound) const;
+
+    // a tree without leafs (defines the bounds for the octant operations)
+    LinearOctree m_bounds;
+    Box m_bounding;
+};
+}
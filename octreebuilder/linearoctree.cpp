@@ -30,6 +30,10 @@ LinearOctree::LinearOctree(const OctantID& root, const container_type& leafs) :
     m_deepestLastDecendant = OctantID(getMaxXYZForOctreeDepth(root.level()) + root.coord(), 0);
 }
 
+LinearOctree::LinearOctree(const OctantID& root, container_type&& leafs) : m_root(root), m_leafs(::std::move(leafs)) {
+    m_deepestLastDecendant = OctantID(getMaxXYZForOctreeDepth(root.level()) + root.coord(), 0);
+}
+
 LinearOctree::LinearOctree(const OctantID& root, const size_t& numLeafs) : m_root(root) {
     m_deepestLastDecendant = OctantID(getMaxXYZForOctreeDepth(root.level()) + root.coord(), 0);
     m_leafs.reserve(numLeafs);
@@ -32,6 +32,13 @@ public:
      */
     LinearOctree(const OctantID& root, const container_type& leafs = {});
 
+    /**
+     * @brief Creates an linear octree taking over the leafs
+     * @param root The root of the octree
+     * @param leafs The leafs of the octree
+     */
+    LinearOctree(const OctantID& root, container_type&& leafs);
+
     /**
      * @brief Creates an empty linear octree
      * @param root The root of the octree
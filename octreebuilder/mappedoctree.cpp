@@ -0,0 +1,93 @@
+#include "mappedoctree.h"
+
+#include "checksum.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace octreebuilder {
+
+MappedOctree::MappedOctree(const ::std::string& path, bool verifyChecksums)
+    : MappedOctree(MemoryMappedFile(path, MemoryMappedFile::AccessPattern::RANDOM), verifyChecksums) {
+}
+
+// the header is read before the delegated constructor takes over the file
+MappedOctree::MappedOctree(MemoryMappedFile&& file, bool verifyChecksums) : MappedOctree(::std::move(file), octreefile::readHeader(file), verifyChecksums) {
+}
+
+MappedOctree::MappedOctree(MemoryMappedFile&& file, const octreefile::Header& header, bool verifyChecksums)
+    : LeafArrayOctree(header.depth), m_file(::std::move(file)), m_header(header) {
+    verifyHeader(m_file, m_header);
+
+    const octreefile::Layout layout(m_header);
+
+    m_codes = reinterpret_cast<const uint64_t*>(m_file.data() + layout.codesOffset);
+    m_levels = reinterpret_cast<const uint8_t*>(m_file.data() + layout.levelsOffset);
+
+    m_numLeafsPerLevel.assign(m_header.numLeafsPerLevel, m_header.numLeafsPerLevel + m_header.depth + 1);
+
+    if (verifyChecksums) {
+        this->verifyChecksums();
+    }
+}
+
+void MappedOctree::verifyHeader(const MemoryMappedFile& file, const octreefile::Header& header) {
+    if (header.isCompressed()) {
+        throw ::std::runtime_error("The octree file " + file.path() + " is compressed and can't be mapped (use readOctreeFile).");
+    }
+
+    if (octreefile::Layout(header).fileSize != file.size()) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The file size doesn't match the number of leafs.");
+    }
+}
+
+void MappedOctree::verifyChecksums() const {
+    if (!m_header.hasChecksums()) {
+        return;
+    }
+
+    const octreefile::Layout layout(m_header);
+    const size_t numBlocks = static_cast<size_t>(m_header.numBlocks());
+
+    const uint32_t* checksums = reinterpret_cast<const uint32_t*>(m_file.data() + layout.checksumsOffset);
+    m_file.advise(MemoryMappedFile::AccessPattern::SEQUENTIAL, 0, m_file.size());
+
+    ::std::atomic<bool> valid(true);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t block = 0; block < numBlocks; block++) {
+        const size_t first = block * m_header.blockSize;
+        const size_t numLeafsOfBlock = ::std::min<size_t>(m_header.blockSize, m_header.numLeafs - first);
+
+        uint32_t crc = crc32(m_codes + first, numLeafsOfBlock * sizeof(uint64_t));
+        crc = crc32(m_levels + first, numLeafsOfBlock, crc);
+
+        if (crc != checksums[block]) {
+            valid = false;
+        }
+    }
+
+    m_file.advise(MemoryMappedFile::AccessPattern::RANDOM, 0, m_file.size());
+
+    if (!valid) {
+        throw ::std::runtime_error("Invalid octree file " + m_file.path() + ": The checksum of the leafs doesn't match.");
+    }
+}
+
+size_t MappedOctree::getNumNodes() const {
+    return static_cast<size_t>(m_header.numLeafs);
+}
+
+OctantID MappedOctree::leaf(size_t i) const {
+    return OctantID(m_codes[i], m_levels[i]);
+}
+
+bool MappedOctree::hasNode(const OctantID& octant) const {
+    // the morton codes of the leafs of a valid octree are unique
+    const uint64_t* end = m_codes + getNumNodes();
+    const uint64_t* it = ::std::lower_bound(m_codes, end, octant.mcode());
+
+    return it != end && *it == octant.mcode() && m_levels[it - m_codes] == octant.level();
+}
+}
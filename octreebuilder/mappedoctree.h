@@ -0,0 +1,58 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+#include "leafarrayoctree.h"
+#include "memorymappedfile.h"
+#include "octreefileformat.h"
+
+#include <string>
+
+namespace octreebuilder {
+
+/**
+ * @brief An octree that answers all queries on a memory mapped binary octree file (see octreefile.h)
+ *
+ * Nodes are looked up by a binary search over the mapped morton codes.
+ */
+class OCTREEBUILDER_API MappedOctree : public LeafArrayOctree<MappedOctree> {
+public:
+    /**
+     * @brief Maps the file and verifies its header
+     * @param verifyChecksums Whether to verify the checksums of all leafs (reads the whole file in parallel)
+     * @throws ::std::runtime_error If the file can't be mapped, isn't a valid binary octree file or a checksum doesn't match
+     */
+    MappedOctree(const ::std::string& path, bool verifyChecksums);
+
+    /**
+     * @brief Takes over a mapped file whose header was already read
+     * @param file The mapped file
+     * @param header The header of the file (see octreefile::readHeader)
+     * @param verifyChecksums Whether to verify the checksums of all leafs (reads the whole file in parallel)
+     * @throws ::std::runtime_error If the file isn't a valid uncompressed binary octree file or a checksum doesn't match
+     */
+    MappedOctree(MemoryMappedFile&& file, const octreefile::Header& header, bool verifyChecksums);
+
+    virtual size_t getNumNodes() const override;
+
+private:
+    MappedOctree(MemoryMappedFile&& file, bool verifyChecksums);
+
+    friend class LeafArrayOctree<MappedOctree>;
+
+    OctantID leaf(size_t i) const;
+
+    bool hasNode(const OctantID& octant) const;
+
+    /**
+     * @brief Verifies that the file can be mapped with the header
+     */
+    static void verifyHeader(const MemoryMappedFile& file, const octreefile::Header& header);
+
+    void verifyChecksums() const;
+
+    MemoryMappedFile m_file;
+    octreefile::Header m_header;
+    const uint64_t* m_codes;
+    const uint8_t* m_levels;
+};
+}
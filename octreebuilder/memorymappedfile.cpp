@@ -0,0 +1,202 @@
+#include "memorymappedfile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace octreebuilder {
+
+#ifdef _WIN32
+
+static ::std::string lastErrorMessage() {
+    return "error " + ::std::to_string(::GetLastError());
+}
+
+MemoryMappedFile::MemoryMappedFile(const ::std::string& path, AccessPattern accessPattern) : m_path(path), m_data(nullptr), m_size(0) {
+    const DWORD flags = accessPattern == AccessPattern::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN
+                                                                   : (accessPattern == AccessPattern::RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL);
+    const HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw ::std::runtime_error("Can't open " + path + ": " + lastErrorMessage());
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(file, &fileSize)) {
+        const ::std::string error = lastErrorMessage();
+        ::CloseHandle(file);
+        throw ::std::runtime_error("Can't determine the size of " + path + ": " + error);
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+
+    if (m_size > 0) {
+        const HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* data = mapping != nullptr ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        const ::std::string error = lastErrorMessage();
+
+        // the view stays valid after the mapping and the file are closed
+        if (mapping != nullptr) {
+            ::CloseHandle(mapping);
+        }
+
+        if (data == nullptr) {
+            ::CloseHandle(file);
+            m_size = 0;
+            throw ::std::runtime_error("Can't map " + path + " into memory: " + error);
+        }
+        m_data = static_cast<char*>(data);
+    }
+
+    ::CloseHandle(file);
+}
+
+void MemoryMappedFile::unmap() {
+    if (m_data != nullptr) {
+        ::UnmapViewOfFile(m_data);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+void MemoryMappedFile::advise(AccessPattern, size_t, size_t) const {
+    // Windows only takes the access pattern as a hint when the file is opened
+}
+
+void MemoryMappedFile::release(size_t offset, size_t length) const {
+    if (m_data == nullptr || offset >= m_size || length == 0) {
+        return;
+    }
+
+    // unlocking pages that aren't locked removes them from the working set of the process (errors can be ignored)
+    ::VirtualUnlock(m_data + offset, ::std::min(length, m_size - offset));
+}
+
+#else
+
+static int toAdvice(const MemoryMappedFile::AccessPattern accessPattern) {
+    switch (accessPattern) {
+        case MemoryMappedFile::AccessPattern::RANDOM:
+            return MADV_RANDOM;
+        case MemoryMappedFile::AccessPattern::SEQUENTIAL:
+            return MADV_SEQUENTIAL;
+        case MemoryMappedFile::AccessPattern::NORMAL:
+            break;
+    }
+    return MADV_NORMAL;
+}
+
+MemoryMappedFile::MemoryMappedFile(const ::std::string& path, AccessPattern accessPattern) : m_path(path), m_data(nullptr), m_size(0) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw ::std::runtime_error("Can't open " + path + ": " + ::std::strerror(errno));
+    }
+
+    struct stat fileStatus;
+    if (::fstat(fd, &fileStatus) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw ::std::runtime_error("Can't determine the size of " + path + ": " + ::std::strerror(error));
+    }
+
+    m_size = static_cast<size_t>(fileStatus.st_size);
+
+    if (m_size > 0) {
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            const int error = errno;
+            ::close(fd);
+            throw ::std::runtime_error("Can't map " + path + " into memory: " + ::std::strerror(error));
+        }
+        m_data = static_cast<char*>(data);
+    }
+
+    // the mapping stays valid after the file is closed
+    ::close(fd);
+
+    if (accessPattern != AccessPattern::NORMAL) {
+        advise(accessPattern, 0, m_size);
+    }
+}
+
+void MemoryMappedFile::unmap() {
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+/**
+ * @brief Calls madvise for the pages that are completely or partly within [offset, offset + length)
+ */
+static void adviseRange(char* data, const size_t size, size_t offset, size_t length, const int advice) {
+    if (data == nullptr || offset >= size || length == 0) {
+        return;
+    }
+
+    length = ::std::min(length, size - offset);
+
+    // madvise requires a page aligned address
+    const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t alignedOffset = offset - offset % pageSize;
+
+    // the advice is only a hint... errors can be ignored
+    ::madvise(data + alignedOffset, length + (offset - alignedOffset), advice);
+}
+
+void MemoryMappedFile::advise(AccessPattern accessPattern, size_t offset, size_t length) const {
+    adviseRange(m_data, m_size, offset, length, toAdvice(accessPattern));
+}
+
+void MemoryMappedFile::release(size_t offset, size_t length) const {
+    adviseRange(m_data, m_size, offset, length, MADV_DONTNEED);
+}
+
+#endif
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) : m_path(::std::move(other.m_path)), m_data(other.m_data), m_size(other.m_size) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) {
+    if (this != &other) {
+        unmap();
+        m_path = ::std::move(other.m_path);
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    unmap();
+}
+
+const ::std::string& MemoryMappedFile::path() const {
+    return m_path;
+}
+
+const char* MemoryMappedFile::data() const {
+    return m_data;
+}
+
+size_t MemoryMappedFile::size() const {
+    return m_size;
+}
+}
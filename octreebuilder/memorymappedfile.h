@@ -0,0 +1,65 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include <cstddef>
+#include <string>
+
+namespace octreebuilder {
+
+/**
+ * @brief A read only memory mapping of a whole file
+ *
+ * The pages are loaded by the operating system on first access. Hence mapping a large file is almost free.
+ */
+class OCTREEBUILDER_API MemoryMappedFile {
+public:
+    /**
+     * @brief Hints for the operating system how the mapping will be accessed (see madvise)
+     */
+    enum class AccessPattern { NORMAL, RANDOM, SEQUENTIAL };
+
+    /**
+     * @brief Maps the file into memory
+     * @throws ::std::runtime_error If the file can't be opened or mapped
+     */
+    explicit MemoryMappedFile(const ::std::string& path, AccessPattern accessPattern = AccessPattern::NORMAL);
+
+    MemoryMappedFile(MemoryMappedFile&& other);
+    MemoryMappedFile& operator=(MemoryMappedFile&& other);
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    ~MemoryMappedFile();
+
+    const ::std::string& path() const;
+
+    /**
+     * @brief The first byte of the file (nullptr for an empty file)
+     */
+    const char* data() const;
+
+    /**
+     * @brief The size of the file in bytes
+     */
+    size_t size() const;
+
+    /**
+     * @brief Changes the access hint for the bytes [offset, offset + length) of the file
+     */
+    void advise(AccessPattern accessPattern, size_t offset, size_t length) const;
+
+    /**
+     * @brief Tells the operating system that the bytes [offset, offset + length) won't be accessed in the near future (their pages can be dropped)
+     */
+    void release(size_t offset, size_t length) const;
+
+private:
+    void unmap();
+
+    ::std::string m_path;
+    char* m_data;
+    size_t m_size;
+};
+}
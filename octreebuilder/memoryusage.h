@@ -0,0 +1,101 @@
+#pragma once
+
+#include "buildstats.h"
+#include "linearoctree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace octreebuilder {
+
+/**
+ * @brief The estimated heap memory of a vector (its capacity)
+ */
+template <typename T, typename Allocator>
+size_t memoryUsage(const ::std::vector<T, Allocator>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+/**
+ * @brief The estimated heap memory of a hash set with the given number of buckets and elements (one node per element with a next pointer and the
+ * cached hash)
+ */
+template <typename T>
+size_t hashSetMemoryUsage(size_t bucketCount, size_t size) {
+    return bucketCount * sizeof(void*) + size * (sizeof(T) + sizeof(void*) + sizeof(size_t));
+}
+
+/**
+ * @brief The estimated heap memory of a hash set (see hashSetMemoryUsage)
+ */
+template <typename T, typename Hash, typename Equal, typename Allocator>
+size_t memoryUsage(const ::std::unordered_set<T, Hash, Equal, Allocator>& s) {
+    return hashSetMemoryUsage<T>(s.bucket_count(), s.size());
+}
+
+/**
+ * @brief The estimated heap memory of a hash map (see memoryUsage of a hash set)
+ */
+template <typename K, typename V, typename Hash, typename Equal, typename Allocator>
+size_t memoryUsage(const ::std::unordered_map<K, V, Hash, Equal, Allocator>& m) {
+    return m.bucket_count() * sizeof(void*) + m.size() * (sizeof(typename ::std::unordered_map<K, V, Hash, Equal, Allocator>::value_type) + sizeof(void*) + sizeof(size_t));
+}
+
+/**
+ * @brief The estimated heap memory of the leafs of a linear octree
+ */
+inline size_t memoryUsage(const LinearOctree& octree) {
+    return memoryUsage(octree.leafs());
+}
+
+/**
+ * @brief The estimated heap memory of a vector of containers (the vector and all containers)
+ */
+template <typename Container>
+size_t memoryUsageOfAll(const ::std::vector<Container>& containers) {
+    size_t bytes = memoryUsage(containers);
+    for (const Container& container : containers) {
+        bytes += memoryUsage(container);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Records the estimated memory of the containers owned by one build in its statistics
+ *
+ * Instead of counting every allocation the build samples the sizes of its containers (see memoryUsage) at the phase boundaries,
+ * hence the hot loops are unaffected. The tracker belongs to a single build, so concurrent builds don't affect each other.
+ */
+class MemoryTracker {
+public:
+    /**
+     * @param stats The statistics of the build. The bytes that were live at the end of the phases recorded so far stay live.
+     */
+    explicit MemoryTracker(BuildStats& stats) : m_stats(stats), m_baseBytes(stats.liveBytes()), m_phasePeak(m_baseBytes) {
+    }
+
+    /**
+     * @brief Records that the bytes are live (in addition to the base bytes) at some point of the current phase
+     */
+    void sample(size_t bytes) {
+        m_phasePeak = ::std::max(m_phasePeak, m_baseBytes + bytes);
+    }
+
+    /**
+     * @brief Adds the memory of the current phase to the statistics, the bytes are live at the end of the phase (see sample)
+     */
+    void recordPhase(const BuildStats::Phase& phase, size_t bytes) {
+        sample(bytes);
+        m_stats.addPhaseMemory(phase, MemoryStats(m_phasePeak, m_baseBytes + bytes));
+        m_phasePeak = m_baseBytes + bytes;
+    }
+
+private:
+    BuildStats& m_stats;
+    size_t m_baseBytes;
+    size_t m_phasePeak;
+};
+}
@@ -126,7 +126,7 @@ constexpr uint32_t z_component_lut[256] = {
 morton_t getMortonCodeForCoordinate(const Vector3i& coordinate) {
     morton_t mcode =
         x_component_lut[(coordinate.x() >> 16) & 0xFF] | y_component_lut[(coordinate.y() >> 16) & 0xFF] | z_component_lut[(coordinate.z() >> 16) & 0xFF];
-    mcode = mcode << 48 | x_component_lut[(coordinate.x() >> 8) & 0xFF] | y_component_lut[(coordinate.y() >> 8) & 0xFF] |
+    mcode = mcode << 24 | x_component_lut[(coordinate.x() >> 8) & 0xFF] | y_component_lut[(coordinate.y() >> 8) & 0xFF] |
             z_component_lut[(coordinate.z() >> 8) & 0xFF];
     mcode = mcode << 24 | x_component_lut[(coordinate.x()) & 0xFF] | y_component_lut[(coordinate.y()) & 0xFF] | z_component_lut[(coordinate.z()) & 0xFF];
     return mcode;
@@ -181,6 +181,12 @@ morton_t getMortonCodeForAncestor(const morton_t& current_code, const uint& curr
     return parentLevelCode;
 }
 
+morton_t getMortonCodeForDeepestLastDecendant(const morton_t& octant, const uint& level) {
+    // All bits below the level of the octant are set for its deepest last decendant
+    morton_t lowerLevelsBitMask = ~(morton_t(-1) << 3 * level);
+    return octant | lowerLevelsBitMask;
+}
+
 ::std::array<morton_t, 8> getMortonCodesForChildren(const morton_t& parent, const uint& parentLevel) {
     if (parentLevel == 0) {
         throw ::std::runtime_error("Leaf octants can't have children.");
@@ -68,6 +68,16 @@ OCTREEBUILDER_API morton_t getMortonCodeForParent(const morton_t& current_code,
  */
 OCTREEBUILDER_API morton_t getMortonCodeForAncestor(const morton_t& current_code, const uint& currentLevel, const uint& ancestorLevel);
 
+/**
+ * @brief Computes the level zero octant with the maximal morton code inside the octant
+ * @param octant The morton encoded llf of the octant
+ * @param level The level of the octant in the octree
+ * @return The morton code of the deepest last decendant of the octant (the octant itself for level 0)
+ *
+ * The octant following the octant in a complete linear octree has the morton code getMortonCodeForDeepestLastDecendant(octant, level) + 1.
+ */
+OCTREEBUILDER_API morton_t getMortonCodeForDeepestLastDecendant(const morton_t& octant, const uint& level);
+
 /**
  * @brief Computes the morton encoded children of the octant
  * @param parent The morton encoded llf of the parent octant on the parentLevel (or any morton encoded coordinate within this octant)
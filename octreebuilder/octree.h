@@ -2,6 +2,7 @@
 
 #include "octreebuilder_api.h"
 #include "octreenode.h"
+#include "ray.h"
 
 #include "vector3i.h"
 
@@ -13,6 +14,30 @@ namespace octreebuilder {
 
 class LinearOctree;
 
+/**
+ * @brief The unique vertices of all nodes of an octree
+ */
+struct OCTREEBUILDER_API VertexNumbering {
+    /**
+     * @brief The morton encoded coordinates of all unique node vertices in ascending order
+     */
+    ::std::vector<morton_t> vertices;
+
+    /**
+     * @brief The indices (into vertices) of the 8 vertices of each node
+     *
+     * The vertices of the i-th node are stored at [8 * i, 8 * i + 8) in the order of OctreeNode::Vertex.
+     */
+    ::std::vector<size_t> nodeVertices;
+
+    /**
+     * @brief Whether a vertex is hanging
+     *
+     * A vertex is hanging if it lies on an edge or a face of a node without being one of that node's vertices.
+     */
+    ::std::vector<bool> isHanging;
+};
+
 /**
  * @brief An octree datastructure
  *
@@ -66,6 +91,60 @@ public:
      */
     virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Face sharedFace) const = 0;
 
+    /**
+     * @brief Find the neighbour node(s) of n at sharedEdge
+     * @param n The node whose neighbours should be found
+     * @param sharedEdge The edge of n that is shared (completely or partly) with each neighbour node
+     * @return A list of 0 (no neighbours), 1 or 2 nodes that are neighbours of n at sharedEdge (and only touch n at that edge)
+     */
+    virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Edge sharedEdge) const = 0;
+
+    /**
+     * @brief Find the neighbour node of n at sharedVertex
+     * @param n The node whose neighbour should be found
+     * @param sharedVertex The vertex of n that is shared with the neighbour node
+     * @return A list of 0 (no neighbour) or 1 node that touches n only at sharedVertex
+     */
+    virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Vertex sharedVertex) const = 0;
+
+    /**
+     * @brief Find all nodes that share at least one vertex with n (face, edge and vertex neighbours)
+     * @param n The node whose neighbours should be found
+     * @return The neighbours of n without duplicates, ordered by their morton code
+     */
+    virtual ::std::vector<OctreeNode> getAllNeighbourNodes(const OctreeNode& n) const = 0;
+
+    /**
+     * @brief Finds the neighbours of all nodes in parallel
+     * @return The i-th entry contains getAllNeighbourNodes(getNode(i))
+     */
+    virtual ::std::vector<::std::vector<OctreeNode>> getAllNeighbourNodesOfAllNodes() const = 0;
+
+    /**
+     * @brief Numbers the vertices of all nodes and detects hanging vertices (in parallel)
+     * @return The unique vertices, the vertices of each node and the hanging vertex flags
+     * @note Requires a valid octree (see checkState). Throws an error if the vertices of the tree can't be morton encoded.
+     */
+    virtual VertexNumbering computeVertexNumbering() const = 0;
+
+    /**
+     * @brief Finds the nodes hit by the ray (steps from node to node through the octree)
+     * @param ray The ray. Its origin may be outside of the octree.
+     * @return The indices of the nodes hit by the ray together with the ray parameters at which each node is entered and left.
+     *         The traversal is empty if the ray misses the octree.
+     * @note Requires a valid octree (see checkState). Throws an error if the ray direction is the null vector.
+     */
+    virtual RayTraversal traceRay(const Ray& ray) const = 0;
+
+    /**
+     * @brief Traces a batch of rays in parallel (see traceRay)
+     * @param rays The rays
+     * @return The i-th entry contains traceRay(rays[i])
+     * @note Consecutive rays are traced as a packet by one thread, the packet shares the leafs it has found. Coherent rays (e.g. of neighbouring
+     * pixels) should be adjacent in the batch.
+     */
+    virtual ::std::vector<RayTraversal> traceRayBatch(const ::std::vector<Ray>& rays) const = 0;
+
     enum class OctreeState { VALID, INCOMPLETE, OVERLAPPING, UNSORTED, UNBALANCED };
 
     /**
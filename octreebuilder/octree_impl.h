@@ -1,18 +1,19 @@
 #pragma once
 
-#pragma once
-
 #include "octreebuilder_api.h"
-#include "octree.h"
-#include "box.h"
+#include "leafarrayoctree.h"
 #include "linearoctree.h"
 
 #include <vector>
 #include <unordered_set>
+#include <mutex>
 
 namespace octreebuilder {
 
-class OCTREEBUILDER_API OctreeImpl : public Octree {
+/**
+ * @brief An octree that keeps its leafs in memory (as a linear octree)
+ */
+class OCTREEBUILDER_API OctreeImpl : public LeafArrayOctree<OctreeImpl> {
 public:
     OctreeImpl(::std::vector<::std::unordered_set<morton_t>> tree);
 
@@ -22,26 +23,32 @@ public:
      */
     OctreeImpl(LinearOctree&& linearOctree);
 
-    virtual Vector3i getMaxXYZ() const override;
-
-    virtual uint getDepth() const override;
+    virtual size_t getNumNodes() const override;
 
-    virtual uint getMaxLevel() const override;
+    /**
+     * @brief The estimated heap memory of the lookup structure for nodes (see memoryusage.h)
+     *
+     * The lookup structure is filled on the first lookup, builders add it to the peak memory of the build.
+     */
+    size_t nodeLookupBytes() const;
 
-    virtual size_t getNumNodes() const override;
+private:
+    friend class LeafArrayOctree<OctreeImpl>;
 
-    virtual OctreeNode getNode(const size_t& i) const override;
+    OctantID leaf(size_t i) const;
 
-    virtual OctreeNode tryGetNodeAt(const Vector3i& llf, uint level) const override;
+    bool hasNode(const OctantID& octant) const;
 
-    virtual ::std::vector<OctreeNode> getNeighbourNodes(const OctreeNode& n, OctreeNode::Face sharedFace) const override;
+    void prepareNodeLookup() const;
 
-    virtual OctreeState checkState() const override;
+    /**
+     * @brief The lookup structure for nodes (morton codes grouped by level). Created on first use (thread-safe).
+     */
+    const ::std::vector<::std::unordered_set<morton_t>>& tree() const;
 
-private:
-    // morton codes grouped by level
-    ::std::vector<::std::unordered_set<morton_t>> m_tree;
+    // morton codes grouped by level (use tree() for access)
+    mutable ::std::vector<::std::unordered_set<morton_t>> m_tree;
+    mutable ::std::once_flag m_treeInitialized;
     LinearOctree m_linearTree;
-    Box m_bounding;
 };
 }
@@ -8,14 +8,25 @@
 #include <assert.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <exception>
 #include <omp.h>
 
+#include "memoryusage.h"
 #include "perfcounter.h"
+#include "tracer.h"
 #include <iostream>
 
 namespace octreebuilder {
 
 LinearOctree balanceTree(const LinearOctree& octree) {
+    size_t numSplits = 0;
+    return balanceTree(octree, numSplits);
+}
+
+LinearOctree balanceTree(const LinearOctree& octree, size_t& numSplits) {
+    numSplits = 0;
+
     LinearOctree result = octree;
 
     if (octree.depth() < 3) {
@@ -37,6 +48,10 @@ LinearOctree balanceTree(const LinearOctree& octree) {
     // The maximum level is octree.depth() - 1. Consequently nodes with level octree.depth() - 3 are the last ones that can have a
     // higher level neighbour with a level difference of more than 1.
     for (uint currentLevel = 0; currentLevel < numLevelsToCheck; currentLevel++) {
+        TraceScope levelTrace("balanceTree level");
+        levelTrace.addArg("level", currentLevel);
+        levelTrace.addArg("numOctants", static_cast<long long>(octantsPerLevel.at(currentLevel).size()));
+
         ::std::unordered_map<OctantID, ::std::unordered_set<OctantID>> unbalanced_nodes;
 
         for (const OctantID& octant : octantsPerLevel.at(currentLevel)) {
@@ -69,7 +84,9 @@ LinearOctree balanceTree(const LinearOctree& octree) {
             continue;
         }
 
-        for (const ::std::pair<OctantID, ::std::unordered_set<OctantID>>& unbalancedNode : unbalanced_nodes) {
+        numSplits += unbalanced_nodes.size();
+
+        for (const ::std::pair<const OctantID, ::std::unordered_set<OctantID>>& unbalancedNode : unbalanced_nodes) {
             const auto subtree = completeSubtree(unbalancedNode.first, currentLevel + 1, unbalancedNode.second);
 
             result.replaceWithSubtree(unbalancedNode.first, subtree);
@@ -98,6 +115,13 @@ LinearOctree createBalancedSubtree(const OctantID& root, const ::std::vector<Oct
 }
 
 void createBalancedSubtree(LinearOctree& tree, uint maxLevel) {
+    size_t temporaryBytes;
+    createBalancedSubtree(tree, maxLevel, temporaryBytes);
+}
+
+void createBalancedSubtree(LinearOctree& tree, uint maxLevel, size_t& temporaryBytes) {
+    temporaryBytes = 0;
+
     if (tree.leafs().empty()) {
         tree.insert(tree.root());
         return;
@@ -106,15 +130,52 @@ void createBalancedSubtree(LinearOctree& tree, uint maxLevel) {
     ::std::unordered_set<OctantID> nonEmptyNodes;
     nonEmptyNodes.reserve(tree.leafs().size());
 
+    // The leafs above level 0 are removed from the tree and added when their level is reached (unless they have to be split to balance the finer leafs)
+    ::std::vector<LinearOctree::container_type> coarseLeafsPerLevel;
+
     for (const OctantID& leaf : tree.leafs()) {
-        assert(leaf.level() == 0);
-        nonEmptyNodes.insert(leaf);
+        if (leaf.level() == 0) {
+            nonEmptyNodes.insert(leaf);
+        } else {
+            if (leaf.level() >= coarseLeafsPerLevel.size()) {
+                coarseLeafsPerLevel.resize(leaf.level() + 1);
+            }
+            coarseLeafsPerLevel.at(leaf.level()).push_back(leaf);
+        }
+    }
+
+    if (!coarseLeafsPerLevel.empty()) {
+        LinearOctree::container_type levelZeroLeafs;
+        levelZeroLeafs.reserve(nonEmptyNodes.size());
+
+        for (const OctantID& leaf : tree.leafs()) {
+            if (leaf.level() == 0) {
+                levelZeroLeafs.push_back(leaf);
+            }
+        }
+
+        tree = LinearOctree(tree.root(), ::std::move(levelZeroLeafs));
     }
 
     uint currentLevel = 0;
     maxLevel = ::std::min(maxLevel, tree.depth());
 
+    // Adds the coarse leafs of the current level that aren't already represented by finer octants
+    auto addCoarseLeafsOfCurrentLevel = [&]() {
+        if (currentLevel >= coarseLeafsPerLevel.size()) {
+            return;
+        }
+
+        for (const OctantID& leaf : coarseLeafsPerLevel.at(currentLevel)) {
+            if (nonEmptyNodes.insert(leaf).second) {
+                tree.insert(leaf);
+            }
+        }
+    };
+
     for (; currentLevel < maxLevel; currentLevel++) {
+        addCoarseLeafsOfCurrentLevel();
+
         ::std::unordered_set<OctantID> nonEmptyParentNodes;
 
         // The list of nodes that ensure a level difference of 1 between all nodes that have a common vertex.
@@ -157,20 +218,28 @@ void createBalancedSubtree(LinearOctree& tree, uint maxLevel) {
             }
         }
 
+        // the sets are largest at the end of a level (sampled once per level, the loops above are unaffected)
+        temporaryBytes = ::std::max(temporaryBytes, memoryUsage(nonEmptyNodes) + memoryUsage(nonEmptyParentNodes) + memoryUsage(guardParentNodes) +
+                                                        memoryUsageOfAll(coarseLeafsPerLevel));
+
         // in the next level the current non-empty parent nodes are the next non-empty nodes
         nonEmptyNodes = nonEmptyParentNodes;
     }
 
+    // The coarse leafs above maxLevel are covered by the octants of maxLevel
+    addCoarseLeafsOfCurrentLevel();
+
     if (currentLevel != tree.depth()) {
         assert(currentLevel == maxLevel);
 
-        // max level is capped... hence fill the empty parts of the octree with nodes of the current level
+        // max level is capped... hence fill the empty parts of the octree with nodes of the current level (the tree might be a block not at the origin)
         const coord_t nodeSize = getOctantSizeForLevel(currentLevel);
-        Vector3i treeMaxXYZ = getMaxXYZForOctreeDepth(tree.depth());
+        const Vector3i treeLLF = tree.root().coord();
+        const Vector3i treeURB = treeLLF + Vector3i(getOctantSizeForLevel(tree.depth()));
 
-        for (coord_t x = 0; x < treeMaxXYZ.x(); x += nodeSize) {
-            for (coord_t y = 0; y < treeMaxXYZ.y(); y += nodeSize) {
-                for (coord_t z = 0; z < treeMaxXYZ.z(); z += nodeSize) {
+        for (coord_t x = treeLLF.x(); x < treeURB.x(); x += nodeSize) {
+            for (coord_t y = treeLLF.y(); y < treeURB.y(); y += nodeSize) {
+                for (coord_t z = treeLLF.z(); z < treeURB.z(); z += nodeSize) {
                     OctantID node(Vector3i(x, y, z), currentLevel);
 
                     if (nonEmptyNodes.count(node) == 0) {
@@ -187,23 +256,21 @@ void createBalancedSubtree(LinearOctree& tree, uint maxLevel) {
 Partition::Partition(const OctantID& rootOctant, const ::std::vector<LinearOctree>& partitionList) : root(rootOctant), partitions(partitionList) {
 }
 
-Partition computePartition(const OctantID& globalRoot, const ::std::vector<OctantID>& levelZeroLeafs, const int numThreads) {
-    if (levelZeroLeafs.empty()) {
-        throw ::std::runtime_error("computePartition: Invalid parameter. No level zero leaves.");
-    }
-
-    assert(levelZeroLeafs.front() <= levelZeroLeafs.back());  // levelZeroLeafs must be sorted
-
-    const size_t leafsPerProcessor = levelZeroLeafs.size() / numThreads;
+/**
+ * @brief Splits the sorted leafs into numRegions regions of equal size, completes them (see completeRegion) and computes the blocks of the regions
+ * @return The blocks (empty if there are too few leafs for the regions)
+ */
+static LinearOctree computeBlocksOfRegions(const OctantID& globalRoot, const LinearOctree::container_type& levelZeroLeafs, const size_t numRegions) {
+    const size_t leafsPerRegion = levelZeroLeafs.size() / numRegions;
 
     ::std::vector<::std::vector<OctantID>> completedRegions;
 
-    if (leafsPerProcessor > 2) {
-        completedRegions.reserve(numThreads);
+    if (leafsPerRegion > 2) {
+        completedRegions.reserve(numRegions);
 
-        for (int t = 0; t < numThreads; t++) {
-            size_t start = t * leafsPerProcessor;
-            size_t end = (t < numThreads - 1 ? (t + 1) * leafsPerProcessor : levelZeroLeafs.size()) - 1;
+        for (size_t r = 0; r < numRegions; r++) {
+            size_t start = r * leafsPerRegion;
+            size_t end = (r < numRegions - 1 ? (r + 1) * leafsPerRegion : levelZeroLeafs.size()) - 1;
 
             ::std::vector<OctantID> region = completeRegion(levelZeroLeafs.at(start), levelZeroLeafs.at(end));
 
@@ -213,7 +280,17 @@ Partition computePartition(const OctantID& globalRoot, const ::std::vector<Octan
         }
     }
 
-    LinearOctree blocks = computeBlocksFromRegions(globalRoot, completedRegions);
+    return computeBlocksFromRegions(globalRoot, completedRegions);
+}
+
+Partition computePartition(const OctantID& globalRoot, const LinearOctree::container_type& levelZeroLeafs, const int numThreads) {
+    if (levelZeroLeafs.empty()) {
+        throw ::std::runtime_error("computePartition: Invalid parameter. No level zero leaves.");
+    }
+
+    assert(levelZeroLeafs.front() <= levelZeroLeafs.back());  // levelZeroLeafs must be sorted
+
+    LinearOctree blocks = computeBlocksOfRegions(globalRoot, levelZeroLeafs, static_cast<size_t>(numThreads));
 
     if (blocks.leafs().empty()) {
         ::std::vector<LinearOctree> partitions = {LinearOctree(globalRoot, levelZeroLeafs)};
@@ -347,6 +424,24 @@ LinearOctree computeBlocksFromRegions(const OctantID& globalRoot, ::std::vector<
     return result;
 }
 
+void removeAncestorOctants(LinearOctree::container_type& sortedOctants) {
+    if (sortedOctants.empty()) {
+        return;
+    }
+
+    // An ancestor is directly followed by one of its descendants (or a duplicate), all octants between them are its descendants as well
+    size_t numRetained = 0;
+    for (size_t i = 0; i < sortedOctants.size() - 1; i++) {
+        const OctantID& next = sortedOctants[i + 1];
+        if (next != sortedOctants[i] && !next.isDecendantOf(sortedOctants[i])) {
+            sortedOctants[numRetained++] = sortedOctants[i];
+        }
+    }
+    sortedOctants[numRetained++] = sortedOctants.back();
+
+    sortedOctants.resize(numRetained);
+}
+
 OctantID nearestCommonAncestor(const OctantID& a, const OctantID& b) {
     const auto resultPair = nearestCommonAncestor(a.mcode(), b.mcode(), a.level(), b.level());
     return OctantID(resultPair.first, resultPair.second);
@@ -397,8 +492,8 @@ OctantID nearestCommonAncestor(const OctantID& a, const OctantID& b) {
     return result;
 }
 
-static void collectBoundaryLeafs(const LinearOctree& partition, const Vector3i& globalTreeLLF, const Vector3i& globalTreeURB,
-                                 ::std::vector<OctantID>& outBoundaryOctants) {
+void collectBoundaryLeafs(const LinearOctree& partition, const Vector3i& globalTreeLLF, const Vector3i& globalTreeURB,
+                          ::std::vector<OctantID>& outBoundaryOctants) {
     const coord_t partitionSize = getOctantSizeForLevel(partition.depth());
     const Vector3i partitionLLF = partition.root().coord();
     const Vector3i partitionURB = partitionLLF + Vector3i(partitionSize);
@@ -410,13 +505,13 @@ static void collectBoundaryLeafs(const LinearOctree& partition, const Vector3i&
     }
 }
 
-static ::std::vector<OctantID> flattenPartitions(const ::std::vector<LinearOctree>& partitions) {
+static LinearOctree::container_type flattenPartitions(const ::std::vector<LinearOctree>& partitions) {
     size_t numLeafs = 0;
     for (const LinearOctree& partition : partitions) {
         numLeafs += partition.leafs().size();
     }
 
-    ::std::vector<OctantID> allLeafs;
+    LinearOctree::container_type allLeafs;
     allLeafs.reserve(numLeafs);
     for (const LinearOctree& partition : partitions) {
         allLeafs.insert(allLeafs.end(), partition.leafs().begin(), partition.leafs().end());
@@ -424,7 +519,7 @@ static ::std::vector<OctantID> flattenPartitions(const ::std::vector<LinearOctre
     return allLeafs;
 }
 
-static LinearOctree mergePartitionsAndBalancedBoundaryTree(const ::std::vector<OctantID>& flatUnbalancedTree, const LinearOctree& balancedBoundaryTree) {
+static LinearOctree mergePartitionsAndBalancedBoundaryTree(const LinearOctree::container_type& flatUnbalancedTree, const LinearOctree& balancedBoundaryTree) {
     if (balancedBoundaryTree.leafs().empty()) {
         return LinearOctree(balancedBoundaryTree.root(), flatUnbalancedTree);
     }
@@ -433,6 +528,7 @@ static LinearOctree mergePartitionsAndBalancedBoundaryTree(const ::std::vector<O
     LinearOctree mergedTree(balancedBoundaryTree.root(), numLeafsInMergedTree);
 
     auto balancingOctantsIterator = balancedBoundaryTree.leafs().begin();
+    const auto balancingOctantsEnd = balancedBoundaryTree.leafs().end();
 
     auto unbalancedOctantsInsertRangeBegin = flatUnbalancedTree.begin();
     auto unbalancedOctantsIterator = flatUnbalancedTree.begin();
@@ -440,14 +536,15 @@ static LinearOctree mergePartitionsAndBalancedBoundaryTree(const ::std::vector<O
     for (; unbalancedOctantsIterator != flatUnbalancedTree.end(); ++unbalancedOctantsIterator) {
         const OctantID& current = *unbalancedOctantsIterator;
 
-        if (current.mcode() == balancingOctantsIterator->mcode()) {
+        if (balancingOctantsIterator != balancingOctantsEnd && current.mcode() == balancingOctantsIterator->mcode()) {
             assert(*balancingOctantsIterator == current || balancingOctantsIterator->isDecendantOf(current));
 
-            const OctantID& next = *(unbalancedOctantsIterator + 1);
+            const auto next = unbalancedOctantsIterator + 1;
 
             auto balancingOctantsRangeStart = balancingOctantsIterator;
 
-            while (balancingOctantsIterator != balancedBoundaryTree.leafs().end() && *balancingOctantsIterator < next) {
+            // the balancing octants up to the next unbalanced octant replace the current one (all remaining ones if it's the last)
+            while (balancingOctantsIterator != balancingOctantsEnd && (next == flatUnbalancedTree.end() || *balancingOctantsIterator < *next)) {
                 ++balancingOctantsIterator;
             }
 
@@ -471,26 +568,91 @@ LinearOctree mergeUnbalancedCompleteTreeWithBalancedIncompleteTree(const LinearO
     return mergePartitionsAndBalancedBoundaryTree(unbalancedTree.leafs(), balancedTree);
 }
 
-static void parallelCreateBalancedSubtrees(::std::vector<LinearOctree>& partitions, const uint maxLevel) {
-#pragma omp parallel for schedule(dynamic, 1)
-    for (size_t i = 0; i < partitions.size(); i++) {
-        createBalancedSubtree(partitions.at(i), maxLevel);
+void initLoadBalanceStats(LoadBalanceStats& loadStats, const size_t numBlocks) {
+    loadStats.busyTimePerThread = ::std::vector<LoadBalanceStats::duration>(static_cast<size_t>(omp_get_num_threads()), LoadBalanceStats::duration::zero());
+    loadStats.blocks = ::std::vector<BlockStats>(numBlocks);
+}
+
+void recordBlock(LoadBalanceStats& loadStats, const char* phaseName, const size_t block, const size_t numInputOctants,
+                 const size_t numOutputOctants, const LoadBalanceStats::duration& time) {
+    BlockStats& blockStats = loadStats.blocks[block];
+    blockStats.numInputOctants = numInputOctants;
+    blockStats.numOutputOctants = numOutputOctants;
+    blockStats.thread = omp_get_thread_num();
+    blockStats.time = time;
+
+    loadStats.busyTimePerThread[static_cast<size_t>(blockStats.thread)] += time;
+
+    Tracer::recordCompletedEvent(phaseName, "block", ::std::chrono::duration_cast<Tracer::clock::duration>(time),
+                                 {{"block", static_cast<long long>(block)},
+                                  {"numInputOctants", static_cast<long long>(numInputOctants)},
+                                  {"numOutputOctants", static_cast<long long>(numOutputOctants)}});
+}
+
+/**
+ * @return The estimated peak memory of the node sets of the threads (the largest sets of each thread, see createBalancedSubtree)
+ */
+static size_t parallelCreateBalancedSubtrees(::std::vector<LinearOctree>& partitions, const uint maxLevel, LoadBalanceStats& loadStats) {
+    ::std::vector<size_t> maxTemporaryBytesPerThread(static_cast<size_t>(omp_get_max_threads()), 0);
+    PerfCounter wallTime;
+
+    wallTime.start();
+#pragma omp parallel
+    {
+#pragma omp single
+        initLoadBalanceStats(loadStats, partitions.size());
+
+        PerfCounter blockTime;
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t i = 0; i < partitions.size(); i++) {
+            const size_t numInputOctants = partitions.at(i).leafs().size();
+
+            blockTime.start();
+            size_t temporaryBytes;
+            createBalancedSubtree(partitions.at(i), maxLevel, temporaryBytes);
+            recordBlock(loadStats, "SUBTREE_BUILD block", i, numInputOctants, partitions.at(i).leafs().size(), blockTime.stop());
+
+            size_t& maxTemporaryBytes = maxTemporaryBytesPerThread.at(static_cast<size_t>(omp_get_thread_num()));
+            maxTemporaryBytes = ::std::max(maxTemporaryBytes, temporaryBytes);
+        }
     }
+    loadStats.wallTime = wallTime.stop();
+
+    size_t temporaryBytes = 0;
+    for (const size_t& maxTemporaryBytes : maxTemporaryBytesPerThread) {
+        temporaryBytes += maxTemporaryBytes;
+    }
+    return temporaryBytes;
 }
 
-static ::std::vector<::std::vector<OctantID>> parallelCollectBoundaryLeafs(const Partition& partition) {
+static ::std::vector<::std::vector<OctantID>> parallelCollectBoundaryLeafs(const Partition& partition, LoadBalanceStats& loadStats) {
     const coord_t globalTreeSize = getOctantSizeForLevel(partition.root.level());
     const Vector3i globalTreeLLF = partition.root.coord();
     const Vector3i globalTreeURB = globalTreeLLF + Vector3i(globalTreeSize);
 
+    PerfCounter wallTime;
+
+    wallTime.start();
     ::std::vector<::std::vector<OctantID>> boundaryOctantsPerPartition(partition.partitions.size());
-#pragma omp parallel for schedule(dynamic, 1)
-    for (size_t i = 0; i < partition.partitions.size(); i++) {
-        const LinearOctree& currentPartition = partition.partitions.at(i);
-        ::std::vector<OctantID>& boundaryOctants = boundaryOctantsPerPartition.at(i);
+#pragma omp parallel
+    {
+#pragma omp single
+        initLoadBalanceStats(loadStats, partition.partitions.size());
+
+        PerfCounter blockTime;
 
-        collectBoundaryLeafs(currentPartition, globalTreeLLF, globalTreeURB, boundaryOctants);
+#pragma omp for schedule(dynamic, 1)
+        for (size_t i = 0; i < partition.partitions.size(); i++) {
+            const LinearOctree& currentPartition = partition.partitions.at(i);
+            ::std::vector<OctantID>& boundaryOctants = boundaryOctantsPerPartition.at(i);
+
+            blockTime.start();
+            collectBoundaryLeafs(currentPartition, globalTreeLLF, globalTreeURB, boundaryOctants);
+            recordBlock(loadStats, "BOUNDARY_COLLECT block", i, currentPartition.leafs().size(), boundaryOctants.size(), blockTime.stop());
+        }
     }
+    loadStats.wallTime = wallTime.stop();
 
     return boundaryOctantsPerPartition;
 }
@@ -510,38 +672,292 @@ static LinearOctree createBoundaryOctantsTree(const ::std::vector<::std::vector<
     return boundaryOctantsTree;
 }
 
-LinearOctree createBalancedOctreeParallel(const OctantID& root, const ::std::vector<OctantID>& levelZeroLeafs, const int numThreads, const uint maxLevel) {
-    PerfCounter perfCounter;
+LinearOctree createBalancedOctreeParallel(const OctantID& root, const LinearOctree::container_type& levelZeroLeafs, const int numThreads, const uint maxLevel) {
+    BuildStats stats;
+    return createBalancedOctreeParallel(root, levelZeroLeafs, numThreads, maxLevel, stats);
+}
+
+LinearOctree createBalancedOctreeParallel(const OctantID& root, const LinearOctree::container_type& levelZeroLeafs, const int numThreads, const uint maxLevel,
+                                          BuildStats& stats, const HardwareCounters* hardwareCounters) {
+    TraceScope trace("createBalancedOctreeParallel");
+    PerfCounter perfCounter(hardwareCounters);
+    MemoryTracker memory(stats);
 
     perfCounter.start();
     Partition computedPartition = computePartition(root, levelZeroLeafs, numThreads);
-
-    LOG_PROF("Created partition: " << perfCounter);
+    recordPhase(stats, BuildStats::Phase::PARTITION, perfCounter);
+    memory.recordPhase(BuildStats::Phase::PARTITION, memoryUsageOfAll(computedPartition.partitions));
+    stats.numBlocks = computedPartition.partitions.size();
 
     perfCounter.start();
-    parallelCreateBalancedSubtrees(computedPartition.partitions, maxLevel);
-    LOG_PROF("Created balanced subtrees: " << perfCounter);
+    const size_t temporaryBytes = parallelCreateBalancedSubtrees(computedPartition.partitions, maxLevel, stats.subtreeBuildLoad);
+    recordPhase(stats, BuildStats::Phase::SUBTREE_BUILD, perfCounter);
+    const size_t partitionBytes = memoryUsageOfAll(computedPartition.partitions);
+    memory.sample(partitionBytes + temporaryBytes);
+    memory.recordPhase(BuildStats::Phase::SUBTREE_BUILD, partitionBytes);
 
     perfCounter.start();
-    ::std::vector<::std::vector<OctantID>> boundaryOctantsPerPartition = parallelCollectBoundaryLeafs(computedPartition);
-    LOG_PROF("Collected boundary leafs: " << perfCounter);
+    ::std::vector<::std::vector<OctantID>> boundaryOctantsPerPartition = parallelCollectBoundaryLeafs(computedPartition, stats.boundaryCollectLoad);
+    recordPhase(stats, BuildStats::Phase::BOUNDARY_COLLECT, perfCounter);
+    const size_t boundaryOctantsBytes = memoryUsageOfAll(boundaryOctantsPerPartition);
+    memory.recordPhase(BuildStats::Phase::BOUNDARY_COLLECT, partitionBytes + boundaryOctantsBytes);
 
     perfCounter.start();
     LinearOctree boundaryOctantsTree = createBoundaryOctantsTree(boundaryOctantsPerPartition, computedPartition.root);
-    LOG_PROF("Created boundary tree: " << perfCounter);
+    recordPhase(stats, BuildStats::Phase::BOUNDARY_TREE, perfCounter);
+    memory.recordPhase(BuildStats::Phase::BOUNDARY_TREE, partitionBytes + boundaryOctantsBytes + memoryUsage(boundaryOctantsTree));
+    stats.numBoundaryOctants = boundaryOctantsTree.leafs().size();
 
     perfCounter.start();
-    LinearOctree balancedBoundaryTree = balanceTree(boundaryOctantsTree);
-    LOG_PROF("Balanced boundary tree: " << perfCounter);
+    LinearOctree balancedBoundaryTree = balanceTree(boundaryOctantsTree, stats.numSplits);
+    recordPhase(stats, BuildStats::Phase::BOUNDARY_BALANCE, perfCounter);
+    // only the blocks and the balanced octants are kept
+    memory.sample(partitionBytes + boundaryOctantsBytes + memoryUsage(boundaryOctantsTree) + memoryUsage(balancedBoundaryTree));
+    memory.recordPhase(BuildStats::Phase::BOUNDARY_BALANCE, partitionBytes + memoryUsage(balancedBoundaryTree));
+    const size_t blocksBytes = partitionBytes + memoryUsage(balancedBoundaryTree);
 
     perfCounter.start();
-    ::std::vector<OctantID> leafsOfAllPartitions = flattenPartitions(computedPartition.partitions);
-    LOG_PROF("Flatten boundary tree: " << perfCounter);
+    LinearOctree::container_type leafsOfAllPartitions = flattenPartitions(computedPartition.partitions);
+    recordPhase(stats, BuildStats::Phase::FLATTEN, perfCounter);
+    memory.recordPhase(BuildStats::Phase::FLATTEN, blocksBytes + memoryUsage(leafsOfAllPartitions));
 
     perfCounter.start();
     LinearOctree result = mergePartitionsAndBalancedBoundaryTree(leafsOfAllPartitions, balancedBoundaryTree);
-    LOG_PROF("Merged boundary tree: " << perfCounter);
+    recordPhase(stats, BuildStats::Phase::MERGE, perfCounter);
+    // the blocks and the flattened leafs are released on return
+    memory.sample(blocksBytes + memoryUsage(leafsOfAllPartitions) + memoryUsage(result));
+    memory.recordPhase(BuildStats::Phase::MERGE, memoryUsage(result));
+    stats.numLeafs = result.leafs().size();
 
     return result;
 }
+
+/**
+ * @brief The number of blocks per thread created by createBalancedOctreeParallel with a sink
+ *
+ * The threads only hold the subtrees of the blocks they work on, hence more blocks need less memory (but create more boundary octants).
+ */
+static const size_t SINK_BLOCKS_PER_THREAD = 8;
+
+/**
+ * @brief The index of the first leaf of each block in the sorted leafs (followed by the number of leafs)
+ * @throws ::std::runtime_error If a leaf isn't inside of a block
+ */
+static ::std::vector<size_t> computeFirstLeafOfBlocks(const LinearOctree::container_type& blocks, const LinearOctree::container_type& levelZeroLeafs) {
+    ::std::vector<size_t> firstLeafOfBlock(blocks.size() + 1, levelZeroLeafs.size());
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const auto first = ::std::lower_bound(levelZeroLeafs.begin(), levelZeroLeafs.end(), blocks[i].mcode(),
+                                              [](const OctantID& octant, const morton_t& mcode) { return octant.mcode() < mcode; });
+        firstLeafOfBlock[i] = static_cast<size_t>(first - levelZeroLeafs.begin());
+    }
+
+    // the blocks are complete and the leafs don't overlap... only a leaf at the llf of a block can be larger than the block
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (firstLeafOfBlock[i] < firstLeafOfBlock[i + 1]) {
+            const OctantID& firstLeaf = levelZeroLeafs[firstLeafOfBlock[i]];
+
+            if (firstLeaf != blocks[i] && !firstLeaf.isDecendantOf(blocks[i])) {
+                throw ::std::runtime_error("createBalancedOctreeParallel: Invalid state. No block for level zero leaf found.");
+            }
+        }
+    }
+
+    return firstLeafOfBlock;
+}
+
+/**
+ * @brief Merges the leafs of a block with the balanced boundary octants inside of the block
+ *
+ * The leafs that were split by the balancing are replaced by the balanced octants inside of them.
+ */
+static LinearOctree::container_type mergeBlockAndBalancedOctants(const LinearOctree::container_type& blockLeafs,
+                                                                 LinearOctree::container_type::const_iterator balancedBegin,
+                                                                 const LinearOctree::container_type::const_iterator balancedEnd) {
+    LinearOctree::container_type merged;
+    merged.reserve(blockLeafs.size() + static_cast<size_t>(balancedEnd - balancedBegin));
+
+    for (const OctantID& leaf : blockLeafs) {
+        if (balancedBegin != balancedEnd && balancedBegin->mcode() == leaf.mcode()) {
+            while (balancedBegin != balancedEnd && (*balancedBegin == leaf || balancedBegin->isDecendantOf(leaf))) {
+                merged.push_back(*balancedBegin);
+                ++balancedBegin;
+            }
+        } else {
+            merged.push_back(leaf);
+        }
+    }
+
+    merged.insert(merged.end(), balancedBegin, balancedEnd);
+
+    return merged;
+}
+
+void createBalancedOctreeParallel(const OctantID& root, const LinearOctree::container_type& levelZeroLeafs, const int numThreads, const uint maxLevel,
+                                  const LeafSink& sink, BuildStats& stats, const HardwareCounters* hardwareCounters) {
+    TraceScope trace("createBalancedOctreeParallel");
+    PerfCounter perfCounter(hardwareCounters);
+    MemoryTracker memory(stats);
+
+    if (levelZeroLeafs.empty()) {
+        throw ::std::runtime_error("createBalancedOctreeParallel: Invalid parameter. No level zero leaves.");
+    }
+
+    // the blocks only refer to their leafs... no subtree is kept from one phase to the next
+    perfCounter.start();
+    const LinearOctree blocksTree = computeBlocksOfRegions(root, levelZeroLeafs, static_cast<size_t>(numThreads) * SINK_BLOCKS_PER_THREAD);
+    const LinearOctree::container_type blocks = blocksTree.leafs().empty() ? LinearOctree::container_type{root} : blocksTree.leafs();
+    const ::std::vector<size_t> firstLeafOfBlock = computeFirstLeafOfBlocks(blocks, levelZeroLeafs);
+    recordPhase(stats, BuildStats::Phase::PARTITION, perfCounter);
+    const size_t blocksBytes = memoryUsage(blocks) + memoryUsage(firstLeafOfBlock);
+    memory.recordPhase(BuildStats::Phase::PARTITION, blocksBytes);
+    stats.numBlocks = blocks.size();
+
+    // temporaryBytes receives the peak memory of the node sets of the creation
+    auto createBlockSubtree = [&](const size_t i, size_t& temporaryBytes) {
+        LinearOctree subtree(blocks[i], firstLeafOfBlock[i + 1] - firstLeafOfBlock[i]);
+        subtree.insert(levelZeroLeafs.begin() + static_cast<::std::ptrdiff_t>(firstLeafOfBlock[i]),
+                       levelZeroLeafs.begin() + static_cast<::std::ptrdiff_t>(firstLeafOfBlock[i + 1]));
+        createBalancedSubtree(subtree, maxLevel, temporaryBytes);
+        return subtree;
+    };
+
+    const Vector3i globalTreeLLF = root.coord();
+    const Vector3i globalTreeURB = globalTreeLLF + Vector3i(getOctantSizeForLevel(root.level()));
+    ::std::vector<::std::vector<OctantID>> boundaryOctantsPerBlock(blocks.size());
+
+    // the largest subtree (and merged leafs) held by each thread
+    ::std::vector<size_t> maxBlockBytesPerThread(static_cast<size_t>(omp_get_max_threads()), 0);
+
+    // the boundary octants are collected while the subtree is in memory (there is no BOUNDARY_COLLECT phase)
+    perfCounter.start();
+    {
+        PerfCounter wallTime;
+        wallTime.start();
+
+#pragma omp parallel
+        {
+#pragma omp single
+            initLoadBalanceStats(stats.subtreeBuildLoad, blocks.size());
+
+            PerfCounter blockTime;
+
+#pragma omp for schedule(dynamic, 1)
+            for (size_t i = 0; i < blocks.size(); i++) {
+                blockTime.start();
+                size_t temporaryBytes;
+                const LinearOctree subtree = createBlockSubtree(i, temporaryBytes);
+                collectBoundaryLeafs(subtree, globalTreeLLF, globalTreeURB, boundaryOctantsPerBlock[i]);
+
+                size_t& maxBlockBytes = maxBlockBytesPerThread.at(static_cast<size_t>(omp_get_thread_num()));
+                maxBlockBytes = ::std::max(maxBlockBytes, memoryUsage(subtree) + temporaryBytes);
+                recordBlock(stats.subtreeBuildLoad, "SUBTREE_BUILD block", i, firstLeafOfBlock[i + 1] - firstLeafOfBlock[i], subtree.leafs().size(),
+                            blockTime.stop());
+            }
+        }
+
+        stats.subtreeBuildLoad.wallTime = wallTime.stop();
+    }
+    recordPhase(stats, BuildStats::Phase::SUBTREE_BUILD, perfCounter);
+    const size_t boundaryOctantsBytes = memoryUsageOfAll(boundaryOctantsPerBlock);
+    size_t maxBlocksBytes = 0;
+    for (const size_t& maxBlockBytes : maxBlockBytesPerThread) {
+        maxBlocksBytes += maxBlockBytes;
+    }
+    memory.sample(blocksBytes + boundaryOctantsBytes + maxBlocksBytes);
+    memory.recordPhase(BuildStats::Phase::SUBTREE_BUILD, blocksBytes + boundaryOctantsBytes);
+
+    perfCounter.start();
+    LinearOctree boundaryOctantsTree = createBoundaryOctantsTree(boundaryOctantsPerBlock, root);
+    ::std::vector<::std::vector<OctantID>>().swap(boundaryOctantsPerBlock);
+    recordPhase(stats, BuildStats::Phase::BOUNDARY_TREE, perfCounter);
+    memory.sample(blocksBytes + boundaryOctantsBytes + memoryUsage(boundaryOctantsTree));
+    memory.recordPhase(BuildStats::Phase::BOUNDARY_TREE, blocksBytes + memoryUsage(boundaryOctantsTree));
+    stats.numBoundaryOctants = boundaryOctantsTree.leafs().size();
+
+    perfCounter.start();
+    const LinearOctree balancedBoundaryTree = balanceTree(boundaryOctantsTree, stats.numSplits);
+    memory.sample(blocksBytes + memoryUsage(boundaryOctantsTree) + memoryUsage(balancedBoundaryTree));
+    boundaryOctantsTree = LinearOctree();
+    recordPhase(stats, BuildStats::Phase::BOUNDARY_BALANCE, perfCounter);
+    const size_t balancedOctantsBytes = memoryUsage(balancedBoundaryTree);
+    memory.recordPhase(BuildStats::Phase::BOUNDARY_BALANCE, blocksBytes + balancedOctantsBytes);
+
+    perfCounter.start();
+    const LinearOctree::container_type& balancedOctants = balancedBoundaryTree.leafs();
+
+    // the balanced octants of each block (the blocks are sorted and don't overlap)
+    ::std::vector<LinearOctree::container_type::const_iterator> firstBalancedOctantOfBlock(blocks.size() + 1, balancedOctants.end());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        firstBalancedOctantOfBlock[i] = ::std::lower_bound(balancedOctants.begin(), balancedOctants.end(), blocks[i].mcode(),
+                                                           [](const OctantID& octant, const morton_t& mcode) { return octant.mcode() < mcode; });
+    }
+
+    size_t numLeafs = 0;
+    ::std::fill(maxBlockBytesPerThread.begin(), maxBlockBytesPerThread.end(), 0);
+    ::std::atomic<bool> sinkFailed(false);
+    ::std::exception_ptr sinkException;
+
+    // the subtree of each block is created again, merged, passed to the sink and released
+#pragma omp parallel for ordered schedule(dynamic, 1)
+    for (size_t i = 0; i < blocks.size(); i++) {
+        LinearOctree::container_type merged;
+
+        if (!sinkFailed) {
+            size_t temporaryBytes;
+            const LinearOctree subtree = createBlockSubtree(i, temporaryBytes);
+            merged = mergeBlockAndBalancedOctants(subtree.leafs(), firstBalancedOctantOfBlock[i], firstBalancedOctantOfBlock[i + 1]);
+
+            // the node sets are released before the merged leafs are allocated
+            size_t& maxBlockBytes = maxBlockBytesPerThread.at(static_cast<size_t>(omp_get_thread_num()));
+            maxBlockBytes = ::std::max(maxBlockBytes, memoryUsage(subtree) + ::std::max(temporaryBytes, memoryUsage(merged)));
+        }
+
+#pragma omp ordered
+        {
+            if (!sinkException) {
+                try {
+                    passLeafsToSink(sink, merged.begin(), merged.end());
+                    numLeafs += merged.size();
+                } catch (...) {
+                    sinkException = ::std::current_exception();
+                    sinkFailed = true;
+                }
+            }
+        }
+    }
+
+    recordPhase(stats, BuildStats::Phase::MERGE, perfCounter);
+    maxBlocksBytes = 0;
+    for (const size_t& maxBlockBytes : maxBlockBytesPerThread) {
+        maxBlocksBytes += maxBlockBytes;
+    }
+    memory.sample(blocksBytes + balancedOctantsBytes + maxBlocksBytes);
+    memory.recordPhase(BuildStats::Phase::MERGE, 0);
+    stats.numLeafs = numLeafs;
+
+    if (sinkException) {
+        ::std::rethrow_exception(sinkException);
+    }
+}
+
+void passLeafsToSink(const LeafSink& sink, LinearOctree::container_type::const_iterator begin, LinearOctree::container_type::const_iterator end) {
+    static const size_t MAX_CHUNK_SIZE = size_t(1) << 16;
+
+    ::std::vector<OctreeNode> chunk;
+    chunk.reserve(::std::min(MAX_CHUNK_SIZE, static_cast<size_t>(end - begin)));
+
+    for (; begin != end; ++begin) {
+        chunk.push_back(OctreeNode(begin->mcode(), begin->level()));
+
+        if (chunk.size() == MAX_CHUNK_SIZE) {
+            sink(chunk.data(), chunk.size());
+            chunk.clear();
+        }
+    }
+
+    if (!chunk.empty()) {
+        sink(chunk.data(), chunk.size());
+    }
+}
 }
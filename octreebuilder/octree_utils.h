@@ -2,6 +2,7 @@
 
 #include "octreebuilder_api.h"
 #include "octreebuilder.h"
+#include "buildstats.h"
 
 #include "octantid.h"
 #include "linearoctree.h"
@@ -22,16 +23,33 @@ namespace octreebuilder {
 OCTREEBUILDER_API LinearOctree balanceTree(const LinearOctree& octree);
 
 /**
- * @brief Creates a 2:1 balanced octree from a set of level 0 leafs
- * @param tree The incomplete tree. Must only contain leafs of level 0.
+ * @brief 2:1 balances an incomplete unbalanced octree (see balanceTree)
+ * @param octree The sorted unbalanced octree (can be incomplete)
+ * @param numSplits Will contain the number of octants that were replaced by a subtree to balance the tree
+ * @return A 2:1 balanced octree (might be incomplete depending on the input)
+ */
+OCTREEBUILDER_API LinearOctree balanceTree(const LinearOctree& octree, size_t& numSplits);
+
+/**
+ * @brief Creates a 2:1 balanced octree from a set of leafs
+ * @param tree The incomplete tree. The leafs can be of any level and may overlap (the finest octants are retained).
  * @param maxLevel The maximum level of all octants in the balanced tree
+ *
+ * A leaf above level 0 is replaced by finer octants if it contains other leafs or if the balance condition requires it.
+ * Leafs above maxLevel are replaced by octants of maxLevel.
  */
 OCTREEBUILDER_API void createBalancedSubtree(LinearOctree& tree, uint maxLevel = ::std::numeric_limits<uint>::max());
 
 /**
- * @brief Creates a 2:1 balanced octree from a set of level 0 leafs
+ * @brief Creates a 2:1 balanced octree from a set of leafs (see createBalancedSubtree(LinearOctree&, uint))
+ * @param temporaryBytes Receives the estimated peak memory of the node sets used by the creation (see memoryusage.h, the tree isn't included)
+ */
+OCTREEBUILDER_API void createBalancedSubtree(LinearOctree& tree, uint maxLevel, size_t& temporaryBytes);
+
+/**
+ * @brief Creates a 2:1 balanced octree from a set of leafs (see createBalancedSubtree(LinearOctree&, uint))
  * @param root The root of the incomplete tree
- * @param levelZeroLeafs The level zero leafs
+ * @param levelZeroLeafs The leafs (of any level)
  * @param maxLevel The maximum level of all octants in the balanced tree
  * @return The balanced octree
  */
@@ -51,11 +69,11 @@ struct OCTREEBUILDER_API Partition {
  * @brief Computes a partition of an incomplete octree for a parallel creation, so that the creation effort is balanced over all threads and communication is
  * minimized
  * @param globalRoot The root of the incomplete octree
- * @param levelZeroLeafs The level zero leafs of the incomplete octree
+ * @param levelZeroLeafs The sorted leafs of the incomplete octree (of any level, must not overlap see removeAncestorOctants)
  * @param numThreads The number of threads used for parallel creation
- * @return A partition of the incomplete octree. Each subtree contains the level zero leafs inside its bounds.
+ * @return A partition of the incomplete octree. Each subtree contains the leafs inside its bounds.
  */
-OCTREEBUILDER_API Partition computePartition(const OctantID& globalRoot, const ::std::vector<OctantID>& levelZeroLeafs, const int numThreads);
+OCTREEBUILDER_API Partition computePartition(const OctantID& globalRoot, const LinearOctree::container_type& levelZeroLeafs, const int numThreads);
 
 /**
  * @brief merges The unbalanced complete tree with the balanced incomplete tree
@@ -83,6 +101,13 @@ OCTREEBUILDER_API ::std::vector<OctantID> completeRegion(const OctantID& start,
  */
 OCTREEBUILDER_API LinearOctree computeBlocksFromRegions(const OctantID& globalRoot, ::std::vector<::std::vector<OctantID>> completedRegions);
 
+/**
+ * @brief Removes the duplicates and the octants that contain another octant from a sorted list of octants
+ *
+ * The result doesn't overlap (as required by computePartition), only the finest octants are retained.
+ */
+OCTREEBUILDER_API void removeAncestorOctants(LinearOctree::container_type& sortedOctants);
+
 /**
  * @brief Computes the octant of minimal level that contains a and b.
  * @return The nearest common ancestor of a and b
@@ -98,16 +123,61 @@ OCTREEBUILDER_API OctantID nearestCommonAncestor(const OctantID& a, const Octant
  */
 OCTREEBUILDER_API ::std::vector<OctantID> completeSubtree(const OctantID& root, uint lowestLevel, const ::std::unordered_set<OctantID>& keys);
 
+/**
+ * @brief Collects the leafs of a partition that are at the boundary of the partition (but not at the boundary of the global tree)
+ * @param partition The balanced subtree of a partition
+ * @param globalTreeLLF The llf of the global tree
+ * @param globalTreeURB The urb of the global tree
+ * @param outBoundaryOctants The boundary leafs are appended to it
+ */
+OCTREEBUILDER_API void collectBoundaryLeafs(const LinearOctree& partition, const Vector3i& globalTreeLLF, const Vector3i& globalTreeURB,
+                                            ::std::vector<OctantID>& outBoundaryOctants);
+
+/**
+ * @brief Prepares the load statistics for a parallel phase. Must be called by a single thread of the parallel region.
+ */
+OCTREEBUILDER_API void initLoadBalanceStats(LoadBalanceStats& loadStats, const size_t numBlocks);
+
+/**
+ * @brief Records the work done for a block by the calling thread
+ */
+OCTREEBUILDER_API void recordBlock(LoadBalanceStats& loadStats, const char* phaseName, const size_t block, const size_t numInputOctants,
+                                   const size_t numOutputOctants, const LoadBalanceStats::duration& time);
+
 /**
  * @brief Creates a 2:1 blanced octree from a set of level zero leafs in parallel
  * @param root The root of the octree
- * @param levelZeroLeafs The level zero leafs
+ * @param levelZeroLeafs The sorted leafs (may also be above level zero, but must not overlap see removeAncestorOctants)
  * @param numThreads The number of threads used
  * @param maxLevel The maximum level of all leafs in the final 2:1 balanced octree
  * @return The complete 2:1 blanaced octree
  *
  * The final octree contains all level zero leafs the remaining space is covered with the minimum number of non-overlapping octants
  */
-OCTREEBUILDER_API LinearOctree createBalancedOctreeParallel(const OctantID& root, const ::std::vector<OctantID>& levelZeroLeafs, const int numThreads,
+OCTREEBUILDER_API LinearOctree createBalancedOctreeParallel(const OctantID& root, const LinearOctree::container_type& levelZeroLeafs, const int numThreads,
                                                             const uint maxLevel = ::std::numeric_limits<uint>::max());
+
+/**
+ * @brief Creates a 2:1 balanced octree from a set of level zero leafs in parallel (see createBalancedOctreeParallel) and records statistics
+ * @param stats The statistics of each phase of the creation are added to stats
+ * @param hardwareCounters If not null the hardware counter values of each phase are added to stats
+ */
+OCTREEBUILDER_API LinearOctree createBalancedOctreeParallel(const OctantID& root, const LinearOctree::container_type& levelZeroLeafs, const int numThreads,
+                                                            const uint maxLevel, BuildStats& stats, const HardwareCounters* hardwareCounters = nullptr);
+
+/**
+ * @brief Creates a 2:1 balanced octree from a set of level zero leafs in parallel (see createBalancedOctreeParallel) and passes its leafs to the sink
+ *
+ * The leafs are split into more blocks than threads. The balanced subtree of each block is created twice: once to collect its boundary octants
+ * and once to merge it with the balanced boundary octants and pass its leafs to the sink (in ascending order). Besides the input only the
+ * boundary octants and the subtrees of the blocks the threads currently work on are stored, at the cost of building each subtree twice.
+ */
+OCTREEBUILDER_API void createBalancedOctreeParallel(const OctantID& root, const LinearOctree::container_type& levelZeroLeafs, const int numThreads,
+                                                    const uint maxLevel, const LeafSink& sink, BuildStats& stats,
+                                                    const HardwareCounters* hardwareCounters = nullptr);
+
+/**
+ * @brief Passes the leafs to the sink in chunks
+ */
+OCTREEBUILDER_API void passLeafsToSink(const LeafSink& sink, LinearOctree::container_type::const_iterator begin, LinearOctree::container_type::const_iterator end);
 }
@@ -1,14 +1,704 @@
 #include "octreebuilder.h"
 
+#include "memorymappedfile.h"
+#include "mortoncode_utils.h"
+#include "octantid.h"
+#include "parallel_stable_sort.h"
+#include "trianglevoxelizer.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
 namespace octreebuilder {
 
-OctreeBuilder::OctreeBuilder(const Vector3i& maxXYZ, uint maxLevel) : m_maxXYZ(maxXYZ), m_maxLevel(maxLevel) {
+OctreeBuilder::OctreeBuilder(const Vector3i& maxXYZ, uint maxLevel) : m_maxXYZ(maxXYZ), m_hardwareCountersEnabled(false), m_maxLevel(maxLevel) {
+}
+
+morton_t OctreeBuilder::addLeaf(const Vector3i& c, uint level) {
+    const uint depth = getOctreeDepthForBounding(m_maxXYZ);
+    if (level > depth) {
+        throw ::std::runtime_error("OctreeBuilder::addLeaf: The level is above the depth of the octree.");
+    }
+
+    const coord_t size = getOctantSizeForLevel(level);
+    for (uint i = 0; i < 3; i++) {
+        if (c[i] < 0 || c[i] > m_maxXYZ[i] || c[i] % size != 0) {
+            throw ::std::runtime_error("OctreeBuilder::addLeaf: The coordinate isn't the llf of a node of the level inside of the octree.");
+        }
+    }
+
+    if (level == 0) {
+        return addLevelZeroLeaf(c);
+    }
+
+    const morton_t mortonCode = getMortonCodeForCoordinate(c);
+
+    auto it = m_leafsAboveLevelZero.insert(::std::make_pair(mortonCode, level)).first;
+    it->second = ::std::min(it->second, level);
+
+    return mortonCode;
+}
+
+/**
+ * @brief The number of leafs of a file that are encoded by one thread at once
+ */
+static const size_t LEAFS_PER_CHUNK = size_t(1) << 18;
+
+static bool isInside(const Vector3i& c, const Vector3i& maxXYZ) {
+    for (uint i = 0; i < 3; i++) {
+        if (c[i] < 0 || c[i] > maxXYZ[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Sorts the morton codes (LSD radix sort with 8 bit digits)
+ * @param numBits Only the lower numBits bits of the codes are set
+ * @param buffer Temporary storage for numCodes codes
+ *
+ * The leafs of an octree of depth d only use 3 * d bits, hence usually a few passes are enough (4 passes for depth 10).
+ */
+static void radixSort(morton_t* codes, const size_t numCodes, const uint numBits, morton_t* buffer) {
+    morton_t* source = codes;
+    morton_t* destination = buffer;
+
+    for (uint shift = 0; shift < numBits; shift += 8) {
+        size_t offsets[257] = {0};
+        for (size_t i = 0; i < numCodes; i++) {
+            offsets[((source[i] >> shift) & 0xFF) + 1]++;
+        }
+
+        for (size_t digit = 0; digit < 256; digit++) {
+            offsets[digit + 1] += offsets[digit];
+        }
+
+        for (size_t i = 0; i < numCodes; i++) {
+            destination[offsets[(source[i] >> shift) & 0xFF]++] = source[i];
+        }
+
+        ::std::swap(source, destination);
+    }
+
+    if (source != codes) {
+        ::std::memcpy(codes, source, numCodes * sizeof(morton_t));
+    }
+}
+
+/**
+ * @brief The maximum number of codes of the buffer used by one thread to merge sorted runs
+ */
+static const size_t MERGE_BUFFER_SIZE = LEAFS_PER_CHUNK;
+
+/**
+ * @brief Merges the adjacent sorted runs [first, middle) and [middle, last) in place
+ * @param buffer Temporary storage for bufferSize codes (at least 1)
+ *
+ * The shorter run is moved to the buffer and merged into the gap it leaves. If both runs are longer than the buffer, the longer one is split in half,
+ * the parts of the other one below and above the split point are found by binary search and the runs are rotated into two pairs that are merged
+ * separately (the buffer size limits the memory, each halving costs a pass over the runs).
+ */
+static void mergeAdjacentRuns(morton_t* first, morton_t* middle, morton_t* last, morton_t* buffer, const size_t bufferSize) {
+    const size_t length1 = static_cast<size_t>(middle - first);
+    const size_t length2 = static_cast<size_t>(last - middle);
+    if (length1 == 0 || length2 == 0 || *(middle - 1) <= *middle) {
+        return;
+    }
+
+    if (length1 <= bufferSize && length1 <= length2) {
+        // merge forward, the output never overtakes the unmerged codes of the second run
+        ::std::copy(first, middle, buffer);
+        const morton_t* left = buffer;
+        const morton_t* leftEnd = buffer + length1;
+        const morton_t* right = middle;
+        morton_t* out = first;
+        while (left != leftEnd && right != last) {
+            *out++ = *right < *left ? *right++ : *left++;
+        }
+        ::std::copy(left, leftEnd, out);
+        return;
+    }
+
+    if (length2 <= bufferSize) {
+        // merge backward, the output never overtakes the unmerged codes of the first run
+        ::std::copy(middle, last, buffer);
+        const morton_t* left = middle;
+        morton_t* right = buffer + length2;
+        morton_t* out = last;
+        while (left != first && right != buffer) {
+            *--out = *(left - 1) > *(right - 1) ? *--left : *--right;
+        }
+        // the codes left in the buffer are the smallest ones
+        ::std::copy(buffer, right, first);
+        return;
+    }
+
+    morton_t* cut1;
+    morton_t* cut2;
+    if (length1 > length2) {
+        cut1 = first + length1 / 2;
+        cut2 = ::std::lower_bound(middle, last, *cut1);
+    } else {
+        cut2 = middle + length2 / 2;
+        cut1 = ::std::upper_bound(first, middle, *cut2);
+    }
+
+    morton_t* newMiddle = ::std::rotate(cut1, middle, cut2);
+    mergeAdjacentRuns(first, cut1, newMiddle, buffer, bufferSize);
+    mergeAdjacentRuns(newMiddle, cut2, last, buffer, bufferSize);
+}
+
+/**
+ * @brief Merges the sorted runs [codes + runs[i], codes + runs[i + 1]) in place (pairs of runs are merged in parallel until one run is left)
+ *
+ * Every thread uses a buffer of at most MERGE_BUFFER_SIZE codes (see mergeAdjacentRuns).
+ */
+static void mergeSortedRuns(morton_t* codes, ::std::vector<size_t> runs) {
+    while (runs.size() > 2) {
+        const size_t numRuns = runs.size() - 1;
+
+#pragma omp parallel
+        {
+            ::std::vector<morton_t> buffer;
+
+#pragma omp for schedule(dynamic, 1)
+            for (size_t run = 0; run < numRuns; run += 2) {
+                const size_t middle = ::std::min(run + 1, numRuns);
+                const size_t last = ::std::min(run + 2, numRuns);
+
+                buffer.resize(::std::min(MERGE_BUFFER_SIZE, ::std::max<size_t>(runs[last] - runs[middle], 1)));
+                mergeAdjacentRuns(codes + runs[run], codes + runs[middle], codes + runs[last], buffer.data(), buffer.size());
+            }
+        }
+
+        ::std::vector<size_t> mergedRuns;
+        for (size_t run = 0; run < numRuns; run += 2) {
+            mergedRuns.push_back(runs[run]);
+        }
+        mergedRuns.push_back(runs.back());
+
+        runs.swap(mergedRuns);
+    }
+}
+
+size_t OctreeBuilder::levelZeroLeafRecordSize(LevelZeroLeafFileFormat format) {
+    return format == LevelZeroLeafFileFormat::INT32_XYZ ? 3 * sizeof(int32_t) : sizeof(morton_t);
+}
+
+bool OctreeBuilder::encodeLevelZeroLeafs(const char* records, const size_t numLeafs, const LevelZeroLeafFileFormat format, const Vector3i& maxXYZ, morton_t* codes) {
+    bool valid = true;
+
+    if (format == LevelZeroLeafFileFormat::INT32_XYZ) {
+        for (size_t i = 0; i < numLeafs; i++) {
+            int32_t xyz[3];
+            ::std::memcpy(xyz, records + i * sizeof(xyz), sizeof(xyz));
+
+            const Vector3i c(xyz[0], xyz[1], xyz[2]);
+            valid &= isInside(c, maxXYZ);
+            codes[i] = valid ? getMortonCodeForCoordinate(c) : 0;
+        }
+    } else {
+        ::std::memcpy(codes, records, numLeafs * sizeof(morton_t));
+
+        for (size_t i = 0; i < numLeafs; i++) {
+            // the decoding ignores the bits above the coordinates... a code with such bits isn't the code of its coordinate
+            const Vector3i c = getCoordinateForMortonCode(codes[i]);
+            valid &= isInside(c, maxXYZ) && getMortonCodeForCoordinate(c) == codes[i];
+        }
+    }
+
+    return valid;
+}
+
+size_t OctreeBuilder::addLevelZeroLeafsFromFile(const ::std::string& path, LevelZeroLeafFileFormat format) {
+    const MemoryMappedFile file(path, MemoryMappedFile::AccessPattern::SEQUENTIAL);
+
+    const size_t recordSize = levelZeroLeafRecordSize(format);
+    if (file.size() % recordSize != 0) {
+        throw ::std::runtime_error("Invalid leaf file " + path + ": The size of the file isn't a multiple of the size of a leaf.");
+    }
+
+    const size_t numLeafs = file.size() / recordSize;
+
+    const bool valid = addEncodedLevelZeroLeafs(numLeafs, [&](size_t first, size_t numLeafsOfChunk, morton_t* codes) {
+        const bool chunkValid = encodeLevelZeroLeafs(file.data() + first * recordSize, numLeafsOfChunk, format, m_maxXYZ, codes);
+
+        // the chunk is encoded... its pages aren't needed anymore
+        file.release(first * recordSize, numLeafsOfChunk * recordSize);
+
+        return chunkValid;
+    });
+
+    if (!valid) {
+        throw ::std::runtime_error("Invalid leaf file " + path + ": A leaf is outside of the bounding of the octree.");
+    }
+
+    return numLeafs;
+}
+
+bool OctreeBuilder::addEncodedLevelZeroLeafs(size_t numLeafs, const LevelZeroLeafEncoder& encode) {
+    const size_t numChunks = (numLeafs + LEAFS_PER_CHUNK - 1) / LEAFS_PER_CHUNK;
+    const size_t first = m_levelZeroLeafsFromFiles.size();
+
+    // the morton codes are encoded in place... the array is the only copy of the leafs
+    m_levelZeroLeafsFromFiles.resize(first + numLeafs);
+    morton_t* codes = m_levelZeroLeafsFromFiles.data() + first;
+
+    // the codes of leafs inside of maxXYZ don't use the higher bits
+    const uint numBits = 3 * getOctreeDepthForBounding(m_maxXYZ);
+
+    ::std::vector<size_t> numUniqueLeafsPerChunk(numChunks);
+    ::std::atomic<bool> valid(true);
+
+#pragma omp parallel
+    {
+        ::std::vector<morton_t> sortBuffer;
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < numChunks; chunk++) {
+            const size_t begin = chunk * LEAFS_PER_CHUNK;
+            const size_t numLeafsOfChunk = ::std::min(LEAFS_PER_CHUNK, numLeafs - begin);
+
+            if (!encode(begin, numLeafsOfChunk, codes + begin)) {
+                // the input is discarded anyway
+                valid = false;
+                continue;
+            }
+
+            sortBuffer.resize(numLeafsOfChunk);
+            radixSort(codes + begin, numLeafsOfChunk, numBits, sortBuffer.data());
+            numUniqueLeafsPerChunk[chunk] = static_cast<size_t>(::std::unique(codes + begin, codes + begin + numLeafsOfChunk) - (codes + begin));
+        }
+    }
+
+    if (!valid) {
+        m_levelZeroLeafsFromFiles.resize(first);
+        return false;
+    }
+
+    // move the unique leafs of all chunks together
+    ::std::vector<size_t> runs(1, 0);
+    for (size_t chunk = 0; chunk < numChunks; chunk++) {
+        const morton_t* begin = codes + chunk * LEAFS_PER_CHUNK;
+        ::std::memmove(codes + runs.back(), begin, numUniqueLeafsPerChunk[chunk] * sizeof(morton_t));
+        runs.push_back(runs.back() + numUniqueLeafsPerChunk[chunk]);
+    }
+
+    // the chunks are sorted... merge them
+    mergeSortedRuns(codes, runs);
+    const size_t end = static_cast<size_t>(::std::unique(codes, codes + runs.back()) - codes);
+
+    m_levelZeroLeafsFromFiles.resize(first + end);
+    mergeLevelZeroLeafsFromFiles(first);
+
+    return true;
+}
+
+void OctreeBuilder::addGeneratedLevelZeroLeafs(size_t numItems, size_t itemsPerChunk, const LevelZeroLeafGenerator& generate) {
+    const size_t numChunks = (numItems + itemsPerChunk - 1) / itemsPerChunk;
+    const uint numBits = 3 * getOctreeDepthForBounding(m_maxXYZ);
+
+    ::std::vector<::std::vector<morton_t>> codesPerChunk(numChunks);
+
+#pragma omp parallel
+    {
+        ::std::vector<morton_t> sortBuffer;
+
+#pragma omp for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < numChunks; chunk++) {
+            const size_t first = chunk * itemsPerChunk;
+            ::std::vector<morton_t>& codes = codesPerChunk[chunk];
+
+            generate(first, ::std::min(itemsPerChunk, numItems - first), codes);
+
+            sortBuffer.resize(codes.size());
+            radixSort(codes.data(), codes.size(), numBits, sortBuffer.data());
+            codes.erase(::std::unique(codes.begin(), codes.end()), codes.end());
+        }
+    }
+
+    // append the codes of all chunks
+    ::std::vector<size_t> runs(1, 0);
+    for (const ::std::vector<morton_t>& codes : codesPerChunk) {
+        runs.push_back(runs.back() + codes.size());
+    }
+
+    const size_t first = m_levelZeroLeafsFromFiles.size();
+    m_levelZeroLeafsFromFiles.resize(first + runs.back());
+    morton_t* codes = m_levelZeroLeafsFromFiles.data() + first;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t chunk = 0; chunk < numChunks; chunk++) {
+        ::std::copy(codesPerChunk[chunk].begin(), codesPerChunk[chunk].end(), codes + runs[chunk]);
+        ::std::vector<morton_t>().swap(codesPerChunk[chunk]);
+    }
+
+    mergeSortedRuns(codes, runs);
+    const size_t end = static_cast<size_t>(::std::unique(codes, codes + runs.back()) - codes);
+
+    m_levelZeroLeafsFromFiles.resize(first + end);
+    mergeLevelZeroLeafsFromFiles(first);
+}
+
+PointQuantization::PointQuantization(const ::std::array<double, 3>& worldLLF, const ::std::array<double, 3>& worldURB, double voxelSize)
+    : worldLLF(worldLLF), worldURB(worldURB), voxelSize(voxelSize) {
+}
+
+/**
+ * @brief The number of points quantized at once (the coordinates of a batch are computed in branch free loops that can be vectorized)
+ */
+static const size_t POINTS_PER_BATCH = 256;
+
+/**
+ * @brief Quantizes the points and encodes the leafs as morton codes
+ * @param maxCoord The maximum coordinate of a leaf in each dimension
+ */
+template <typename T>
+static void quantizePoints(const T* xyz, const size_t numPoints, const PointQuantization& quantization, const ::std::array<double, 3>& maxCoord,
+                           morton_t* codes) {
+    const double inverseVoxelSize = 1.0 / quantization.voxelSize;
+    coord_t coordinates[3][POINTS_PER_BATCH];
+
+    for (size_t first = 0; first < numPoints; first += POINTS_PER_BATCH) {
+        const size_t numPointsOfBatch = ::std::min(POINTS_PER_BATCH, numPoints - first);
+        const T* batch = xyz + 3 * first;
+
+        for (uint i = 0; i < 3; i++) {
+            const double llf = quantization.worldLLF[i];
+            const double max = maxCoord[i];
+
+            for (size_t p = 0; p < numPointsOfBatch; p++) {
+                double c = (static_cast<double>(batch[3 * p + i]) - llf) * inverseVoxelSize;
+                // written as comparisons (not ::std::max) so that NaN is clamped to 0
+                c = c >= 0.0 ? c : 0.0;
+                c = c <= max ? c : max;
+                coordinates[i][p] = static_cast<coord_t>(c);
+            }
+        }
+
+        for (size_t p = 0; p < numPointsOfBatch; p++) {
+            codes[first + p] = getMortonCodeForCoordinate(Vector3i(coordinates[0][p], coordinates[1][p], coordinates[2][p]));
+        }
+    }
+}
+
+/**
+ * @brief The maximum leaf coordinate of the bounding box of the quantization in each dimension (at most maxXYZ)
+ * @throws ::std::runtime_error If the quantization is invalid
+ */
+static ::std::array<double, 3> getMaxCoordOfQuantization(const PointQuantization& quantization, const Vector3i& maxXYZ) {
+    if (!(quantization.voxelSize > 0.0)) {
+        throw ::std::runtime_error("Invalid point quantization: The voxel size must be positive.");
+    }
+
+    ::std::array<double, 3> maxCoord;
+    for (uint i = 0; i < 3; i++) {
+        if (!(quantization.worldURB[i] >= quantization.worldLLF[i])) {
+            throw ::std::runtime_error("Invalid point quantization: The urb of the bounding box is less than its llf.");
+        }
+
+        // a point on the urb belongs to the last leaf
+        const double numLeafs = ::std::ceil((quantization.worldURB[i] - quantization.worldLLF[i]) / quantization.voxelSize);
+        maxCoord[i] = ::std::min(::std::max(numLeafs - 1.0, 0.0), static_cast<double>(maxXYZ[i]));
+    }
+
+    return maxCoord;
+}
+
+/**
+ * @brief The number of triangles voxelized by one thread at once
+ */
+static const size_t TRIANGLES_PER_CHUNK = 1024;
+
+size_t OctreeBuilder::addLevelZeroLeafsFromTriangles(const float* vertices, const size_t numVertices, const uint32_t* indices, const size_t numTriangles,
+                                                     const PointQuantization& quantization) {
+    const ::std::array<double, 3> maxCoord = getMaxCoordOfQuantization(quantization, m_maxXYZ);
+
+    for (size_t i = 0; i < 3 * numTriangles; i++) {
+        if (indices[i] >= numVertices) {
+            throw ::std::runtime_error("Invalid mesh: The index of a vertex is out of range.");
+        }
+    }
+
+    const Vector3i domainURB(static_cast<coord_t>(maxCoord[0]) + 1, static_cast<coord_t>(maxCoord[1]) + 1, static_cast<coord_t>(maxCoord[2]) + 1);
+    const Box domain(domainURB);
+    const double inverseVoxelSize = 1.0 / quantization.voxelSize;
+
+    addGeneratedLevelZeroLeafs(numTriangles, TRIANGLES_PER_CHUNK, [&](size_t first, size_t numTrianglesOfChunk, ::std::vector<morton_t>& codes) {
+        for (size_t t = first; t < first + numTrianglesOfChunk; t++) {
+            // the triangle in voxel space
+            Triangle triangle;
+            for (uint v = 0; v < 3; v++) {
+                const float* vertex = vertices + 3 * static_cast<size_t>(indices[3 * t + v]);
+                for (uint i = 0; i < 3; i++) {
+                    triangle[v][i] = (static_cast<double>(vertex[i]) - quantization.worldLLF[i]) * inverseVoxelSize;
+                }
+            }
+
+            voxelizeTriangle(triangle, domain, codes);
+        }
+    });
+
+    return numTriangles;
+}
+
+size_t OctreeBuilder::addLevelZeroLeafsFromPoints(const float* xyz, size_t numPoints, const PointQuantization& quantization) {
+    const ::std::array<double, 3> maxCoord = getMaxCoordOfQuantization(quantization, m_maxXYZ);
+
+    addEncodedLevelZeroLeafs(numPoints, [&](size_t first, size_t numPointsOfChunk, morton_t* codes) {
+        quantizePoints(xyz + 3 * first, numPointsOfChunk, quantization, maxCoord, codes);
+        return true;
+    });
+
+    return numPoints;
+}
+
+size_t OctreeBuilder::addLevelZeroLeafsFromPoints(const double* xyz, size_t numPoints, const PointQuantization& quantization) {
+    const ::std::array<double, 3> maxCoord = getMaxCoordOfQuantization(quantization, m_maxXYZ);
+
+    addEncodedLevelZeroLeafs(numPoints, [&](size_t first, size_t numPointsOfChunk, morton_t* codes) {
+        quantizePoints(xyz + 3 * first, numPointsOfChunk, quantization, maxCoord, codes);
+        return true;
+    });
+
+    return numPoints;
+}
+
+void OctreeBuilder::mergeLevelZeroLeafsFromFiles(size_t first) {
+    const size_t numAppended = m_levelZeroLeafsFromFiles.size() - first;
+    ::std::vector<morton_t> buffer(::std::min(MERGE_BUFFER_SIZE, ::std::max<size_t>(numAppended, 1)));
+    mergeAdjacentRuns(m_levelZeroLeafsFromFiles.data(), m_levelZeroLeafsFromFiles.data() + first,
+                      m_levelZeroLeafsFromFiles.data() + m_levelZeroLeafsFromFiles.size(), buffer.data(), buffer.size());
+    m_levelZeroLeafsFromFiles.erase(::std::unique(m_levelZeroLeafsFromFiles.begin(), m_levelZeroLeafsFromFiles.end()), m_levelZeroLeafsFromFiles.end());
+}
+
+size_t OctreeBuilder::occupancyWordsPerRow(coord_t sizeX) {
+    return (static_cast<size_t>(sizeX) + 63) / 64;
+}
+
+void OctreeBuilder::checkOccupancyBounds(const Vector3i& size, const Vector3i& llf) const {
+    for (uint i = 0; i < 3; i++) {
+        if (size[i] < 0 || llf[i] < 0 || (size[i] > 0 && llf[i] + size[i] - 1 > m_maxXYZ[i])) {
+            throw ::std::runtime_error("Invalid occupancy volume: The volume is outside of the bounding of the octree.");
+        }
+    }
+}
+
+uint64_t OctreeBuilder::occupancyWord(const uint64_t* row, size_t word, coord_t sizeX) {
+    const size_t numPaddingBits = occupancyWordsPerRow(sizeX) * 64 - static_cast<size_t>(sizeX);
+
+    if (word + 1 == occupancyWordsPerRow(sizeX) && numPaddingBits > 0) {
+        return row[word] & (~uint64_t(0) >> numPaddingBits);
+    }
+
+    return row[word];
+}
+
+size_t OctreeBuilder::countOccupiedVoxels(uint64_t word) {
+#ifdef MSVC
+    return static_cast<size_t>(__popcnt64(word));
+#else
+    return static_cast<size_t>(__builtin_popcountll(static_cast<unsigned long long>(word)));
+#endif
+}
+
+size_t OctreeBuilder::encodeOccupiedVoxels(uint64_t word, const Vector3i& llf, morton_t* codes) {
+    // the bits of the components don't overlap... the code of x can be or'ed to the code of y and z
+    const morton_t yzCode = getMortonCodeForCoordinate(Vector3i(0, llf.y(), llf.z()));
+    size_t numVoxels = 0;
+
+    while (word != 0) {
+#ifdef MSVC
+        unsigned long bit;
+        _BitScanForward64(&bit, word);
+#else
+        const int bit = __builtin_ctzll(static_cast<unsigned long long>(word));
+#endif
+        codes[numVoxels++] = yzCode | getMortonCodeForCoordinate(Vector3i(llf.x() + static_cast<coord_t>(bit), 0, 0));
+
+        // clear the lowest set bit
+        word &= word - 1;
+    }
+
+    return numVoxels;
+}
+
+size_t OctreeBuilder::addLevelZeroLeafsFromOccupancy(const uint64_t* occupancy, const Vector3i& size, const Vector3i& llf) {
+    checkOccupancyBounds(size, llf);
+
+    const size_t wordsPerRow = occupancyWordsPerRow(size.x());
+    const size_t wordsPerLayer = wordsPerRow * static_cast<size_t>(size.y());
+    const size_t numLayers = static_cast<size_t>(size.z());
+
+    // count the occupied voxels of each layer to know where its codes go
+    ::std::vector<size_t> firstVoxelOfLayer(numLayers + 1, 0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t z = 0; z < numLayers; z++) {
+        const uint64_t* layer = occupancy + z * wordsPerLayer;
+        size_t numVoxels = 0;
+
+        for (size_t row = 0; row < wordsPerLayer; row += wordsPerRow) {
+            for (size_t word = 0; word < wordsPerRow; word++) {
+                numVoxels += countOccupiedVoxels(occupancyWord(layer + row, word, size.x()));
+            }
+        }
+
+        firstVoxelOfLayer[z + 1] = numVoxels;
+    }
+
+    for (size_t z = 0; z < numLayers; z++) {
+        firstVoxelOfLayer[z + 1] += firstVoxelOfLayer[z];
+    }
+
+    const size_t numVoxels = firstVoxelOfLayer[numLayers];
+    const size_t first = m_levelZeroLeafsFromFiles.size();
+    m_levelZeroLeafsFromFiles.resize(first + numVoxels);
+    morton_t* codes = m_levelZeroLeafsFromFiles.data() + first;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t z = 0; z < numLayers; z++) {
+        if (firstVoxelOfLayer[z] == firstVoxelOfLayer[z + 1]) {
+            continue;
+        }
+
+        const uint64_t* layer = occupancy + z * wordsPerLayer;
+        morton_t* layerCodes = codes + firstVoxelOfLayer[z];
+
+        for (coord_t y = 0; y < size.y(); y++) {
+            const uint64_t* row = layer + static_cast<size_t>(y) * wordsPerRow;
+
+            for (size_t word = 0; word < wordsPerRow; word++) {
+                const uint64_t bits = occupancyWord(row, word, size.x());
+
+                if (bits != 0) {
+                    const Vector3i wordLLF = llf + Vector3i(static_cast<coord_t>(word * 64), y, static_cast<coord_t>(z));
+                    layerCodes += encodeOccupiedVoxels(bits, wordLLF, layerCodes);
+                }
+            }
+        }
+    }
+
+    // each voxel is only once in the volume
+    pss::parallel_stable_sort(m_levelZeroLeafsFromFiles.begin() + static_cast<::std::ptrdiff_t>(first), m_levelZeroLeafsFromFiles.end());
+    mergeLevelZeroLeafsFromFiles(first);
+
+    return numVoxels;
+}
+
+/**
+ * @brief The minimum number of parallel tasks per thread when seeding from a signed distance function (tasks differ a lot in their work)
+ */
+static const size_t ZERO_SET_TASKS_PER_THREAD = 16;
+
+/**
+ * @brief Finds the level zero leafs near the zero set of a signed distance function (see OctreeBuilder::addLevelZeroLeafsFromSignedDistance)
+ */
+struct ZeroSetQuery {
+    const SignedDistanceFunction& sdf;
+    double lipschitzBound;
+    double halfThickness;
+    Vector3i maxXYZ;
+
+    /**
+     * @brief Tests whether the octant may contain a leaf near the zero set (the llf of the octant must be inside of maxXYZ)
+     */
+    bool mayContainLeafs(const Vector3i& llf, const uint level) const {
+        // the center of the llfs of all leafs inside of the octant and the largest distance to one of them
+        const double halfExtent = static_cast<double>(getOctantSizeForLevel(level) - 1) / 2;
+        const ::std::array<double, 3> center = {static_cast<double>(llf.x()) + halfExtent, static_cast<double>(llf.y()) + halfExtent,
+                                                static_cast<double>(llf.z()) + halfExtent};
+        const double radius = halfExtent * ::std::sqrt(3.0);
+
+        return ::std::abs(sdf(center)) < halfThickness + lipschitzBound * radius;
+    }
+
+    /**
+     * @brief Appends the leafs of the octant near the zero set to codes (in ascending order)
+     */
+    void collectLeafs(const Vector3i& llf, const uint level, ::std::vector<morton_t>& codes) const {
+        if (!mayContainLeafs(llf, level)) {
+            return;
+        }
+
+        if (level == 0) {
+            codes.push_back(getMortonCodeForCoordinate(llf));
+            return;
+        }
+
+        const coord_t childSize = getOctantSizeForLevel(level - 1);
+        for (uint child = 0; child < 8; child++) {
+            const Vector3i childLLF = llf + Vector3i(child & 4 ? childSize : 0, child & 2 ? childSize : 0, child & 1 ? childSize : 0);
+
+            if (childLLF.x() <= maxXYZ.x() && childLLF.y() <= maxXYZ.y() && childLLF.z() <= maxXYZ.z()) {
+                collectLeafs(childLLF, level - 1, codes);
+            }
+        }
+    }
+};
+
+size_t OctreeBuilder::addLevelZeroLeafsFromSignedDistance(const SignedDistanceFunction& sdf, double lipschitzBound, double halfThickness) {
+    if (!(lipschitzBound > 0.0) || !(halfThickness >= 0.0)) {
+        throw ::std::runtime_error("Invalid signed distance function: The lipschitz bound must be positive and the half thickness must not be negative.");
+    }
+
+    const ZeroSetQuery query{sdf, lipschitzBound, halfThickness, m_maxXYZ};
+
+    // split the octants that may contain the zero set until there are enough tasks
+    const size_t minNumTasks = ZERO_SET_TASKS_PER_THREAD * static_cast<size_t>(omp_get_max_threads());
+    const OctantID root(Vector3i(0), getOctreeDepthForBounding(m_maxXYZ));
+
+    ::std::vector<OctantID> tasks;
+    if (query.mayContainLeafs(root.coord(), root.level())) {
+        tasks.push_back(root);
+    }
+
+    while (!tasks.empty() && tasks.size() < minNumTasks && tasks.front().level() > 0) {
+        ::std::vector<OctantID> children;
+
+        for (const OctantID& task : tasks) {
+            for (const OctantID& child : task.children()) {
+                const Vector3i& llf = child.coord();
+
+                if (llf.x() <= m_maxXYZ.x() && llf.y() <= m_maxXYZ.y() && llf.z() <= m_maxXYZ.z() && query.mayContainLeafs(llf, child.level())) {
+                    children.push_back(child);
+                }
+            }
+        }
+
+        tasks.swap(children);
+    }
+
+    ::std::atomic<size_t> numLeafs(0);
+
+    addGeneratedLevelZeroLeafs(tasks.size(), 1, [&](size_t first, size_t, ::std::vector<morton_t>& codes) {
+        const size_t numCodes = codes.size();
+        query.collectLeafs(tasks[first].coord(), tasks[first].level(), codes);
+        numLeafs += codes.size() - numCodes;
+    });
+
+    return numLeafs;
 }
 
 uint OctreeBuilder::maxLevel() {
     return m_maxLevel;
 }
 
+const BuildStats& OctreeBuilder::buildStats() const {
+    return m_buildStats;
+}
+
+void OctreeBuilder::setHardwareCountersEnabled(bool enabled) {
+    m_hardwareCountersEnabled = enabled;
+}
+
 OctreeBuilder::~OctreeBuilder() {
 }
 }
@@ -3,16 +3,72 @@
 #include "octreebuilder_api.h"
 
 #include "vector3i.h"
+#include "buildstats.h"
+#include "octreenode.h"
 
 #include "mortoncode.h"
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <limits>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 namespace octreebuilder {
 
 class Octree;
 
+/**
+ * @brief The formats of binary files of level zero leafs (see OctreeBuilder::addLevelZeroLeafsFromFile)
+ *
+ * All values are stored in the byte order of the machine.
+ */
+enum class LevelZeroLeafFileFormat {
+    /**
+     * @brief The llf of each leaf as three int32_t (x, y, z)
+     */
+    INT32_XYZ,
+    /**
+     * @brief The morton encoded llf of each leaf as uint64_t
+     */
+    MORTON_CODES
+};
+
+/**
+ * @brief Maps points in world space to level zero leafs (see OctreeBuilder::addLevelZeroLeafsFromPoints)
+ *
+ * The leaf (x, y, z) covers the points in [worldLLF + (x, y, z) * voxelSize, worldLLF + (x + 1, y + 1, z + 1) * voxelSize).
+ * Points outside of the bounding box worldLLF, worldURB are clamped to it (NaN components are mapped to the lowest leaf).
+ */
+struct OCTREEBUILDER_API PointQuantization {
+    PointQuantization(const ::std::array<double, 3>& worldLLF, const ::std::array<double, 3>& worldURB, double voxelSize);
+
+    ::std::array<double, 3> worldLLF;
+    ::std::array<double, 3> worldURB;
+
+    /**
+     * @brief The side length of a leaf in world space
+     */
+    double voxelSize;
+};
+
+/**
+ * @brief A signed distance function in leaf space (see OctreeBuilder::addLevelZeroLeafsFromSignedDistance)
+ *
+ * The parameter is a point in the coordinate system of the leafs (the leaf (x, y, z) has its llf at (x, y, z)). The function is called concurrently.
+ */
+typedef ::std::function<double(const ::std::array<double, 3>&)> SignedDistanceFunction;
+
+/**
+ * @brief Receives a chunk of leafs of an octree (see OctreeBuilder::finishBuilding(const LeafSink&))
+ *
+ * The first parameter points to the leafs of the chunk, the second one is the number of leafs.
+ * The pointer is only valid during the call.
+ */
+typedef ::std::function<void(const OctreeNode*, size_t)> LeafSink;
+
 /**
  * @brief Creates a 2:1 balanced octree with a bottom-up method
  *
@@ -20,6 +76,9 @@ class Octree;
  *  - It is complete and has the minimum number of nodes.
  *  - It contains all leaf-nodes added to the builder.
  *  - The level of adjacent octants differs at most by 1 (adjacent = share at least one vertex).
+ *
+ * The addLevelZeroLeafsFrom... functions add many leafs at once. They store only the sorted morton codes of the leafs (without duplicates),
+ * hence they need much less memory than adding the same leafs with addLevelZeroLeaf.
  */
 class OCTREEBUILDER_API OctreeBuilder {
 public:
@@ -40,15 +99,213 @@ public:
      */
     virtual morton_t addLevelZeroLeaf(const Vector3i& c) = 0;
 
+    /**
+     * @brief Adds a leaf node of any level to the octree (e.g. to refine a region only to the resolution it needs)
+     * @param c The llf of the node (must be a multiple of the size of the node)
+     * @param level The level of the node (addLevelZeroLeaf is called for level 0)
+     * @return The morton encoded llf of the node
+     * @throws ::std::runtime_error If c isn't the llf of a node of the level inside of (0,0,0) and maxXYZ
+     *
+     * The octree contains the node or its descendants: a node is split if it contains other added nodes or a finer neighbour requires it (2:1 balance).
+     * Nodes above maxLevel are split into nodes of maxLevel.
+     * A leaf can be added multiple times.
+     */
+    virtual morton_t addLeaf(const Vector3i& c, uint level);
+
+    /**
+     * @brief Adds all level zero leafs stored in a binary file
+     * @param path The path of the file
+     * @param format The format of the file
+     * @return The number of leafs in the file (including duplicates)
+     * @throws ::std::runtime_error If the file can't be mapped, its size doesn't match the format or a leaf is outside of (0,0,0) and maxXYZ (no leaf of the file is
+     * added then)
+     *
+     * The file is memory mapped and encoded in parallel chunks straight from the mapping (the pages of a chunk are released after it was encoded),
+     * hence the file itself is never read into memory.
+     */
+    virtual size_t addLevelZeroLeafsFromFile(const ::std::string& path, LevelZeroLeafFileFormat format);
+
+    /**
+     * @brief Adds the level zero leafs that contain the points of a point cloud
+     * @param xyz The coordinates of the points in world space (x, y, z of the first point, x, y, z of the second point, ...)
+     * @param numPoints The number of points
+     * @param quantization Maps the points to leafs
+     * @return numPoints
+     * @throws ::std::runtime_error If the quantization isn't valid (voxelSize must be positive and worldURB must not be less than worldLLF)
+     *
+     * The points are quantized, clamped to the bounding box (and maxXYZ) and morton encoded in parallel chunks.
+     * A leaf is stored once no matter how many points it contains.
+     */
+    size_t addLevelZeroLeafsFromPoints(const float* xyz, size_t numPoints, const PointQuantization& quantization);
+
+    /**
+     * @see addLevelZeroLeafsFromPoints(const float*, size_t, const PointQuantization&)
+     */
+    size_t addLevelZeroLeafsFromPoints(const double* xyz, size_t numPoints, const PointQuantization& quantization);
+
+    /**
+     * @brief Adds the level zero leafs that intersect the triangles of a mesh (conservative surface voxelization)
+     * @param vertices The coordinates of the vertices in world space (x, y, z of the first vertex, x, y, z of the second vertex, ...)
+     * @param numVertices The number of vertices
+     * @param indices The indices of the three vertices of each triangle
+     * @param numTriangles The number of triangles
+     * @param quantization Maps world space to leafs (see PointQuantization), the parts of the triangles outside of its bounding box are ignored
+     * @return numTriangles
+     * @throws ::std::runtime_error If the quantization or an index isn't valid (no leaf is added then)
+     *
+     * The triangles are voxelized in parallel chunks: for each triangle the smallest octant containing it is subdivided recursively and octants that don't
+     * intersect the triangle are skipped. The leafs shared by adjacent triangles are stored once.
+     */
+    size_t addLevelZeroLeafsFromTriangles(const float* vertices, size_t numVertices, const uint32_t* indices, size_t numTriangles,
+                                          const PointQuantization& quantization);
+
+    /**
+     * @brief Adds the level zero leafs near the zero set of a signed distance function (e.g. the surface of an implicit solid)
+     * @param sdf The function, only needs to be a bound of the distance (see lipschitzBound)
+     * @param lipschitzBound A bound L with |sdf(a) - sdf(b)| <= L * |a - b| for all points a and b (1 for an exact signed distance function)
+     * @param halfThickness The leafs with |sdf(llf)| < halfThickness are added
+     * @return The number of added leafs
+     * @throws ::std::runtime_error If lipschitzBound isn't positive or halfThickness is negative
+     *
+     * The octants are visited top down and skipped with all their leafs if the bound proves that none of them is close enough to the zero set,
+     * hence the number of calls grows with the area of the surface and not with the volume of the octree.
+     * The octants that may contain the surface are split into parallel tasks.
+     */
+    size_t addLevelZeroLeafsFromSignedDistance(const SignedDistanceFunction& sdf, double lipschitzBound, double halfThickness);
+
+    /**
+     * @brief Adds a level zero leaf for each occupied voxel of a bit-packed occupancy volume (e.g. a segmentation mask)
+     * @param occupancy The bits of the volume: the voxel (x, y, z) is bit x % 64 of word (z * size.y() + y) * occupancyWordsPerRow(size.x()) + x / 64,
+     * i.e. each row of voxels starts with a new word (the padding bits at the end of a row are ignored)
+     * @param size The number of voxels of the volume in each dimension
+     * @param llf The llf of the leaf of the voxel (0, 0, 0)
+     * @return The number of occupied voxels
+     * @throws ::std::runtime_error If the volume isn't inside of (0,0,0) and maxXYZ (no leaf is added then)
+     *
+     * The layers of the volume are scanned in parallel a word at a time: empty words and layers are skipped, the occupied voxels of a word are found with
+     * popcount and tzcnt. Only the occupied voxels are stored (a morton code each), the empty ones don't need any memory.
+     */
+    virtual size_t addLevelZeroLeafsFromOccupancy(const uint64_t* occupancy, const Vector3i& size, const Vector3i& llf = Vector3i(0));
+
+    /**
+     * @brief The number of words of a row of an occupancy volume (see addLevelZeroLeafsFromOccupancy)
+     * @param sizeX The number of voxels of a row
+     */
+    static size_t occupancyWordsPerRow(coord_t sizeX);
+
     virtual ::std::unique_ptr<Octree> finishBuilding() = 0;
 
+    /**
+     * @brief Creates the octree and passes its leafs to the sink instead of storing them in an Octree
+     * @param sink Receives all leafs of the octree in ascending morton order (in chunks, one call at a time)
+     * @throws Any exception thrown by the sink (no more leafs are passed to the sink then)
+     *
+     * The chunks are passed as soon as they are final, hence the whole octree is never stored at once.
+     */
+    virtual void finishBuilding(const LeafSink& sink) = 0;
+
+    /**
+     * @brief The statistics (phase times and sizes) of the last call of finishBuilding
+     */
+    const BuildStats& buildStats() const;
+
+    /**
+     * @brief Enables measuring hardware performance counters (cache misses, branch misses, instructions, ...) of each phase of finishBuilding
+     *
+     * The counter values are reported in buildStats(). They are invalid if the platform doesn't provide the counters (see HardwareCounters).
+     */
+    void setHardwareCountersEnabled(bool enabled);
+
     virtual ~OctreeBuilder();
 
 protected:
     Vector3i m_maxXYZ;
+    BuildStats m_buildStats;
+    bool m_hardwareCountersEnabled;
+
+    /**
+     * @brief The sorted morton codes of the level zero leafs added by the addLevelZeroLeafsFrom... functions (without duplicates)
+     */
+    ::std::vector<morton_t> m_levelZeroLeafsFromFiles;
+
+    /**
+     * @brief The lowest level of the leafs above level zero added by addLeaf for each morton code (a finer leaf at the same llf contains the coarser ones)
+     */
+    ::std::unordered_map<morton_t, uint> m_leafsAboveLevelZero;
 
     uint maxLevel();
 
+    /**
+     * @brief The size of a leaf in a file of the format in bytes
+     */
+    static size_t levelZeroLeafRecordSize(LevelZeroLeafFileFormat format);
+
+    /**
+     * @brief Encodes the leafs of a file as morton codes
+     * @param records The first leaf of the file
+     * @param numLeafs The number of leafs to encode
+     * @param format The format of the file
+     * @param maxXYZ The maximum llf of any leaf
+     * @param codes The morton codes are written to [codes, codes + numLeafs)
+     * @return false If a leaf is outside of (0,0,0) and maxXYZ
+     */
+    static bool encodeLevelZeroLeafs(const char* records, const size_t numLeafs, const LevelZeroLeafFileFormat format, const Vector3i& maxXYZ, morton_t* codes);
+
+    /**
+     * @brief Encodes the leafs [first, first + numLeafs) of an input as morton codes to codes
+     * @return false If a leaf is invalid
+     */
+    typedef ::std::function<bool(size_t first, size_t numLeafs, morton_t* codes)> LevelZeroLeafEncoder;
+
+    /**
+     * @brief Adds numLeafs leafs of an input which are encoded in parallel chunks (the encoder is called concurrently)
+     * @return false If a leaf is invalid (no leaf of the input is added then)
+     *
+     * The codes of each chunk are sorted and deduplicated right away, hence inputs with many duplicates need little memory.
+     */
+    virtual bool addEncodedLevelZeroLeafs(size_t numLeafs, const LevelZeroLeafEncoder& encode);
+
+    /**
+     * @brief Appends the morton codes of the leafs generated by the items [first, first + numItems) of an input to codes (any number per item)
+     */
+    typedef ::std::function<void(size_t first, size_t numItems, ::std::vector<morton_t>& codes)> LevelZeroLeafGenerator;
+
+    /**
+     * @brief Adds the leafs generated by numItems items of an input (e.g. triangles) in parallel chunks of itemsPerChunk items
+     *
+     * The generator is called concurrently. Like in addEncodedLevelZeroLeafs the codes of each chunk are sorted and deduplicated right away.
+     */
+    virtual void addGeneratedLevelZeroLeafs(size_t numItems, size_t itemsPerChunk, const LevelZeroLeafGenerator& generate);
+
+    /**
+     * @brief Merges the sorted morton codes appended to m_levelZeroLeafsFromFiles (from first on) with the ones before (removes all duplicates)
+     */
+    void mergeLevelZeroLeafsFromFiles(size_t first);
+
+    /**
+     * @brief Throws a ::std::runtime_error if the occupancy volume isn't inside of (0,0,0) and maxXYZ (see addLevelZeroLeafsFromOccupancy)
+     */
+    void checkOccupancyBounds(const Vector3i& size, const Vector3i& llf) const;
+
+    /**
+     * @brief The word of a row of an occupancy volume without the padding bits at the end of the row
+     */
+    static uint64_t occupancyWord(const uint64_t* row, size_t word, coord_t sizeX);
+
+    /**
+     * @brief The number of occupied voxels of a word
+     */
+    static size_t countOccupiedVoxels(uint64_t word);
+
+    /**
+     * @brief Encodes the occupied voxels of a word as morton codes
+     * @param word The bits of 64 consecutive voxels of a row
+     * @param llf The llf of the leaf of bit 0
+     * @param codes The morton codes are written to [codes, codes + countOccupiedVoxels(word)) in ascending order
+     * @return The number of occupied voxels of the word
+     */
+    static size_t encodeOccupiedVoxels(uint64_t word, const Vector3i& llf, morton_t* codes);
+
 private:
     uint m_maxLevel;
 };
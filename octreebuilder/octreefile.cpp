@@ -0,0 +1,591 @@
+#include "octreefile.h"
+
+#include "checksum.h"
+#include "linearoctree.h"
+#include "mappedoctree.h"
+#include "memorymappedfile.h"
+#include "mortoncode_utils.h"
+#include "octree_impl.h"
+#include "octreefileformat.h"
+#include "octreefilewriter.h"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace octreebuilder {
+
+/*
+ * Encoding of a block of a compressed file (all integers are LEB128 varints):
+ *  - the morton code of the first leaf
+ *  - the number of level runs, followed by the level and the length of each run
+ *  - the number of mispredicted leafs, followed by (index - index of the previous mispredicted leaf, zigzag(morton code - predicted morton code)) of each
+ *
+ * The morton code of a leaf is predicted as the successor of the deepest last decendant of its predecessor.
+ * This is always correct for a complete linear octree, hence such a tree is stored as level runs only.
+ */
+
+static morton_t predictNextMortonCode(const morton_t mcode, const uint level) {
+    return getMortonCodeForDeepestLastDecendant(mcode, level) + 1;
+}
+
+static void appendVarint(::std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void encodeBlock(const uint64_t* codes, const uint8_t* levels, const size_t numLeafs, ::std::vector<uint8_t>& out) {
+    out.clear();
+
+    if (numLeafs == 0) {
+        return;
+    }
+
+    ::std::vector<::std::pair<uint8_t, uint64_t>> runs;
+    ::std::vector<::std::pair<uint64_t, uint64_t>> mispredictions;
+
+    size_t previousMisprediction = 0;
+    for (size_t i = 0; i < numLeafs; i++) {
+        if (runs.empty() || runs.back().first != levels[i]) {
+            runs.push_back(::std::make_pair(levels[i], 0));
+        }
+        runs.back().second++;
+
+        if (i == 0) {
+            continue;
+        }
+
+        const morton_t predicted = predictNextMortonCode(codes[i - 1], levels[i - 1]);
+        if (codes[i] != predicted) {
+            // the difference modulo 2^64 (negative for overlapping or unsorted leafs) is zigzag encoded
+            const int64_t difference = static_cast<int64_t>(codes[i] - predicted);
+            const uint64_t zigzag = (static_cast<uint64_t>(difference) << 1) ^ static_cast<uint64_t>(difference >> 63);
+            mispredictions.push_back(::std::make_pair(i - previousMisprediction, zigzag));
+            previousMisprediction = i;
+        }
+    }
+
+    appendVarint(out, codes[0]);
+
+    appendVarint(out, runs.size());
+    for (const ::std::pair<uint8_t, uint64_t>& run : runs) {
+        appendVarint(out, run.first);
+        appendVarint(out, run.second);
+    }
+
+    appendVarint(out, mispredictions.size());
+    for (const ::std::pair<uint64_t, uint64_t>& misprediction : mispredictions) {
+        appendVarint(out, misprediction.first);
+        appendVarint(out, misprediction.second);
+    }
+}
+
+/**
+ * @brief Reads the varints of an encoded block
+ */
+class VarintReader {
+public:
+    VarintReader(const uint8_t* begin, const uint8_t* end) : m_pos(begin), m_end(end) {
+    }
+
+    /**
+     * @return false If the data is invalid (ends within a varint or the value doesn't fit in 64 bit)
+     */
+    bool read(uint64_t& value) {
+        value = 0;
+        for (uint shift = 0; shift < 64; shift += 7) {
+            if (m_pos == m_end) {
+                return false;
+            }
+
+            const uint8_t byte = *m_pos++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool atEnd() const {
+        return m_pos == m_end;
+    }
+
+private:
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+};
+
+/**
+ * @brief Decodes a block into leafs
+ * @return false If the block is invalid
+ */
+static bool decodeBlock(const uint8_t* begin, const uint8_t* end, const size_t numLeafs, const uint depth, OctantID* leafs) {
+    VarintReader reader(begin, end);
+
+    if (numLeafs == 0) {
+        return reader.atEnd();
+    }
+
+    uint64_t firstCode;
+    uint64_t numRuns;
+    if (!reader.read(firstCode) || !reader.read(numRuns) || numRuns > numLeafs) {
+        return false;
+    }
+
+    // first the levels...
+    size_t i = 0;
+    for (uint64_t run = 0; run < numRuns; run++) {
+        uint64_t level;
+        uint64_t length;
+        if (!reader.read(level) || !reader.read(length) || level > depth || length > numLeafs - i) {
+            return false;
+        }
+
+        for (const size_t runEnd = i + static_cast<size_t>(length); i < runEnd; i++) {
+            leafs[i] = OctantID(morton_t(0), static_cast<uint>(level));
+        }
+    }
+
+    if (i != numLeafs) {
+        return false;
+    }
+
+    // ... then the morton codes (predicted or corrected)
+    uint64_t numMispredictions;
+    if (!reader.read(numMispredictions) || numMispredictions >= numLeafs) {
+        return false;
+    }
+
+    uint64_t nextMisprediction = numLeafs;
+    uint64_t correction = 0;
+    auto readMisprediction = [&reader, &nextMisprediction, &correction, numLeafs](const uint64_t previous) {
+        uint64_t distance;
+        uint64_t zigzag;
+        if (!reader.read(distance) || !reader.read(zigzag) || distance == 0 || distance >= numLeafs - previous) {
+            return false;
+        }
+        nextMisprediction = previous + distance;
+        correction = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+        return true;
+    };
+
+    if (numMispredictions > 0 && !readMisprediction(0)) {
+        return false;
+    }
+
+    uint64_t numReadMispredictions = numMispredictions > 0 ? 1 : 0;
+    leafs[0] = OctantID(firstCode, leafs[0].level());
+    for (size_t j = 1; j < numLeafs; j++) {
+        morton_t mcode = predictNextMortonCode(leafs[j - 1].mcode(), leafs[j - 1].level());
+
+        if (j == nextMisprediction) {
+            mcode += correction;
+            nextMisprediction = numLeafs;
+
+            if (numReadMispredictions < numMispredictions) {
+                if (!readMisprediction(j)) {
+                    return false;
+                }
+                numReadMispredictions++;
+            }
+        }
+
+        leafs[j] = OctantID(mcode, leafs[j].level());
+    }
+
+    return numReadMispredictions == numMispredictions && nextMisprediction == numLeafs && reader.atEnd();
+}
+
+static octreefile::Header createHeader(const uint depth, const ::std::string& path, uint32_t flags) {
+    if (depth >= octreefile::MAX_NUM_LEVELS) {
+        throw ::std::runtime_error("Can't write the octree file " + path + ": The depth of the octree is too large.");
+    }
+
+    octreefile::Header header;
+    ::std::memset(&header, 0, sizeof(header));
+    ::std::memcpy(header.magic, octreefile::MAGIC, sizeof(header.magic));
+    header.version = octreefile::VERSION;
+    header.byteOrderMark = octreefile::BYTE_ORDER_MARK;
+    header.flags = flags;
+    header.depth = depth;
+
+    const Vector3i maxXYZ = getMaxXYZForOctreeDepth(depth);
+    for (uint i = 0; i < 3; i++) {
+        header.maxXYZ[i] = static_cast<int64_t>(maxXYZ[i]);
+    }
+    header.blockSize = octreefile::BLOCK_SIZE;
+
+    return header;
+}
+
+static octreefile::Header createHeader(const Octree& octree, const ::std::string& path, uint32_t flags) {
+    octreefile::Header header = createHeader(octree.getDepth(), path, flags);
+    header.numLeafs = octree.getNumNodes();
+    return header;
+}
+
+/**
+ * @brief Calls processBatch for consecutive batches of blocks (one block per thread) with the morton codes and levels of the leafs of the batch
+ *
+ * Counts the leafs per level of the header.
+ */
+static void forEachBatchOfBlocks(const Octree& octree, octreefile::Header& header,
+                                 const ::std::function<void(size_t firstBlock, size_t numBlocks, const ::std::vector<uint64_t>& codes,
+                                                            const ::std::vector<uint8_t>& levels)>& processBatch) {
+    const size_t blockSize = static_cast<size_t>(header.blockSize);
+    const size_t numBlocks = static_cast<size_t>(header.numBlocks());
+    const size_t numBlocksPerBatch = static_cast<size_t>(omp_get_max_threads());
+
+    ::std::vector<uint64_t> codes;
+    ::std::vector<uint8_t> levels;
+
+    for (size_t firstBlock = 0; firstBlock < numBlocks; firstBlock += numBlocksPerBatch) {
+        const size_t first = firstBlock * blockSize;
+        const size_t numLeafsOfBatch = ::std::min<size_t>(numBlocksPerBatch * blockSize, static_cast<size_t>(header.numLeafs) - first);
+
+        codes.resize(numLeafsOfBatch);
+        levels.resize(numLeafsOfBatch);
+
+#pragma omp parallel
+        {
+            ::std::vector<uint64_t> numLeafsPerLevelOfThread(octreefile::MAX_NUM_LEVELS, 0);
+
+#pragma omp for schedule(static)
+            for (size_t i = 0; i < numLeafsOfBatch; i++) {
+                const OctreeNode node = octree.getNode(first + i);
+                codes[i] = node.getMortonEncodedLLF();
+                levels[i] = static_cast<uint8_t>(node.getLevel());
+                numLeafsPerLevelOfThread[node.getLevel()]++;
+            }
+
+#pragma omp critical
+            for (size_t level = 0; level < octreefile::MAX_NUM_LEVELS; level++) {
+                header.numLeafsPerLevel[level] += numLeafsPerLevelOfThread[level];
+            }
+        }
+
+        processBatch(firstBlock, (numLeafsOfBatch + blockSize - 1) / blockSize, codes, levels);
+    }
+}
+
+static void writeAt(::std::ofstream& file, const ::std::string& path, const uint64_t offset, const void* data, const size_t size) {
+    file.seekp(static_cast<::std::streamoff>(offset));
+    file.write(static_cast<const char*>(data), static_cast<::std::streamsize>(size));
+
+    if (!file) {
+        throw ::std::runtime_error("Failed to write the octree file " + path + ".");
+    }
+}
+
+static ::std::ofstream openForWriting(const ::std::string& path) {
+    ::std::ofstream file(path, ::std::ios::binary | ::std::ios::trunc);
+    if (!file) {
+        throw ::std::runtime_error("Can't open the octree file " + path + " for writing.");
+    }
+    return file;
+}
+
+static void finishFile(::std::ofstream& file, const ::std::string& path, octreefile::Header& header) {
+    header.headerChecksum = crc32(&header, sizeof(header));
+    writeAt(file, path, 0, &header, sizeof(header));
+
+    file.close();
+    if (!file) {
+        throw ::std::runtime_error("Failed to write the octree file " + path + ".");
+    }
+}
+
+void writeOctreeFile(const Octree& octree, const ::std::string& path, bool withChecksums) {
+    octreefile::Header header = createHeader(octree, path, withChecksums ? octreefile::FLAG_CHECKSUMS : 0);
+    const octreefile::Layout layout(header);
+    const size_t blockSize = static_cast<size_t>(header.blockSize);
+
+    ::std::ofstream file = openForWriting(path);
+    ::std::vector<uint32_t> checksums(static_cast<size_t>(header.numBlocks()));
+
+    forEachBatchOfBlocks(octree, header, [&](size_t firstBlock, size_t numBlocks, const ::std::vector<uint64_t>& codes, const ::std::vector<uint8_t>& levels) {
+        if (withChecksums) {
+#pragma omp parallel for schedule(static)
+            for (size_t block = 0; block < numBlocks; block++) {
+                const size_t begin = block * blockSize;
+                const size_t numLeafsOfBlock = ::std::min(blockSize, codes.size() - begin);
+
+                const uint32_t crc = crc32(codes.data() + begin, numLeafsOfBlock * sizeof(uint64_t));
+                checksums[firstBlock + block] = crc32(levels.data() + begin, numLeafsOfBlock, crc);
+            }
+        }
+
+        const uint64_t first = firstBlock * blockSize;
+        writeAt(file, path, layout.codesOffset + first * sizeof(uint64_t), codes.data(), codes.size() * sizeof(uint64_t));
+        writeAt(file, path, layout.levelsOffset + first, levels.data(), levels.size());
+    });
+
+    if (withChecksums) {
+        // padding between the levels and the checksums
+        const ::std::vector<char> padding(layout.checksumsOffset - (layout.levelsOffset + header.numLeafs), 0);
+        writeAt(file, path, layout.levelsOffset + header.numLeafs, padding.data(), padding.size());
+        writeAt(file, path, layout.checksumsOffset, checksums.data(), checksums.size() * sizeof(uint32_t));
+    }
+
+    finishFile(file, path, header);
+}
+
+void writeCompressedOctreeFile(const Octree& octree, const ::std::string& path, bool withChecksums) {
+    octreefile::Header header = createHeader(octree, path, octreefile::FLAG_COMPRESSED | (withChecksums ? octreefile::FLAG_CHECKSUMS : 0));
+    const octreefile::CompressedLayout layout(header);
+    const size_t blockSize = static_cast<size_t>(header.blockSize);
+
+    ::std::ofstream file = openForWriting(path);
+    ::std::vector<uint64_t> blockOffsets(1, layout.dataOffset);
+    ::std::vector<uint32_t> checksums;
+    ::std::vector<::std::vector<uint8_t>> encodedBlocks(static_cast<size_t>(omp_get_max_threads()));
+
+    forEachBatchOfBlocks(octree, header, [&](size_t, size_t numBlocks, const ::std::vector<uint64_t>& codes, const ::std::vector<uint8_t>& levels) {
+#pragma omp parallel for schedule(static)
+        for (size_t block = 0; block < numBlocks; block++) {
+            const size_t begin = block * blockSize;
+            encodeBlock(codes.data() + begin, levels.data() + begin, ::std::min(blockSize, codes.size() - begin), encodedBlocks[block]);
+        }
+
+        for (size_t block = 0; block < numBlocks; block++) {
+            const ::std::vector<uint8_t>& encoded = encodedBlocks[block];
+            writeAt(file, path, blockOffsets.back(), encoded.data(), encoded.size());
+            blockOffsets.push_back(blockOffsets.back() + encoded.size());
+
+            if (withChecksums) {
+                checksums.push_back(crc32(encoded.data(), encoded.size()));
+            }
+        }
+    });
+
+    writeAt(file, path, layout.blockOffsetsOffset, blockOffsets.data(), blockOffsets.size() * sizeof(uint64_t));
+    writeAt(file, path, layout.checksumsOffset, checksums.data(), checksums.size() * sizeof(uint32_t));
+
+    finishFile(file, path, header);
+}
+
+/**
+ * @brief The path of the temporary file of the levels of the file at path
+ */
+static ::std::string levelsPath(const ::std::string& path, const ::std::string& tempDirectory) {
+    if (tempDirectory.empty()) {
+        return path + ".levels";
+    }
+
+    const ::std::string fileName = path.substr(path.find_last_of('/') + 1);
+    return tempDirectory + "/" + fileName + ".levels";
+}
+
+OctreeFileWriter::OctreeFileWriter(const ::std::string& path, uint depth, bool withChecksums, const ::std::string& tempDirectory, size_t bufferSize)
+    : m_path(path),
+      m_levelsPath(levelsPath(path, tempDirectory)),
+      m_header(createHeader(depth, path, withChecksums ? octreefile::FLAG_CHECKSUMS : 0)),
+      m_numWrittenLeafsOfBlock(0),
+      m_blockChecksum(0) {
+    m_file = openForWriting(m_path);
+
+    // the levels of a block that doesn't fit into the buffer are read back to compute its checksum
+    m_levelsFile.open(m_levelsPath, ::std::ios::binary | ::std::ios::in | ::std::ios::out | ::std::ios::trunc);
+    if (!m_levelsFile) {
+        throw ::std::runtime_error("Can't open the octree file " + m_levelsPath + " for writing.");
+    }
+
+    const size_t blockSize = static_cast<size_t>(m_header.blockSize);
+    m_bufferSize = bufferSize > 0 ? ::std::min(bufferSize, blockSize) : blockSize;
+    m_codes.reserve(m_bufferSize);
+    m_levels.reserve(m_bufferSize);
+}
+
+OctreeFileWriter::~OctreeFileWriter() {
+    m_levelsFile.close();
+    ::std::remove(m_levelsPath.c_str());
+}
+
+void OctreeFileWriter::append(const OctantID& leaf) {
+    m_codes.push_back(leaf.mcode());
+    m_levels.push_back(static_cast<uint8_t>(leaf.level()));
+    m_header.numLeafsPerLevel[leaf.level()]++;
+
+    const bool endOfBlock = m_numWrittenLeafsOfBlock + m_codes.size() == m_header.blockSize;
+    if (endOfBlock || m_codes.size() == m_bufferSize) {
+        writeBuffer(endOfBlock);
+    }
+}
+
+size_t OctreeFileWriter::numLeafs() const {
+    return static_cast<size_t>(m_header.numLeafs) + m_codes.size();
+}
+
+void OctreeFileWriter::writeBuffer(bool endOfBlock) {
+    const bool wholeBlockBuffered = m_numWrittenLeafsOfBlock == 0;
+
+    if (m_header.hasChecksums()) {
+        m_blockChecksum = crc32(m_codes.data(), m_codes.size() * sizeof(uint64_t), m_blockChecksum);
+    }
+
+    writeAt(m_file, m_path, sizeof(octreefile::Header) + m_header.numLeafs * sizeof(uint64_t), m_codes.data(), m_codes.size() * sizeof(uint64_t));
+
+    m_levelsFile.write(reinterpret_cast<const char*>(m_levels.data()), static_cast<::std::streamsize>(m_levels.size()));
+    if (!m_levelsFile) {
+        throw ::std::runtime_error("Failed to write the octree file " + m_path + ".");
+    }
+
+    m_header.numLeafs += m_codes.size();
+    m_numWrittenLeafsOfBlock += m_codes.size();
+    m_codes.clear();
+
+    if (endOfBlock && m_header.hasChecksums()) {
+        // the checksum covers all codes of the block followed by all its levels
+        if (wholeBlockBuffered) {
+            m_blockChecksum = crc32(m_levels.data(), m_levels.size(), m_blockChecksum);
+        } else {
+            m_levelsFile.seekg(static_cast<::std::streamoff>(m_header.numLeafs - m_numWrittenLeafsOfBlock));
+
+            for (uint64_t numRemaining = m_numWrittenLeafsOfBlock; numRemaining > 0;) {
+                m_levels.resize(static_cast<size_t>(::std::min<uint64_t>(numRemaining, m_bufferSize)));
+                m_levelsFile.read(reinterpret_cast<char*>(m_levels.data()), static_cast<::std::streamsize>(m_levels.size()));
+                if (!m_levelsFile) {
+                    throw ::std::runtime_error("Failed to read the temporary file " + m_levelsPath + ".");
+                }
+
+                m_blockChecksum = crc32(m_levels.data(), m_levels.size(), m_blockChecksum);
+                numRemaining -= m_levels.size();
+            }
+
+            m_levelsFile.seekp(0, ::std::ios::end);
+        }
+
+        m_checksums.push_back(m_blockChecksum);
+    }
+
+    m_levels.clear();
+
+    if (endOfBlock) {
+        m_numWrittenLeafsOfBlock = 0;
+        m_blockChecksum = 0;
+    }
+}
+
+void OctreeFileWriter::finish() {
+    if (!m_codes.empty() || m_numWrittenLeafsOfBlock > 0) {
+        writeBuffer(true);
+    }
+
+    m_levelsFile.close();
+    if (!m_levelsFile) {
+        throw ::std::runtime_error("Failed to write the octree file " + m_path + ".");
+    }
+
+    const octreefile::Layout layout(m_header);
+
+    // append the levels
+    ::std::ifstream levelsFile(m_levelsPath, ::std::ios::binary);
+    m_file.seekp(static_cast<::std::streamoff>(layout.levelsOffset));
+    if (m_header.numLeafs > 0) {
+        m_file << levelsFile.rdbuf();
+    }
+
+    if (!levelsFile || !m_file) {
+        throw ::std::runtime_error("Failed to write the octree file " + m_path + ".");
+    }
+
+    if (m_header.hasChecksums()) {
+        // padding between the levels and the checksums
+        const ::std::vector<char> padding(layout.checksumsOffset - (layout.levelsOffset + m_header.numLeafs), 0);
+        writeAt(m_file, m_path, layout.levelsOffset + m_header.numLeafs, padding.data(), padding.size());
+        writeAt(m_file, m_path, layout.checksumsOffset, m_checksums.data(), m_checksums.size() * sizeof(uint32_t));
+    }
+
+    finishFile(m_file, m_path, m_header);
+}
+
+::std::unique_ptr<Octree> mapOctreeFile(const ::std::string& path, bool verifyChecksums) {
+    return ::std::unique_ptr<Octree>(new MappedOctree(path, verifyChecksums));
+}
+
+static LinearOctree readCompressedLeafs(const MemoryMappedFile& file, const octreefile::Header& header, bool verifyChecksums) {
+    const octreefile::CompressedLayout layout(header);
+    const size_t numBlocks = static_cast<size_t>(header.numBlocks());
+
+    if (file.size() < layout.dataOffset) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The file is too small.");
+    }
+
+    ::std::vector<uint64_t> blockOffsets(numBlocks + 1);
+    ::std::memcpy(blockOffsets.data(), file.data() + layout.blockOffsetsOffset, blockOffsets.size() * sizeof(uint64_t));
+
+    if (blockOffsets.front() != layout.dataOffset || blockOffsets.back() != file.size() || !::std::is_sorted(blockOffsets.begin(), blockOffsets.end())) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": Invalid block offsets.");
+    }
+
+    ::std::vector<uint32_t> checksums(header.hasChecksums() ? numBlocks : 0);
+    ::std::memcpy(checksums.data(), file.data() + layout.checksumsOffset, checksums.size() * sizeof(uint32_t));
+
+    LinearOctree::container_type leafs(static_cast<size_t>(header.numLeafs));
+    ::std::atomic<bool> validChecksums(true);
+    ::std::atomic<bool> validBlocks(true);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t block = 0; block < numBlocks; block++) {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(file.data() + blockOffsets[block]);
+        const uint8_t* end = reinterpret_cast<const uint8_t*>(file.data() + blockOffsets[block + 1]);
+
+        if (verifyChecksums && header.hasChecksums() && crc32(begin, static_cast<size_t>(end - begin)) != checksums[block]) {
+            validChecksums = false;
+            continue;
+        }
+
+        const size_t first = block * static_cast<size_t>(header.blockSize);
+        const size_t numLeafsOfBlock = ::std::min<size_t>(static_cast<size_t>(header.blockSize), leafs.size() - first);
+
+        if (!decodeBlock(begin, end, numLeafsOfBlock, header.depth, leafs.data() + first)) {
+            validBlocks = false;
+        }
+
+        // the block is decoded... its pages aren't needed anymore
+        file.release(blockOffsets[block], static_cast<size_t>(blockOffsets[block + 1] - blockOffsets[block]));
+    }
+
+    if (!validChecksums) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The checksum of the leafs doesn't match.");
+    }
+
+    if (!validBlocks) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": A block of leafs is corrupted.");
+    }
+
+    return LinearOctree(OctantID(0, header.depth), ::std::move(leafs));
+}
+
+::std::unique_ptr<Octree> readOctreeFile(const ::std::string& path, bool verifyChecksums) {
+    MemoryMappedFile file(path, MemoryMappedFile::AccessPattern::SEQUENTIAL);
+    const octreefile::Header header = octreefile::readHeader(file);
+
+    if (header.isCompressed()) {
+        return ::std::unique_ptr<Octree>(new OctreeImpl(readCompressedLeafs(file, header, verifyChecksums)));
+    }
+
+    const MappedOctree mapped(::std::move(file), header, verifyChecksums);
+    LinearOctree::container_type leafs(mapped.getNumNodes());
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < leafs.size(); i++) {
+        const OctreeNode node = mapped.getNode(i);
+        leafs[i] = OctantID(node.getMortonEncodedLLF(), node.getLevel());
+    }
+
+    return ::std::unique_ptr<Octree>(new OctreeImpl(LinearOctree(OctantID(0, mapped.getDepth()), ::std::move(leafs))));
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+#include "octree.h"
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief Binary octree files
+ *
+ * A file stores the depth, the bounding and the leafs of a balanced linear octree (morton code and level of each leaf in morton order).
+ * The format is versioned and can contain checksums of the leafs.
+ * An uncompressed file can be memory mapped and queried in place, hence loading it is almost free.
+ * A compressed file stores the leafs delta encoded (a complete octree needs about a byte per run of leafs with the same level),
+ * it's much smaller but must be decoded into memory.
+ */
+namespace octreebuilder {
+
+/**
+ * @brief Writes the octree to a binary octree file
+ * @param octree The octree (its nodes must be ordered, e.g. an octree created by an OctreeBuilder)
+ * @param path The path of the file (is overwritten)
+ * @param withChecksums Whether to store checksums of the leafs
+ * @throws ::std::runtime_error If the file can't be written
+ */
+OCTREEBUILDER_API void writeOctreeFile(const Octree& octree, const ::std::string& path, bool withChecksums = true);
+
+/**
+ * @brief Writes the octree to a compressed binary octree file
+ *
+ * The leafs are encoded in blocks, in parallel.
+ * The morton code of each leaf is predicted from its predecessor (exact for complete octrees), only the levels and mispredictions are stored.
+ *
+ * @param octree The octree (its nodes must be ordered, e.g. an octree created by an OctreeBuilder)
+ * @param path The path of the file (is overwritten)
+ * @param withChecksums Whether to store checksums of the encoded blocks
+ * @throws ::std::runtime_error If the file can't be written
+ */
+OCTREEBUILDER_API void writeCompressedOctreeFile(const Octree& octree, const ::std::string& path, bool withChecksums = true);
+
+/**
+ * @brief Memory maps a binary octree file
+ * @param path The path of the file
+ * @param verifyChecksums Whether to verify the checksums of all leafs (reads the whole file). The header is always verified.
+ * @return An octree that answers all queries directly on the mapped file
+ * @throws ::std::runtime_error If the file can't be mapped, isn't an uncompressed binary octree file or its checksums don't match
+ * @note The file must not be modified while the octree exists.
+ */
+OCTREEBUILDER_API ::std::unique_ptr<Octree> mapOctreeFile(const ::std::string& path, bool verifyChecksums = false);
+
+/**
+ * @brief Reads a compressed or uncompressed binary octree file into memory
+ * @param path The path of the file
+ * @param verifyChecksums Whether to verify the checksums of all leafs. The header is always verified.
+ * @return An octree containing all leafs of the file
+ * @throws ::std::runtime_error If the file can't be read, isn't a binary octree file, is corrupted or its checksums don't match
+ */
+OCTREEBUILDER_API ::std::unique_ptr<Octree> readOctreeFile(const ::std::string& path, bool verifyChecksums = false);
+}
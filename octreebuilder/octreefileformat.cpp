@@ -0,0 +1,100 @@
+#include "octreefileformat.h"
+
+#include "checksum.h"
+#include "memorymappedfile.h"
+#include "mortoncode_utils.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace octreebuilder {
+namespace octreefile {
+
+bool Header::hasChecksums() const {
+    return (flags & FLAG_CHECKSUMS) != 0;
+}
+
+bool Header::isCompressed() const {
+    return (flags & FLAG_COMPRESSED) != 0;
+}
+
+uint64_t Header::numBlocks() const {
+    return blockSize > 0 ? (numLeafs + blockSize - 1) / blockSize : 0;
+}
+
+Layout::Layout(const Header& header)
+    : codesOffset(sizeof(Header)),
+      levelsOffset(codesOffset + header.numLeafs * sizeof(uint64_t)),
+      checksumsOffset((levelsOffset + header.numLeafs + sizeof(uint32_t) - 1) / sizeof(uint32_t) * sizeof(uint32_t)),
+      fileSize(header.hasChecksums() ? checksumsOffset + header.numBlocks() * sizeof(uint32_t) : levelsOffset + header.numLeafs) {
+}
+
+CompressedLayout::CompressedLayout(const Header& header)
+    : blockOffsetsOffset(sizeof(Header)),
+      checksumsOffset(blockOffsetsOffset + (header.numBlocks() + 1) * sizeof(uint64_t)),
+      dataOffset(checksumsOffset + (header.hasChecksums() ? header.numBlocks() * sizeof(uint32_t) : 0)) {
+}
+
+Header readHeader(const MemoryMappedFile& file) {
+    Header header;
+
+    if (file.size() < sizeof(header)) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The file is too small.");
+    }
+
+    ::std::memcpy(&header, file.data(), sizeof(header));
+
+    if (::std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The file isn't a binary octree file.");
+    }
+
+    if (header.byteOrderMark != BYTE_ORDER_MARK) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The file was written on a machine with a different byte order.");
+    }
+
+    if (header.version != VERSION) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": Unsupported version " + ::std::to_string(header.version) + ".");
+    }
+
+    Header headerWithoutChecksum = header;
+    headerWithoutChecksum.headerChecksum = 0;
+    if (crc32(&headerWithoutChecksum, sizeof(headerWithoutChecksum)) != header.headerChecksum) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The checksum of the header doesn't match.");
+    }
+
+    if ((header.flags & ~(FLAG_CHECKSUMS | FLAG_COMPRESSED)) != 0) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": Unknown flags.");
+    }
+
+    if (header.depth >= MAX_NUM_LEVELS || !fitsInMortonCode(getMaxXYZForOctreeDepth(header.depth))) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": Invalid depth.");
+    }
+
+    const Vector3i maxXYZ = getMaxXYZForOctreeDepth(header.depth);
+    for (uint i = 0; i < 3; i++) {
+        if (header.maxXYZ[i] != static_cast<int64_t>(maxXYZ[i])) {
+            throw ::std::runtime_error("Invalid octree file " + file.path() + ": The bounding doesn't match the depth.");
+        }
+    }
+
+    uint64_t numLeafs = 0;
+    for (size_t level = 0; level < MAX_NUM_LEVELS; level++) {
+        if (level > header.depth && header.numLeafsPerLevel[level] > 0) {
+            throw ::std::runtime_error("Invalid octree file " + file.path() + ": Leafs above the root level.");
+        }
+        numLeafs += header.numLeafsPerLevel[level];
+    }
+
+    if (numLeafs != header.numLeafs) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": The number of leafs doesn't match the number of leafs per level.");
+    }
+
+    if (header.blockSize == 0) {
+        throw ::std::runtime_error("Invalid octree file " + file.path() + ": Invalid block size.");
+    }
+
+    return header;
+}
+}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace octreebuilder {
+
+class MemoryMappedFile;
+
+/**
+ * @brief The layout of binary octree files (see octreefile.h)
+ *
+ * All values are stored in the byte order of the writing machine (checked with BYTE_ORDER_MARK).
+ * The leafs are processed in blocks of Header::blockSize leafs.
+ *
+ * An uncompressed file consists of:
+ *  - the header
+ *  - the morton codes of all leafs (uint64_t, in the order of the linear octree)
+ *  - the levels of all leafs (uint8_t, same order)
+ *  - optional: a CRC-32 (uint32_t) of each block (covering the morton codes and then the levels of the block)
+ *
+ * A compressed file (FLAG_COMPRESSED) consists of:
+ *  - the header
+ *  - the offsets (uint64_t, from the start of the file) of all encoded blocks followed by the end of the last block
+ *  - optional: a CRC-32 (uint32_t) of each encoded block
+ *  - the encoded blocks (see octreefile.cpp), each one can be decoded independently
+ */
+namespace octreefile {
+
+constexpr char MAGIC[8] = {'O', 'C', 'T', 'R', 'E', 'E', 'B', '\0'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+constexpr uint32_t FLAG_CHECKSUMS = 1;
+constexpr uint32_t FLAG_COMPRESSED = 2;
+
+constexpr size_t MAX_NUM_LEVELS = 32;
+constexpr uint64_t BLOCK_SIZE = uint64_t(1) << 20;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t flags;
+    uint32_t depth;
+    int64_t maxXYZ[3];
+
+    /**
+     * @brief The CRC-32 of the header (with this field set to zero)
+     */
+    uint32_t headerChecksum;
+    uint32_t reserved;
+
+    uint64_t numLeafs;
+
+    /**
+     * @brief The number of leafs per block (the unit of checksums and compression)
+     */
+    uint64_t blockSize;
+    uint64_t numLeafsPerLevel[MAX_NUM_LEVELS];
+
+    bool hasChecksums() const;
+    bool isCompressed() const;
+    uint64_t numBlocks() const;
+};
+
+static_assert(sizeof(Header) % 8 == 0, "The data following the header must be aligned.");
+
+/**
+ * @brief The offsets (in bytes from the start of the file) of the parts of an uncompressed file
+ */
+struct Layout {
+    explicit Layout(const Header& header);
+
+    uint64_t codesOffset;
+    uint64_t levelsOffset;
+    uint64_t checksumsOffset;
+    uint64_t fileSize;
+};
+
+/**
+ * @brief The offsets (in bytes from the start of the file) of the parts of a compressed file
+ */
+struct CompressedLayout {
+    explicit CompressedLayout(const Header& header);
+
+    uint64_t blockOffsetsOffset;
+    uint64_t checksumsOffset;
+    uint64_t dataOffset;
+};
+
+/**
+ * @brief Reads the header of a binary octree file and verifies it (but not the size of the file)
+ * @throws ::std::runtime_error If the file isn't a binary octree file or the header is invalid
+ */
+OCTREEBUILDER_API Header readHeader(const MemoryMappedFile& file);
+}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+#include "octantid.h"
+#include "octreefileformat.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace octreebuilder {
+
+/**
+ * @brief Writes an uncompressed binary octree file from a stream of leafs (see octreefile.h)
+ *
+ * The number of leafs doesn't need to be known in advance: the morton codes are written to their final place,
+ * the levels are written to a temporary file which is appended by finish.
+ * At most one block of leafs is buffered (or fewer, see the bufferSize of the constructor).
+ */
+class OCTREEBUILDER_API OctreeFileWriter {
+public:
+    /**
+     * @param path The path of the file (is overwritten)
+     * @param depth The depth of the octree
+     * @param withChecksums Whether to store checksums of the leafs
+     * @param tempDirectory The directory of the temporary file of the levels (named like the file with the suffix ".levels"). If empty the temporary
+     * file is created next to the file.
+     * @param bufferSize The maximum number of buffered leafs (0 buffers a whole block). If a block doesn't fit into the buffer, its levels are read
+     * back from the temporary file to compute its checksum.
+     * @throws ::std::runtime_error If a file can't be opened or the depth is too large
+     */
+    OctreeFileWriter(const ::std::string& path, uint depth, bool withChecksums = true, const ::std::string& tempDirectory = "",
+                     size_t bufferSize = 0);
+
+    OctreeFileWriter(const OctreeFileWriter&) = delete;
+    OctreeFileWriter& operator=(const OctreeFileWriter&) = delete;
+
+    /**
+     * @brief Removes the temporary file
+     */
+    ~OctreeFileWriter();
+
+    /**
+     * @brief Appends the leaf (the leafs must be appended in ascending order)
+     */
+    void append(const OctantID& leaf);
+
+    /**
+     * @brief The number of leafs appended so far
+     */
+    size_t numLeafs() const;
+
+    /**
+     * @brief Writes the remaining leafs, the checksums and the header
+     * @throws ::std::runtime_error If the file can't be written
+     */
+    void finish();
+
+private:
+    /**
+     * @brief Writes the buffered leafs
+     * @param endOfBlock Whether the leafs end the current block (its checksum is computed then)
+     */
+    void writeBuffer(bool endOfBlock);
+
+    ::std::string m_path;
+    ::std::string m_levelsPath;
+    ::std::ofstream m_file;
+    ::std::fstream m_levelsFile;
+
+    octreefile::Header m_header;
+    size_t m_bufferSize;
+    ::std::vector<uint64_t> m_codes;
+    ::std::vector<uint8_t> m_levels;
+    ::std::vector<uint32_t> m_checksums;
+
+    /**
+     * @brief The number of leafs of the current block that are written already
+     */
+    uint64_t m_numWrittenLeafsOfBlock;
+
+    /**
+     * @brief The checksum of the codes of the current block that are written already
+     */
+    uint32_t m_blockChecksum;
+};
+}
@@ -34,6 +34,42 @@ Vector3i OctreeNode::getNormalOfFace(const OctreeNode::Face& f) {
     return Vector3i(0, 0, 0);
 }
 
+Vector3i OctreeNode::getDirectionOfEdge(const OctreeNode::Edge& e) {
+    switch (e) {
+        case LEFT_FRONT:
+            return Vector3i(-1, -1, 0);
+        case LEFT_BACK:
+            return Vector3i(-1, 1, 0);
+        case LEFT_BOTTOM:
+            return Vector3i(-1, 0, -1);
+        case LEFT_TOP:
+            return Vector3i(-1, 0, 1);
+        case RIGHT_FRONT:
+            return Vector3i(1, -1, 0);
+        case RIGHT_BACK:
+            return Vector3i(1, 1, 0);
+        case RIGHT_BOTTOM:
+            return Vector3i(1, 0, -1);
+        case RIGHT_TOP:
+            return Vector3i(1, 0, 1);
+        case FRONT_BOTTOM:
+            return Vector3i(0, -1, -1);
+        case FRONT_TOP:
+            return Vector3i(0, -1, 1);
+        case BACK_BOTTOM:
+            return Vector3i(0, 1, -1);
+        case BACK_TOP:
+            return Vector3i(0, 1, 1);
+    }
+    return Vector3i(0, 0, 0);
+}
+
+Vector3i OctreeNode::getDirectionOfVertex(const OctreeNode::Vertex& v) {
+    // The vertex index encodes the direction the same way the morton code encodes the children of an octant: xyz
+    const int index = static_cast<int>(v);
+    return Vector3i(index & 4 ? 1 : -1, index & 2 ? 1 : -1, index & 1 ? 1 : -1);
+}
+
 bool OctreeNode::isValid() const {
     return m_morton_llf != static_cast<morton_t>(-1) && m_level != static_cast<uint>(-1);
 }
@@ -94,4 +130,78 @@ bool OctreeNode::operator!=(const OctreeNode& o) const {
 
     return s;
 }
+
+::std::ostream& operator<<(::std::ostream& s, const OctreeNode::Edge& e) {
+    switch (e) {
+        case OctreeNode::Edge::LEFT_FRONT:
+            s << "LEFT_FRONT";
+            break;
+        case OctreeNode::Edge::LEFT_BACK:
+            s << "LEFT_BACK";
+            break;
+        case OctreeNode::Edge::LEFT_BOTTOM:
+            s << "LEFT_BOTTOM";
+            break;
+        case OctreeNode::Edge::LEFT_TOP:
+            s << "LEFT_TOP";
+            break;
+        case OctreeNode::Edge::RIGHT_FRONT:
+            s << "RIGHT_FRONT";
+            break;
+        case OctreeNode::Edge::RIGHT_BACK:
+            s << "RIGHT_BACK";
+            break;
+        case OctreeNode::Edge::RIGHT_BOTTOM:
+            s << "RIGHT_BOTTOM";
+            break;
+        case OctreeNode::Edge::RIGHT_TOP:
+            s << "RIGHT_TOP";
+            break;
+        case OctreeNode::Edge::FRONT_BOTTOM:
+            s << "FRONT_BOTTOM";
+            break;
+        case OctreeNode::Edge::FRONT_TOP:
+            s << "FRONT_TOP";
+            break;
+        case OctreeNode::Edge::BACK_BOTTOM:
+            s << "BACK_BOTTOM";
+            break;
+        case OctreeNode::Edge::BACK_TOP:
+            s << "BACK_TOP";
+            break;
+    }
+
+    return s;
+}
+
+::std::ostream& operator<<(::std::ostream& s, const OctreeNode::Vertex& v) {
+    switch (v) {
+        case OctreeNode::Vertex::LEFT_FRONT_BOTTOM:
+            s << "LEFT_FRONT_BOTTOM";
+            break;
+        case OctreeNode::Vertex::LEFT_FRONT_TOP:
+            s << "LEFT_FRONT_TOP";
+            break;
+        case OctreeNode::Vertex::LEFT_BACK_BOTTOM:
+            s << "LEFT_BACK_BOTTOM";
+            break;
+        case OctreeNode::Vertex::LEFT_BACK_TOP:
+            s << "LEFT_BACK_TOP";
+            break;
+        case OctreeNode::Vertex::RIGHT_FRONT_BOTTOM:
+            s << "RIGHT_FRONT_BOTTOM";
+            break;
+        case OctreeNode::Vertex::RIGHT_FRONT_TOP:
+            s << "RIGHT_FRONT_TOP";
+            break;
+        case OctreeNode::Vertex::RIGHT_BACK_BOTTOM:
+            s << "RIGHT_BACK_BOTTOM";
+            break;
+        case OctreeNode::Vertex::RIGHT_BACK_TOP:
+            s << "RIGHT_BACK_TOP";
+            break;
+    }
+
+    return s;
+}
 }
@@ -21,11 +21,53 @@ public:
      */
     enum Face { LEFT = 0, RIGHT = 1, FRONT = 2, BACK = 3, BOTTOM = 4, TOP = 5 };
 
+    /**
+     * @brief The edges of an octree node (named by the two faces that share the edge)
+     */
+    enum Edge {
+        LEFT_FRONT = 0,
+        LEFT_BACK = 1,
+        LEFT_BOTTOM = 2,
+        LEFT_TOP = 3,
+        RIGHT_FRONT = 4,
+        RIGHT_BACK = 5,
+        RIGHT_BOTTOM = 6,
+        RIGHT_TOP = 7,
+        FRONT_BOTTOM = 8,
+        FRONT_TOP = 9,
+        BACK_BOTTOM = 10,
+        BACK_TOP = 11
+    };
+
+    /**
+     * @brief The vertices of an octree node (named by the three faces that share the vertex)
+     */
+    enum Vertex {
+        LEFT_FRONT_BOTTOM = 0,
+        LEFT_FRONT_TOP = 1,
+        LEFT_BACK_BOTTOM = 2,
+        LEFT_BACK_TOP = 3,
+        RIGHT_FRONT_BOTTOM = 4,
+        RIGHT_FRONT_TOP = 5,
+        RIGHT_BACK_BOTTOM = 6,
+        RIGHT_BACK_TOP = 7
+    };
+
     /**
      * @brief Returns the unit normal of a face
      */
     static Vector3i getNormalOfFace(const Face& f);
 
+    /**
+     * @brief Returns the direction from the center of a node to the center of its edge e (each component is -1, 0 or 1)
+     */
+    static Vector3i getDirectionOfEdge(const Edge& e);
+
+    /**
+     * @brief Returns the direction from the center of a node to its vertex v (each component is -1 or 1)
+     */
+    static Vector3i getDirectionOfVertex(const Vertex& v);
+
     /**
      * @brief Returns true if this is a valid octree node
      * @note A invalid octree node is not equal to any other node (even if its also an invalid node)
@@ -65,4 +107,6 @@ private:
 };
 
 OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const OctreeNode::Face& f);
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const OctreeNode::Edge& e);
+OCTREEBUILDER_API ::std::ostream& operator<<(::std::ostream& s, const OctreeNode::Vertex& v);
 }
@@ -0,0 +1,847 @@
+#include "outofcoreoctreebuilder.h"
+
+#include "mortoncode_utils.h"
+#include "octantid.h"
+#include "octree_utils.h"
+#include "octreefile.h"
+#include "octreefilewriter.h"
+#include "octreenode.h"
+#include "parallel_stable_sort.h"
+
+#include <omp.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <direct.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+#include "memoryusage.h"
+#include "perfcounter.h"
+#include "tracer.h"
+
+namespace octreebuilder {
+
+/**
+ * @brief The minimum number of records buffered when reading or writing a temporary file
+ */
+static const size_t MIN_FILE_BUFFER_SIZE = 256;
+
+/**
+ * @brief The number of octants adjacent to an octant (sharing at least a vertex) including the octant itself
+ */
+static const size_t NEIGHBOURHOOD_SIZE = 27;
+
+/**
+ * @brief The maximum number of runs merged at once (each run is an open file)
+ */
+static const size_t MAX_MERGE_FAN_IN = 256;
+
+/**
+ * @brief The number of leafs of a file that are encoded by one thread at once
+ */
+static const size_t LEAFS_PER_CHUNK = size_t(1) << 16;
+
+/**
+ * @brief The part of the memory budget for the buffer of the output (the octree file or the chunks passed to the sink)
+ */
+static size_t outputBudget(const size_t memoryBudget) {
+    return memoryBudget / 4;
+}
+
+/**
+ * @brief The number of morton codes that fit into the rest of the memory budget (used for the leafs and octants)
+ */
+static size_t numRecordsOfBudget(const size_t memoryBudget) {
+    return (memoryBudget - outputBudget(memoryBudget)) / sizeof(morton_t);
+}
+
+/**
+ * @brief Writes records of type T to a file (buffered)
+ *
+ * Errors are reported by close, hence pushing a record never throws. The file stream itself is unbuffered, so the buffer is the only memory used.
+ */
+template <typename T>
+class RecordWriter {
+public:
+    RecordWriter(const ::std::string& path, const size_t bufferSize) : m_path(path) {
+        m_file.rdbuf()->pubsetbuf(nullptr, 0);
+        m_file.open(path, ::std::ios::binary | ::std::ios::trunc);
+        if (!m_file) {
+            throw ::std::runtime_error("Can't open the temporary file " + path + " for writing.");
+        }
+        m_buffer.reserve(bufferSize);
+    }
+
+    void push(const T& record) {
+        m_buffer.push_back(record);
+        if (m_buffer.size() == m_buffer.capacity()) {
+            flush();
+        }
+    }
+
+    void close() {
+        flush();
+        m_file.close();
+        if (!m_file) {
+            throw ::std::runtime_error("Failed to write the temporary file " + m_path + ".");
+        }
+    }
+
+private:
+    void flush() {
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<::std::streamsize>(m_buffer.size() * sizeof(T)));
+        m_buffer.clear();
+    }
+
+    ::std::string m_path;
+    ::std::ofstream m_file;
+    ::std::vector<T> m_buffer;
+};
+
+/**
+ * @brief Reads the records of type T of a file (buffered)
+ *
+ * The file stream itself is unbuffered, so the buffer is the only memory used.
+ */
+template <typename T>
+class RecordReader {
+public:
+    RecordReader(const ::std::string& path, const size_t bufferSize) : m_path(path), m_buffer(bufferSize), m_pos(0), m_size(0) {
+        m_file.rdbuf()->pubsetbuf(nullptr, 0);
+        m_file.open(path, ::std::ios::binary);
+        if (!m_file) {
+            throw ::std::runtime_error("Can't open the temporary file " + path + " for reading.");
+        }
+    }
+
+    /**
+     * @return false If all records were read
+     */
+    bool next(T& record) {
+        if (m_pos == m_size && !refill()) {
+            return false;
+        }
+
+        record = m_buffer[m_pos++];
+        return true;
+    }
+
+private:
+    bool refill() {
+        m_file.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<::std::streamsize>(m_buffer.size() * sizeof(T)));
+
+        const size_t numBytes = static_cast<size_t>(m_file.gcount());
+        if (numBytes % sizeof(T) != 0 || m_file.bad()) {
+            throw ::std::runtime_error("Failed to read the temporary file " + m_path + ".");
+        }
+
+        m_pos = 0;
+        m_size = numBytes / sizeof(T);
+        return m_size > 0;
+    }
+
+    ::std::string m_path;
+    ::std::ifstream m_file;
+    ::std::vector<T> m_buffer;
+    size_t m_pos;
+    size_t m_size;
+};
+
+#ifdef _WIN32
+
+static ::std::string createTempDirectory(const ::std::string& parent) {
+    // _mkdir fails if the directory exists... try names until one is free
+    const ::std::string prefix = parent + "/octreebuilder-" + ::std::to_string(::GetCurrentProcessId()) + "-";
+    for (unsigned long attempt = 0; attempt < 1000; attempt++) {
+        const ::std::string path = prefix + ::std::to_string(::GetTickCount64()) + "-" + ::std::to_string(attempt);
+        if (::_mkdir(path.c_str()) == 0) {
+            return path;
+        }
+        if (errno != EEXIST) {
+            break;
+        }
+    }
+
+    throw ::std::runtime_error("Can't create a temporary directory in " + parent + ".");
+}
+
+static void removeDirectory(const ::std::string& path) {
+    ::_rmdir(path.c_str());
+}
+
+/**
+ * @brief The maximum number of files the process can open at the same time (0 if unknown)
+ */
+static size_t maxOpenFiles() {
+    // the file streams are opened with the C runtime, which has its own limit
+    const int maxFiles = ::_getmaxstdio();
+    return maxFiles > 0 ? static_cast<size_t>(maxFiles) : 0;
+}
+
+#else
+
+static ::std::string createTempDirectory(const ::std::string& parent) {
+    ::std::string pathTemplate = parent + "/octreebuilder-XXXXXX";
+    ::std::vector<char> path(pathTemplate.begin(), pathTemplate.end());
+    path.push_back('\0');
+
+    if (::mkdtemp(path.data()) == nullptr) {
+        throw ::std::runtime_error("Can't create a temporary directory in " + parent + ".");
+    }
+
+    return ::std::string(path.data());
+}
+
+static void removeDirectory(const ::std::string& path) {
+    ::rmdir(path.c_str());
+}
+
+/**
+ * @brief The maximum number of files the process can open at the same time (0 if unknown)
+ */
+static size_t maxOpenFiles() {
+    const long maxFiles = ::sysconf(_SC_OPEN_MAX);
+    return maxFiles > 0 ? static_cast<size_t>(maxFiles) : 0;
+}
+
+#endif
+
+OutOfCoreOctreeBuilder::OutOfCoreOctreeBuilder(const Vector3i& maxXYZ, const ::std::string& outputPath, size_t memoryBudget,
+                                               const ::std::string& tempDirectory, uint maxLevel)
+    : OctreeBuilder(maxXYZ, maxLevel), m_outputPath(outputPath), m_memoryBudget(memoryBudget), m_numRuns(0) {
+    if (!fitsInMortonCode(maxXYZ)) {
+        throw ::std::runtime_error("Space to large for octree creation.");
+    }
+
+    m_tempDirectory = createTempDirectory(tempDirectory);
+
+    // spilling sorts the buffer with a temporary buffer of the same size
+    m_buffer.reserve(::std::max(numRecordsOfBudget(m_memoryBudget) / 2, MIN_FILE_BUFFER_SIZE));
+}
+
+OutOfCoreOctreeBuilder::~OutOfCoreOctreeBuilder() {
+    for (size_t run = 0; run < m_numRuns; run++) {
+        ::std::remove(runPath(run).c_str());
+    }
+
+    removeDirectory(m_tempDirectory);
+}
+
+::std::string OutOfCoreOctreeBuilder::runPath(size_t run) const {
+    return temporaryPath("run", run);
+}
+
+::std::string OutOfCoreOctreeBuilder::temporaryPath(const ::std::string& name, size_t index) const {
+    return m_tempDirectory + "/" + name + "-" + ::std::to_string(index);
+}
+
+morton_t OutOfCoreOctreeBuilder::addLevelZeroLeaf(const Vector3i& c) {
+    morton_t mortonCode = getMortonCodeForCoordinate(c);
+
+    m_buffer.push_back(mortonCode);
+
+    if (m_buffer.size() == m_buffer.capacity()) {
+        spillBuffer();
+    }
+
+    return mortonCode;
+}
+
+morton_t OutOfCoreOctreeBuilder::addLeaf(const Vector3i& c, uint level) {
+    if (level != 0) {
+        throw ::std::runtime_error("OutOfCoreOctreeBuilder::addLeaf: Only leafs of level zero are supported.");
+    }
+
+    return OctreeBuilder::addLeaf(c, level);
+}
+
+bool OutOfCoreOctreeBuilder::addEncodedLevelZeroLeafs(size_t numLeafs, const LevelZeroLeafEncoder& encode) {
+    // the leafs of the input get their own runs... they are discarded if the input is invalid
+    if (!m_buffer.empty()) {
+        spillBuffer();
+    }
+    const size_t firstRun = m_numRuns;
+
+    const size_t numLeafsPerPiece = m_buffer.capacity();
+    ::std::atomic<bool> valid(true);
+
+    for (size_t first = 0; first < numLeafs && valid; first += numLeafsPerPiece) {
+        const size_t numLeafsOfPiece = ::std::min(numLeafsPerPiece, numLeafs - first);
+        const size_t numChunks = (numLeafsOfPiece + LEAFS_PER_CHUNK - 1) / LEAFS_PER_CHUNK;
+        m_buffer.resize(numLeafsOfPiece);
+
+#pragma omp parallel for schedule(static)
+        for (size_t chunk = 0; chunk < numChunks; chunk++) {
+            const size_t begin = chunk * LEAFS_PER_CHUNK;
+            const size_t numLeafsOfChunk = ::std::min(LEAFS_PER_CHUNK, numLeafsOfPiece - begin);
+
+            if (!encode(first + begin, numLeafsOfChunk, m_buffer.data() + begin)) {
+                valid = false;
+            }
+        }
+
+        if (valid && m_buffer.size() == m_buffer.capacity()) {
+            spillBuffer();
+        }
+    }
+
+    if (!valid) {
+        m_buffer.clear();
+        for (size_t run = firstRun; run < m_numRuns; run++) {
+            ::std::remove(runPath(run).c_str());
+        }
+        m_numRuns = firstRun;
+
+        return false;
+    }
+
+    return true;
+}
+
+void OutOfCoreOctreeBuilder::addGeneratedLevelZeroLeafs(size_t numItems, size_t itemsPerChunk, const LevelZeroLeafGenerator& generate) {
+    const size_t numChunks = (numItems + itemsPerChunk - 1) / itemsPerChunk;
+    const size_t chunksPerGroup = static_cast<size_t>(omp_get_max_threads());
+
+    ::std::vector<::std::vector<morton_t>> codesPerChunk(chunksPerGroup);
+
+    for (size_t firstChunk = 0; firstChunk < numChunks; firstChunk += chunksPerGroup) {
+        const size_t numChunksOfGroup = ::std::min(chunksPerGroup, numChunks - firstChunk);
+
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < numChunksOfGroup; chunk++) {
+            const size_t first = (firstChunk + chunk) * itemsPerChunk;
+            ::std::vector<morton_t>& codes = codesPerChunk[chunk];
+
+            codes.clear();
+            generate(first, ::std::min(itemsPerChunk, numItems - first), codes);
+            ::std::sort(codes.begin(), codes.end());
+            codes.erase(::std::unique(codes.begin(), codes.end()), codes.end());
+        }
+
+        for (size_t chunk = 0; chunk < numChunksOfGroup; chunk++) {
+            for (morton_t mcode : codesPerChunk[chunk]) {
+                m_buffer.push_back(mcode);
+
+                if (m_buffer.size() == m_buffer.capacity()) {
+                    spillBuffer();
+                }
+            }
+        }
+    }
+}
+
+size_t OutOfCoreOctreeBuilder::addLevelZeroLeafsFromOccupancy(const uint64_t* occupancy, const Vector3i& size, const Vector3i& llf) {
+    checkOccupancyBounds(size, llf);
+
+    const size_t wordsPerRow = occupancyWordsPerRow(size.x());
+    size_t numVoxels = 0;
+
+    for (coord_t z = 0; z < size.z(); z++) {
+        for (coord_t y = 0; y < size.y(); y++) {
+            const uint64_t* row = occupancy + (static_cast<size_t>(z) * static_cast<size_t>(size.y()) + static_cast<size_t>(y)) * wordsPerRow;
+
+            for (size_t word = 0; word < wordsPerRow; word++) {
+                const uint64_t bits = occupancyWord(row, word, size.x());
+                if (bits == 0) {
+                    continue;
+                }
+
+                const size_t numVoxelsOfWord = countOccupiedVoxels(bits);
+                if (m_buffer.size() + numVoxelsOfWord > m_buffer.capacity()) {
+                    spillBuffer();
+                }
+
+                const size_t end = m_buffer.size();
+                m_buffer.resize(end + numVoxelsOfWord);
+                encodeOccupiedVoxels(bits, llf + Vector3i(static_cast<coord_t>(word * 64), y, z), m_buffer.data() + end);
+                numVoxels += numVoxelsOfWord;
+            }
+        }
+    }
+
+    return numVoxels;
+}
+
+/**
+ * @brief Sorts the codes, removes the duplicates and writes them to the file
+ */
+static void writeRun(::std::vector<morton_t>& codes, const ::std::string& path) {
+    pss::parallel_stable_sort(codes.begin(), codes.end());
+    codes.erase(::std::unique(codes.begin(), codes.end()), codes.end());
+
+    ::std::ofstream file(path, ::std::ios::binary | ::std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(codes.data()), static_cast<::std::streamsize>(codes.size() * sizeof(morton_t)));
+    file.close();
+
+    if (!file) {
+        ::std::remove(path.c_str());
+        throw ::std::runtime_error("Failed to write the temporary file " + path + ".");
+    }
+}
+
+void OutOfCoreOctreeBuilder::spillBuffer() {
+    writeRun(m_buffer, runPath(m_numRuns));
+
+    m_numRuns++;
+    m_buffer.clear();
+}
+
+/**
+ * @brief Merges the sorted files into one sorted file without duplicates
+ * @return The number of records in the file
+ */
+static size_t mergeSortedFiles(const ::std::vector<::std::string>& inputs, const ::std::string& path, const size_t bufferSize) {
+    ::std::vector<RecordReader<morton_t>> runs;
+    runs.reserve(inputs.size());
+    for (const ::std::string& input : inputs) {
+        runs.emplace_back(input, bufferSize);
+    }
+
+    typedef ::std::pair<morton_t, size_t> Head;
+    ::std::priority_queue<Head, ::std::vector<Head>, ::std::greater<Head>> heads;
+
+    for (size_t run = 0; run < runs.size(); run++) {
+        morton_t mcode;
+        if (runs[run].next(mcode)) {
+            heads.push(Head(mcode, run));
+        }
+    }
+
+    RecordWriter<morton_t> merged(path, bufferSize);
+    size_t numLeafs = 0;
+    morton_t last = 0;
+
+    while (!heads.empty()) {
+        const Head head = heads.top();
+        heads.pop();
+
+        // the runs don't contain duplicates... but the same leaf might be in several runs
+        if (numLeafs == 0 || head.first != last) {
+            merged.push(head.first);
+            last = head.first;
+            numLeafs++;
+        }
+
+        morton_t mcode;
+        if (runs[head.second].next(mcode)) {
+            heads.push(Head(mcode, head.second));
+        }
+    }
+
+    merged.close();
+    return numLeafs;
+}
+
+static void removeFiles(const ::std::vector<::std::string>& paths) {
+    for (const ::std::string& path : paths) {
+        ::std::remove(path.c_str());
+    }
+}
+
+size_t OutOfCoreOctreeBuilder::mergeFanIn() const {
+    // the runs and the output of a merge each need an open file and a buffer of at least MIN_FILE_BUFFER_SIZE records
+    const size_t numFilesOfBudget = numRecordsOfBudget(m_memoryBudget) / MIN_FILE_BUFFER_SIZE;
+    const size_t maxFiles = maxOpenFiles();
+    const size_t numFilesOfLimit = maxFiles > 0 ? maxFiles / 2 : MAX_MERGE_FAN_IN + 1;
+
+    const size_t numFiles = ::std::min(::std::min(numFilesOfBudget, numFilesOfLimit), MAX_MERGE_FAN_IN + 1);
+    return numFiles > 3 ? numFiles - 1 : 2;
+}
+
+size_t OutOfCoreOctreeBuilder::mergeRuns(::std::vector<::std::string> runs, const ::std::string& path, MemoryTracker& memory,
+                                         size_t liveBytes) const {
+    const size_t fanIn = mergeFanIn();
+    const size_t bufferSize = ::std::max(numRecordsOfBudget(m_memoryBudget) / (fanIn + 1), MIN_FILE_BUFFER_SIZE);
+
+    memory.sample(liveBytes + (::std::min(runs.size(), fanIn) + 1) * bufferSize * sizeof(morton_t));
+
+    // the runs written by the previous and the current pass (the given runs are kept)
+    ::std::vector<::std::string> previousPassRuns;
+    ::std::vector<::std::string> passRuns;
+
+    try {
+        // too many runs to merge them at once... merge groups of runs until a single pass merges all of them
+        for (size_t pass = 0; runs.size() > fanIn; pass++) {
+            passRuns.clear();
+
+            for (size_t first = 0; first < runs.size(); first += fanIn) {
+                const ::std::vector<::std::string> group(runs.begin() + static_cast<::std::ptrdiff_t>(first),
+                                                         runs.begin() + static_cast<::std::ptrdiff_t>(::std::min(first + fanIn, runs.size())));
+
+                passRuns.push_back(temporaryPath("merge-" + ::std::to_string(pass), passRuns.size()));
+                mergeSortedFiles(group, passRuns.back(), bufferSize);
+            }
+
+            removeFiles(previousPassRuns);
+            previousPassRuns = passRuns;
+            runs = passRuns;
+        }
+
+        const size_t numLeafs = mergeSortedFiles(runs, path, bufferSize);
+        removeFiles(previousPassRuns);
+
+        return numLeafs;
+    } catch (...) {
+        removeFiles(previousPassRuns);
+        removeFiles(passRuns);
+        throw;
+    }
+}
+
+/**
+ * @brief Writes the sorted codes of the parents and their neighbours (of the level and inside the octree) to the file
+ * @param neighbourhoods A buffer for the neighbourhoods (its capacity is kept)
+ */
+static void writeNeighbourhoods(const ::std::vector<morton_t>& parents, const uint level, const coord_t octreeSize,
+                                ::std::vector<morton_t>& neighbourhoods, const ::std::string& path) {
+    const coord_t size = getOctantSizeForLevel(level);
+    neighbourhoods.resize(parents.size() * NEIGHBOURHOOD_SIZE);
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < parents.size(); i++) {
+        const Vector3i llf = getCoordinateForMortonCode(parents[i]);
+        morton_t* neighbourhood = neighbourhoods.data() + i * NEIGHBOURHOOD_SIZE;
+
+        for (coord_t dz = -1; dz <= 1; dz++) {
+            for (coord_t dy = -1; dy <= 1; dy++) {
+                for (coord_t dx = -1; dx <= 1; dx++) {
+                    const Vector3i c = llf + Vector3i(dx, dy, dz) * size;
+                    const bool isInside = c.x() >= 0 && c.y() >= 0 && c.z() >= 0 && c.x() < octreeSize && c.y() < octreeSize && c.z() < octreeSize;
+
+                    // the parent replaces the neighbours outside of the octree (removed as duplicate)
+                    *neighbourhood++ = isInside ? getMortonCodeForCoordinate(c) : parents[i];
+                }
+            }
+        }
+    }
+
+    writeRun(neighbourhoods, path);
+}
+
+size_t OutOfCoreOctreeBuilder::createLeafsOfLevel(const uint level, const bool withNeighbourhoods, const ::std::string& octantsPath,
+                                                  const ::std::string& parentsPath, const ::std::string& nextParentsPath,
+                                                  const ::std::string& leafsPath, ::std::vector<::std::string>& neighbourhoodRuns,
+                                                  MemoryTracker& memory, size_t liveBytes) const {
+    const size_t numRecords = numRecordsOfBudget(m_memoryBudget);
+    const coord_t octreeSize = getOctantSizeForLevel(getOctreeDepthForBounding(m_maxXYZ));
+
+    // a quarter of the budget for the four files... the parents of a piece, their neighbourhoods and the temporary buffer of the sort get the rest
+    const size_t fileBufferSize = ::std::max(numRecords / 16, MIN_FILE_BUFFER_SIZE);
+    const size_t numPieceRecords = numRecords > 4 * fileBufferSize ? numRecords - 4 * fileBufferSize : 0;
+    const size_t parentsPerPiece = ::std::max(numPieceRecords / (2 * NEIGHBOURHOOD_SIZE + 1), size_t(1));
+
+    RecordReader<morton_t> octants(octantsPath, fileBufferSize);
+    RecordReader<morton_t> parents(parentsPath, fileBufferSize);
+    RecordWriter<morton_t> nextParents(nextParentsPath, fileBufferSize);
+    RecordWriter<morton_t> leafs(leafsPath, fileBufferSize);
+
+    ::std::vector<morton_t> piece;
+    ::std::vector<morton_t> neighbourhoods;
+    if (withNeighbourhoods) {
+        piece.reserve(parentsPerPiece);
+        neighbourhoods.reserve(parentsPerPiece * NEIGHBOURHOOD_SIZE);
+    }
+    memory.sample(liveBytes + 4 * fileBufferSize * sizeof(morton_t) + memoryUsage(piece) + 2 * memoryUsage(neighbourhoods));
+
+    const auto writePiece = [&]() {
+        neighbourhoodRuns.push_back(temporaryPath("neighbourhoods", neighbourhoodRuns.size()));
+        writeNeighbourhoods(piece, level + 1, octreeSize, neighbourhoods, neighbourhoodRuns.back());
+        piece.clear();
+    };
+
+    size_t numLeafs = 0;
+    morton_t parent = 0;
+    bool hasParent = parents.next(parent);
+
+    size_t numNextParents = 0;
+    morton_t nextParent = 0;
+    morton_t octant;
+
+    // the octants are sorted, hence their parents are sorted too
+    while (octants.next(octant)) {
+        const morton_t parentOfOctant = OctantID(octant, level).parent().mcode();
+        if (numNextParents > 0 && parentOfOctant == nextParent) {
+            continue;
+        }
+
+        nextParent = parentOfOctant;
+        numNextParents++;
+        nextParents.push(nextParent);
+
+        // the children of the next parent that aren't parents are leafs
+        for (morton_t child = 0; child < 8; child++) {
+            const morton_t mcode = nextParent | (child << (3 * level));
+            while (hasParent && parent < mcode) {
+                hasParent = parents.next(parent);
+            }
+
+            if (!hasParent || parent != mcode) {
+                leafs.push(mcode);
+                numLeafs++;
+            }
+        }
+
+        if (withNeighbourhoods) {
+            piece.push_back(nextParent);
+            if (piece.size() == piece.capacity()) {
+                writePiece();
+            }
+        }
+    }
+
+    if (!piece.empty()) {
+        writePiece();
+    }
+
+    nextParents.close();
+    leafs.close();
+
+    return numLeafs;
+}
+
+size_t OutOfCoreOctreeBuilder::fillLevel(const uint level, const ::std::string& parentsPath, const ::std::string& leafsPath) const {
+    const size_t fileBufferSize = ::std::max(numRecordsOfBudget(m_memoryBudget) / 2, MIN_FILE_BUFFER_SIZE);
+    const morton_t numOctants = morton_t(1) << (3 * (getOctreeDepthForBounding(m_maxXYZ) - level));
+
+    RecordReader<morton_t> parents(parentsPath, fileBufferSize);
+    RecordWriter<morton_t> leafs(leafsPath, fileBufferSize);
+
+    size_t numLeafs = 0;
+    morton_t parent = 0;
+    bool hasParent = parents.next(parent);
+
+    // the octants of the level are sorted by their index
+    for (morton_t i = 0; i < numOctants; i++) {
+        const morton_t mcode = i << (3 * level);
+        while (hasParent && parent < mcode) {
+            hasParent = parents.next(parent);
+        }
+
+        if (!hasParent || parent != mcode) {
+            leafs.push(mcode);
+            numLeafs++;
+        }
+    }
+
+    leafs.close();
+    return numLeafs;
+}
+
+void OutOfCoreOctreeBuilder::buildLeafs(PerfCounter& perfCounter, MemoryTracker& memory, size_t outputBytes,
+                                        const ::std::function<void(const OctantID&)>& emit) {
+    const uint depth = getOctreeDepthForBounding(m_maxXYZ);
+    const uint maxLeafLevel = ::std::min(maxLevel(), depth);
+
+    perfCounter.start();
+    memory.sample(outputBytes + 2 * memoryUsage(m_buffer));
+    if (!m_buffer.empty()) {
+        spillBuffer();
+    }
+
+    // the buffer is part of the budget... it's released during the build and reserved again for the next leafs
+    const size_t bufferCapacity = m_buffer.capacity();
+    ::std::vector<morton_t>().swap(m_buffer);
+    recordPhase(m_buildStats, BuildStats::Phase::CREATE_INPUT, perfCounter);
+    memory.recordPhase(BuildStats::Phase::CREATE_INPUT, outputBytes);
+
+    // all temporary files of the build (removed at the end)
+    ::std::vector<::std::string> files;
+
+    try {
+        perfCounter.start();
+        ::std::vector<::std::string> inputRuns;
+        for (size_t run = 0; run < m_numRuns; run++) {
+            inputRuns.push_back(runPath(run));
+        }
+
+        files.push_back(temporaryPath("octants", 0));
+        m_buildStats.numLevelZeroLeafs = mergeRuns(inputRuns, files.back(), memory, outputBytes);
+        recordPhase(m_buildStats, BuildStats::Phase::SORT_INPUT, perfCounter);
+        memory.recordPhase(BuildStats::Phase::SORT_INPUT, outputBytes);
+
+        // the leafs of the levels are created one level at a time... each level is a block of the load balance statistics
+        perfCounter.start();
+        {
+            PerfCounter wallTime;
+            wallTime.start();
+            initLoadBalanceStats(m_buildStats.subtreeBuildLoad, maxLeafLevel);
+
+            // there are no parents of level zero
+            files.push_back(temporaryPath("parents", 0));
+            RecordWriter<morton_t>(files.back(), 1).close();
+
+            size_t numOctants = m_buildStats.numLevelZeroLeafs;
+            for (uint level = 0; level < maxLeafLevel && m_buildStats.numLevelZeroLeafs > 0; level++) {
+                PerfCounter levelTime;
+                levelTime.start();
+
+                const bool withNeighbourhoods = level + 1 < maxLeafLevel;
+                ::std::vector<::std::string> neighbourhoodRuns;
+
+                const ::std::string octantsPath = temporaryPath("octants", level);
+                const ::std::string parentsPath = temporaryPath("parents", level);
+                const ::std::string nextParentsPath = temporaryPath("parents", level + 1);
+                const ::std::string leafsPath = temporaryPath("leafs", level);
+                files.push_back(nextParentsPath);
+                files.push_back(leafsPath);
+
+                try {
+                    const size_t numLeafs = createLeafsOfLevel(level, withNeighbourhoods, octantsPath, parentsPath, nextParentsPath, leafsPath,
+                                                               neighbourhoodRuns, memory, outputBytes);
+                    ::std::remove(octantsPath.c_str());
+                    ::std::remove(parentsPath.c_str());
+
+                    // the octants of the next level are the next parents and their neighbours (2:1 balance)
+                    if (withNeighbourhoods) {
+                        files.push_back(temporaryPath("octants", level + 1));
+                        const size_t numNextOctants = mergeRuns(neighbourhoodRuns, files.back(), memory, outputBytes);
+                        removeFiles(neighbourhoodRuns);
+
+                        recordBlock(m_buildStats.subtreeBuildLoad, "SUBTREE_BUILD level", level, numOctants, numLeafs, levelTime.stop());
+                        numOctants = numNextOctants;
+                    } else {
+                        recordBlock(m_buildStats.subtreeBuildLoad, "SUBTREE_BUILD level", level, numOctants, numLeafs, levelTime.stop());
+                    }
+                } catch (...) {
+                    removeFiles(neighbourhoodRuns);
+                    throw;
+                }
+            }
+
+            m_buildStats.subtreeBuildLoad.wallTime = wallTime.stop();
+        }
+
+        // the leafs of the highest level fill the octree
+        if (m_buildStats.numLevelZeroLeafs > 0) {
+            files.push_back(temporaryPath("leafs", maxLeafLevel));
+            fillLevel(maxLeafLevel, temporaryPath("parents", maxLeafLevel), files.back());
+        }
+        ::std::remove(temporaryPath("octants", maxLeafLevel).c_str());
+        ::std::remove(temporaryPath("parents", maxLeafLevel).c_str());
+        recordPhase(m_buildStats, BuildStats::Phase::SUBTREE_BUILD, perfCounter);
+        memory.recordPhase(BuildStats::Phase::SUBTREE_BUILD, outputBytes);
+
+        // merge the leafs of all levels (they don't overlap, hence their morton codes are unique)
+        perfCounter.start();
+        if (m_buildStats.numLevelZeroLeafs == 0) {
+            emit(OctantID(Vector3i(0), depth));
+            m_buildStats.numLeafs = 1;
+        } else {
+            const size_t numLevels = maxLeafLevel + 1;
+            const size_t fileBufferSize = ::std::max(numRecordsOfBudget(m_memoryBudget) / numLevels, MIN_FILE_BUFFER_SIZE);
+            memory.sample(outputBytes + numLevels * fileBufferSize * sizeof(morton_t));
+
+            ::std::vector<RecordReader<morton_t>> leafsPerLevel;
+            leafsPerLevel.reserve(numLevels);
+            for (uint level = 0; level <= maxLeafLevel; level++) {
+                leafsPerLevel.emplace_back(temporaryPath("leafs", level), fileBufferSize);
+            }
+
+            typedef ::std::pair<morton_t, uint> Head;
+            ::std::priority_queue<Head, ::std::vector<Head>, ::std::greater<Head>> heads;
+
+            for (uint level = 0; level <= maxLeafLevel; level++) {
+                morton_t mcode;
+                if (leafsPerLevel[level].next(mcode)) {
+                    heads.push(Head(mcode, level));
+                }
+            }
+
+            size_t numLeafs = 0;
+            while (!heads.empty()) {
+                const Head head = heads.top();
+                heads.pop();
+
+                emit(OctantID(head.first, head.second));
+                numLeafs++;
+
+                morton_t mcode;
+                if (leafsPerLevel[head.second].next(mcode)) {
+                    heads.push(Head(mcode, head.second));
+                }
+            }
+
+            m_buildStats.numLeafs = numLeafs;
+        }
+        // the caller records the MERGE phase
+    } catch (...) {
+        removeFiles(files);
+        m_buffer.reserve(bufferCapacity);
+        throw;
+    }
+
+    removeFiles(files);
+    m_buffer.reserve(bufferCapacity);
+}
+
+::std::unique_ptr<Octree> OutOfCoreOctreeBuilder::finishBuilding() {
+    TraceScope trace("OutOfCoreOctreeBuilder::finishBuilding");
+    m_buildStats = BuildStats();
+
+    ::std::unique_ptr<HardwareCounters> hardwareCounters(m_hardwareCountersEnabled ? new HardwareCounters() : nullptr);
+    PerfCounter perfCounter(hardwareCounters.get());
+    MemoryTracker memory(m_buildStats);
+
+    // the writer buffers the morton code and the level of each leaf
+    const size_t bytesPerLeaf = sizeof(morton_t) + sizeof(uint8_t);
+    const size_t outputBufferSize = ::std::max(outputBudget(m_memoryBudget) / bytesPerLeaf, MIN_FILE_BUFFER_SIZE);
+
+    OctreeFileWriter output(m_outputPath, getOctreeDepthForBounding(m_maxXYZ), true, m_tempDirectory, outputBufferSize);
+    buildLeafs(perfCounter, memory, outputBufferSize * bytesPerLeaf, [&output](const OctantID& leaf) { output.append(leaf); });
+    output.finish();
+    recordPhase(m_buildStats, BuildStats::Phase::MERGE, perfCounter);
+    memory.recordPhase(BuildStats::Phase::MERGE, memoryUsage(m_buffer));
+
+    perfCounter.start();
+    ::std::unique_ptr<Octree> result = mapOctreeFile(m_outputPath);
+    recordPhase(m_buildStats, BuildStats::Phase::INDEX_FILL, perfCounter);
+    // the result is memory mapped
+    memory.recordPhase(BuildStats::Phase::INDEX_FILL, memoryUsage(m_buffer));
+
+    LOG_PROF("Build statistics: " << m_buildStats);
+
+    return result;
+}
+
+void OutOfCoreOctreeBuilder::finishBuilding(const LeafSink& sink) {
+    TraceScope trace("OutOfCoreOctreeBuilder::finishBuilding");
+    m_buildStats = BuildStats();
+
+    ::std::unique_ptr<HardwareCounters> hardwareCounters(m_hardwareCountersEnabled ? new HardwareCounters() : nullptr);
+    PerfCounter perfCounter(hardwareCounters.get());
+    MemoryTracker memory(m_buildStats);
+
+    ::std::vector<OctreeNode> chunk;
+    chunk.reserve(::std::min(LEAFS_PER_CHUNK, ::std::max<size_t>(outputBudget(m_memoryBudget) / sizeof(OctreeNode), 1)));
+
+    buildLeafs(perfCounter, memory, memoryUsage(chunk), [&sink, &chunk](const OctantID& leaf) {
+        chunk.push_back(OctreeNode(leaf.mcode(), leaf.level()));
+        if (chunk.size() == chunk.capacity()) {
+            sink(chunk.data(), chunk.size());
+            chunk.clear();
+        }
+    });
+    if (!chunk.empty()) {
+        sink(chunk.data(), chunk.size());
+    }
+    recordPhase(m_buildStats, BuildStats::Phase::MERGE, perfCounter);
+    memory.recordPhase(BuildStats::Phase::MERGE, memoryUsage(m_buffer));
+
+    LOG_PROF("Build statistics: " << m_buildStats);
+}
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include "octreebuilder.h"
+
+#include <string>
+#include <vector>
+
+namespace octreebuilder {
+
+class OctantID;
+class PerfCounter;
+class MemoryTracker;
+
+/**
+ * @brief Creates octrees that don't fit into memory (external memory version of ParallelOctreeBuilder)
+ *
+ * The added leafs are buffered up to the memory budget, then they are sorted and spilled to a run file in the temporary directory.
+ * finishBuilding merges all runs into one sorted file and creates the balanced octree one level at a time from sorted files:
+ * the parents of the octants of a level are the inner octants of the next level, their children that aren't inner octants are the leafs of the level
+ * and the octants of the next level are the inner octants and their neighbours (2:1 balance).
+ * The neighbourhoods are sorted in pieces and merged like the runs.
+ * The leafs of all levels are merged into a binary octree file (see octreefile.h) which is memory mapped as the result.
+ * Every step streams its files through buffers within the memory budget, hence the memory usage doesn't depend on the number of leafs.
+ */
+class OCTREEBUILDER_API OutOfCoreOctreeBuilder : public OctreeBuilder {
+public:
+    /**
+     * @see OctreeBuilder::OctreeBuilder
+     * @param outputPath The path of the binary octree file created by finishBuilding (is overwritten)
+     * @param memoryBudget The approximate number of bytes used for leafs and octants (a quarter is used for the buffer of the output).
+     * Very small budgets are exceeded by the minimum buffer size of the files (a few KiB).
+     * @param tempDirectory The directory for the temporary files (a new directory is created inside of it)
+     * @throws ::std::runtime_error If the temporary directory can't be created
+     */
+    OutOfCoreOctreeBuilder(const Vector3i& maxXYZ, const ::std::string& outputPath, size_t memoryBudget, const ::std::string& tempDirectory = "/tmp",
+                           uint maxLevel = ::std::numeric_limits<uint>::max());
+
+    OutOfCoreOctreeBuilder(const OutOfCoreOctreeBuilder&) = delete;
+    OutOfCoreOctreeBuilder& operator=(const OutOfCoreOctreeBuilder&) = delete;
+
+    /**
+     * @brief Removes all temporary files
+     */
+    virtual ~OutOfCoreOctreeBuilder();
+
+    virtual morton_t addLevelZeroLeaf(const Vector3i& c) override;
+
+    /**
+     * @brief Adds a level zero leaf (see OctreeBuilder::addLeaf)
+     * @throws ::std::runtime_error If the level isn't zero (the runs only store the morton codes of level zero leafs)
+     */
+    virtual morton_t addLeaf(const Vector3i& c, uint level) override;
+
+    /**
+     * @brief Adds the occupied voxels of an occupancy volume (see OctreeBuilder::addLevelZeroLeafsFromOccupancy)
+     *
+     * The volume is scanned sequentially into the buffer which is spilled whenever it's full.
+     */
+    virtual size_t addLevelZeroLeafsFromOccupancy(const uint64_t* occupancy, const Vector3i& size, const Vector3i& llf = Vector3i(0)) override;
+
+    /**
+     * @brief Writes the octree to the output file
+     * @return The memory mapped output file (see mapOctreeFile)
+     * @throws ::std::runtime_error If a file can't be written or read
+     */
+    virtual ::std::unique_ptr<Octree> finishBuilding() override;
+
+    /**
+     * @brief Passes the leafs to the sink instead of writing the output file (see OctreeBuilder::finishBuilding(const LeafSink&))
+     * @throws ::std::runtime_error If a temporary file can't be written or read
+     */
+    virtual void finishBuilding(const LeafSink& sink) override;
+
+protected:
+    /**
+     * @brief Encodes the leafs in parallel in pieces of the size of the memory budget which are spilled to run files (see
+     * OctreeBuilder::addEncodedLevelZeroLeafs)
+     *
+     * Used by addLevelZeroLeafsFromFile and addLevelZeroLeafsFromPoints.
+     */
+    virtual bool addEncodedLevelZeroLeafs(size_t numLeafs, const LevelZeroLeafEncoder& encode) override;
+
+    /**
+     * @brief Generates the leafs of as many chunks at once as there are threads and appends them to the buffer (see OctreeBuilder::addGeneratedLevelZeroLeafs)
+     *
+     * Used by addLevelZeroLeafsFromTriangles and addLevelZeroLeafsFromSignedDistance. The leafs of the chunks in progress aren't part of the memory budget.
+     */
+    virtual void addGeneratedLevelZeroLeafs(size_t numItems, size_t itemsPerChunk, const LevelZeroLeafGenerator& generate) override;
+
+private:
+    /**
+     * @brief Runs all phases of finishBuilding up to the merge and passes the final leafs to emit (in ascending order)
+     * @param outputBytes The memory of the output of emit (allocated by the caller)
+     *
+     * The MERGE phase is started but not recorded, the caller records it after flushing its output.
+     * The buffer is released during the build (it's part of the memory budget).
+     */
+    void buildLeafs(PerfCounter& perfCounter, MemoryTracker& memory, size_t outputBytes, const ::std::function<void(const OctantID&)>& emit);
+
+    /**
+     * @brief Creates the leafs of the level from the sorted files of the level
+     * @param withNeighbourhoods Whether the runs of the octants of the next level are written (not needed for the highest level)
+     * @param octantsPath The octants of the level (the leafs and the inner octants)
+     * @param parentsPath The inner octants of the level (the parents of the octants of the previous level)
+     * @param nextParentsPath Receives the parents of the octants (the inner octants of the next level)
+     * @param leafsPath Receives the leafs of the level (the children of the next parents that aren't inner octants)
+     * @param neighbourhoodRuns Receives the runs of the next parents and their neighbours (the octants of the next level)
+     * @param liveBytes The memory of the other containers during the creation (see MemoryTracker::sample)
+     * @return The number of leafs of the level
+     */
+    size_t createLeafsOfLevel(uint level, bool withNeighbourhoods, const ::std::string& octantsPath, const ::std::string& parentsPath,
+                              const ::std::string& nextParentsPath, const ::std::string& leafsPath, ::std::vector<::std::string>& neighbourhoodRuns,
+                              MemoryTracker& memory, size_t liveBytes) const;
+
+    /**
+     * @brief Writes all octants of the level that aren't inner octants as leafs (the level is the maximum level of the leafs)
+     * @return The number of leafs of the level
+     */
+    size_t fillLevel(uint level, const ::std::string& parentsPath, const ::std::string& leafsPath) const;
+
+    /**
+     * @brief Sorts the buffer and writes it to a new run file
+     */
+    void spillBuffer();
+
+    /**
+     * @brief Merges the sorted runs into one sorted file without duplicates (the runs are kept)
+     * @param liveBytes The memory of the other containers during the merge (see MemoryTracker::sample)
+     * @return The number of records in the file
+     *
+     * At most mergeFanIn runs are merged at once. More runs are merged in several passes (the intermediate runs are written to the temporary directory).
+     */
+    size_t mergeRuns(::std::vector<::std::string> runs, const ::std::string& path, MemoryTracker& memory, size_t liveBytes) const;
+
+    /**
+     * @brief The number of runs merged at once: every run gets a buffer within the memory budget, the number of open files is limited (at least 2)
+     */
+    size_t mergeFanIn() const;
+
+    ::std::string runPath(size_t run) const;
+
+    /**
+     * @brief The path of a temporary file of the build (name-index in the temporary directory)
+     */
+    ::std::string temporaryPath(const ::std::string& name, size_t index) const;
+
+    ::std::string m_outputPath;
+    size_t m_memoryBudget;
+    ::std::string m_tempDirectory;
+
+    ::std::vector<morton_t> m_buffer;
+    size_t m_numRuns;
+};
+}
@@ -11,7 +11,10 @@
 #include <algorithm>
 #include <assert.h>
 
+#include "memoryusage.h"
 #include "perfcounter.h"
+#include "tracer.h"
+#include <iostream>
 
 namespace octreebuilder {
 
@@ -31,28 +34,119 @@ morton_t ParallelOctreeBuilder::addLevelZeroLeaf(const Vector3i& c) {
     return mortonCode;
 }
 
+LinearOctree::container_type ParallelOctreeBuilder::createLevelZeroLeafs(PerfCounter& perfCounter, MemoryTracker& memory) {
+    const size_t inputBytes = memoryUsage(m_levelZeroLeafsSet) + memoryUsage(m_levelZeroLeafsFromFiles) + memoryUsage(m_leafsAboveLevelZero);
+
+    perfCounter.start();
+    const size_t first = m_levelZeroLeafsFromFiles.size();
+    m_levelZeroLeafsFromFiles.insert(m_levelZeroLeafsFromFiles.end(), m_levelZeroLeafsSet.begin(), m_levelZeroLeafsSet.end());
+    ::std::unordered_set<morton_t>().swap(m_levelZeroLeafsSet);
+
+    pss::parallel_stable_sort(m_levelZeroLeafsFromFiles.begin() + static_cast<::std::ptrdiff_t>(first), m_levelZeroLeafsFromFiles.end());
+    mergeLevelZeroLeafsFromFiles(first);
+    // the merge uses a buffer of the size of the morton codes
+    memory.sample(inputBytes + 2 * memoryUsage(m_levelZeroLeafsFromFiles));
+
+    LinearOctree::container_type levelZeroLeafs;
+    levelZeroLeafs.reserve(m_levelZeroLeafsFromFiles.size() + m_leafsAboveLevelZero.size());
+    levelZeroLeafs.resize(m_levelZeroLeafsFromFiles.size());
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < m_levelZeroLeafsFromFiles.size(); i++) {
+        levelZeroLeafs[i] = OctantID(m_levelZeroLeafsFromFiles[i], 0);
+    }
+    memory.sample(memoryUsage(m_levelZeroLeafsFromFiles) + memoryUsage(m_leafsAboveLevelZero) + memoryUsage(levelZeroLeafs));
+    ::std::vector<morton_t>().swap(m_levelZeroLeafsFromFiles);
+
+    const size_t numLevelZeroLeafs = levelZeroLeafs.size();
+    for (const auto& leaf : m_leafsAboveLevelZero) {
+        levelZeroLeafs.push_back(OctantID(leaf.first, leaf.second));
+    }
+    recordPhase(m_buildStats, BuildStats::Phase::CREATE_INPUT, perfCounter);
+    memory.recordPhase(BuildStats::Phase::CREATE_INPUT, memoryUsage(m_leafsAboveLevelZero) + memoryUsage(levelZeroLeafs));
+    m_buildStats.numLevelZeroLeafs = levelZeroLeafs.size();
+
+    // The partition requires leafs that don't overlap (a leaf that contains finer ones is split by the balancing anyway)
+    perfCounter.start();
+    if (!m_leafsAboveLevelZero.empty()) {
+        const auto middle = levelZeroLeafs.begin() + static_cast<::std::ptrdiff_t>(numLevelZeroLeafs);
+        ::std::sort(middle, levelZeroLeafs.end());
+        ::std::inplace_merge(levelZeroLeafs.begin(), middle, levelZeroLeafs.end());
+        // the merge uses a buffer of the size of the leafs
+        memory.sample(memoryUsage(m_leafsAboveLevelZero) + 2 * memoryUsage(levelZeroLeafs));
+
+        removeAncestorOctants(levelZeroLeafs);
+    }
+    recordPhase(m_buildStats, BuildStats::Phase::SORT_INPUT, perfCounter);
+    memory.recordPhase(BuildStats::Phase::SORT_INPUT, memoryUsage(m_leafsAboveLevelZero) + memoryUsage(levelZeroLeafs));
+
+    return levelZeroLeafs;
+}
+
+void ParallelOctreeBuilder::restoreLevelZeroLeafs(const LinearOctree::container_type& leafs) {
+    // level zero leafs are never removed as ancestors, hence these are exactly the released morton codes
+    m_levelZeroLeafsFromFiles.reserve(m_buildStats.numLevelZeroLeafs);
+    for (const OctantID& leaf : leafs) {
+        if (leaf.level() == 0) {
+            m_levelZeroLeafsFromFiles.push_back(leaf.mcode());
+        }
+    }
+}
+
 ::std::unique_ptr<Octree> ParallelOctreeBuilder::finishBuilding() {
-    PerfCounter perfCounter;
+    TraceScope trace("ParallelOctreeBuilder::finishBuilding");
+    m_buildStats = BuildStats();
+
+    ::std::unique_ptr<HardwareCounters> hardwareCounters(m_hardwareCountersEnabled ? new HardwareCounters() : nullptr);
+    PerfCounter perfCounter(hardwareCounters.get());
+    MemoryTracker memory(m_buildStats);
 
     OctantID root(Vector3i(0), getOctreeDepthForBounding(m_maxXYZ));
 
-    perfCounter.start();
-    ::std::vector<OctantID> levelZeroLeafs;
-    levelZeroLeafs.reserve(m_levelZeroLeafsSet.size());
-    for (morton_t mcode : m_levelZeroLeafsSet) {
-        levelZeroLeafs.push_back(OctantID(mcode, 0));
+    const LinearOctree::container_type levelZeroLeafs = createLevelZeroLeafs(perfCounter, memory);
+
+    LinearOctree balancedOctree;
+    try {
+        balancedOctree = createBalancedOctreeParallel(root, levelZeroLeafs, omp_get_max_threads(), maxLevel(), m_buildStats, hardwareCounters.get());
+    } catch (...) {
+        restoreLevelZeroLeafs(levelZeroLeafs);
+        throw;
     }
-    LOG_PROF("Create level zero leafs list: " << perfCounter);
+    restoreLevelZeroLeafs(levelZeroLeafs);
 
     perfCounter.start();
-    pss::parallel_stable_sort(levelZeroLeafs.begin(), levelZeroLeafs.end());
-    LOG_PROF("Sort level zero leafs list: " << perfCounter);
+    OctreeImpl* octree = new OctreeImpl(::std::move(balancedOctree));
+    ::std::unique_ptr<Octree> result(octree);
+    recordPhase(m_buildStats, BuildStats::Phase::INDEX_FILL, perfCounter);
+    // the leafs are moved into the result, its lookup sets are filled on the first lookup
+    memory.sample(m_buildStats.liveBytes() + octree->nodeLookupBytes());
+    memory.recordPhase(BuildStats::Phase::INDEX_FILL, m_buildStats.liveBytes());
 
-    perfCounter.start();
-    LinearOctree balancedOctree = createBalancedOctreeParallel(root, levelZeroLeafs, omp_get_max_threads(), maxLevel());
-    LOG_PROF("Created octree: " << perfCounter);
+    LOG_PROF("Build statistics: " << m_buildStats);
 
-    ::std::unique_ptr<Octree> result(new OctreeImpl(::std::move(balancedOctree)));
     return result;
 }
+
+void ParallelOctreeBuilder::finishBuilding(const LeafSink& sink) {
+    TraceScope trace("ParallelOctreeBuilder::finishBuilding");
+    m_buildStats = BuildStats();
+
+    ::std::unique_ptr<HardwareCounters> hardwareCounters(m_hardwareCountersEnabled ? new HardwareCounters() : nullptr);
+    PerfCounter perfCounter(hardwareCounters.get());
+    MemoryTracker memory(m_buildStats);
+
+    OctantID root(Vector3i(0), getOctreeDepthForBounding(m_maxXYZ));
+
+    const LinearOctree::container_type levelZeroLeafs = createLevelZeroLeafs(perfCounter, memory);
+
+    try {
+        createBalancedOctreeParallel(root, levelZeroLeafs, omp_get_max_threads(), maxLevel(), sink, m_buildStats, hardwareCounters.get());
+    } catch (...) {
+        restoreLevelZeroLeafs(levelZeroLeafs);
+        throw;
+    }
+    restoreLevelZeroLeafs(levelZeroLeafs);
+
+    LOG_PROF("Build statistics: " << m_buildStats);
+}
 }
@@ -3,11 +3,15 @@
 #include "octreebuilder_api.h"
 
 #include "octreebuilder.h"
+#include "linearoctree.h"
 
 #include <unordered_set>
 
 namespace octreebuilder {
 
+class PerfCounter;
+class MemoryTracker;
+
 class OCTREEBUILDER_API ParallelOctreeBuilder : public OctreeBuilder {
 public:
     /**
@@ -18,8 +22,22 @@ public:
 
     virtual morton_t addLevelZeroLeaf(const Vector3i& c) override;
     virtual ::std::unique_ptr<Octree> finishBuilding() override;
+    virtual void finishBuilding(const LeafSink& sink) override;
 
 private:
+    /**
+     * @brief Creates the sorted list of all level zero leafs and the leafs above level zero (without overlapping leafs)
+     *
+     * The leafs of the hash set are moved to m_levelZeroLeafsFromFiles (only they are sorted, then they are merged with the sorted morton codes).
+     * The morton codes are released afterwards, restoreLevelZeroLeafs recreates them from the returned leafs after the build.
+     */
+    LinearOctree::container_type createLevelZeroLeafs(PerfCounter& perfCounter, MemoryTracker& memory);
+
+    /**
+     * @brief Recreates the sorted morton codes of the level zero leafs released by createLevelZeroLeafs (for the next finishBuilding)
+     */
+    void restoreLevelZeroLeafs(const LinearOctree::container_type& leafs);
+
     ::std::unordered_set<morton_t> m_levelZeroLeafsSet;
 };
 }
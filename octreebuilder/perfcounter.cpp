@@ -5,21 +5,29 @@
 
 namespace octreebuilder {
 
-PerfCounter::PerfCounter()
+PerfCounter::PerfCounter(const HardwareCounters* hardwareCounters)
     : m_start(::std::chrono::high_resolution_clock::time_point::max()),
       m_sumDurations(::std::chrono::high_resolution_clock::duration::zero()),
-      m_stopped(true) {
+      m_stopped(true),
+      m_hardwareCounters(hardwareCounters) {
 }
 
 void PerfCounter::start() {
     m_stopped = false;
     m_sumDurations = ::std::chrono::high_resolution_clock::duration::zero();
+    m_sumCounterValues = HardwareCounterValues();
+    if (m_hardwareCounters != nullptr) {
+        m_startCounterValues = m_hardwareCounters->read();
+    }
     m_start = ::std::chrono::high_resolution_clock::now();
 }
 
 ::std::chrono::high_resolution_clock::duration PerfCounter::stop() {
     if (!m_stopped) {
         m_sumDurations += ::std::chrono::high_resolution_clock::now() - m_start;
+        if (m_hardwareCounters != nullptr) {
+            m_sumCounterValues += difference(m_hardwareCounters->read(), m_startCounterValues);
+        }
         m_stopped = true;
     }
     return m_sumDurations;
@@ -28,10 +36,17 @@ void PerfCounter::start() {
 void PerfCounter::resume() {
     if (m_stopped) {
         m_stopped = false;
+        if (m_hardwareCounters != nullptr) {
+            m_startCounterValues = m_hardwareCounters->read();
+        }
         m_start = ::std::chrono::high_resolution_clock::now();
     }
 }
 
+const HardwareCounterValues& PerfCounter::hardwareCounterValues() const {
+    return m_sumCounterValues;
+}
+
 ::std::chrono::high_resolution_clock::duration PerfCounter::elapsedTime() const {
     if (m_stopped) {
         return m_sumDurations;
@@ -50,4 +65,9 @@ void PerfCounter::resume() {
 std::ostream& logPerf() {
     return std::cout << ::std::left << ::std::setw(30);
 }
+
+void recordPhase(BuildStats& stats, const BuildStats::Phase& phase, PerfCounter& perfCounter) {
+    stats.addPhaseTime(phase, perfCounter.stop());
+    stats.addPhaseCounters(phase, perfCounter.hardwareCounterValues());
+}
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "octreebuilder_api.h"
+#include "buildstats.h"
+#include "hardwarecounters.h"
 
 #include <chrono>
 #include <iosfwd>
@@ -9,7 +11,10 @@ namespace octreebuilder {
 
 class OCTREEBUILDER_API PerfCounter {
 public:
-    PerfCounter();
+    /**
+     * @param hardwareCounters If not null the values of the hardware counters are measured along with the time
+     */
+    explicit PerfCounter(const HardwareCounters* hardwareCounters = nullptr);
 
     void start();
     ::std::chrono::high_resolution_clock::duration stop();
@@ -18,16 +23,30 @@ public:
 
     ::std::chrono::high_resolution_clock::duration elapsedTime() const;
 
+    /**
+     * @brief The hardware counter values of all measured (stopped) intervals. Invalid if there are no hardware counters.
+     */
+    const HardwareCounterValues& hardwareCounterValues() const;
+
 private:
     ::std::chrono::high_resolution_clock::time_point m_start;
     ::std::chrono::high_resolution_clock::duration m_sumDurations;
     bool m_stopped;
+
+    const HardwareCounters* m_hardwareCounters;
+    HardwareCounterValues m_startCounterValues;
+    HardwareCounterValues m_sumCounterValues;
 };
 
 ::std::ostream& operator<<(::std::ostream& os, const PerfCounter& pc);
 
 ::std::ostream& logPerf();
 
+/**
+ * @brief Stops the counter and adds its time and hardware counter values to the phase
+ */
+void recordPhase(BuildStats& stats, const BuildStats::Phase& phase, PerfCounter& perfCounter);
+
 #ifdef PROFILING_ENABLED
     #define LOG_PROF(msg) logPerf() << msg << '\n'
 #else
@@ -35,4 +54,3 @@ private:
 #endif
 
 }
-
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+namespace octreebuilder {
+
+/**
+ * @brief A ray in the coordinate space of an octree
+ *
+ * The points of the ray are origin + t * direction with t >= 0.
+ * The direction doesn't have to be normalized, but must not be the null vector.
+ */
+struct OCTREEBUILDER_API Ray {
+    ::std::array<double, 3> origin;
+    ::std::array<double, 3> direction;
+};
+
+/**
+ * @brief The nodes of an octree that are hit by a ray
+ *
+ * The i-th node hit by the ray (in order of increasing ray parameter t) has the index nodeIndices[i] (see Octree::getNode)
+ * and is entered at t = entry[i] and left at t = exit[i].
+ * The intervals [entry[i], exit[i]] are consecutive (exit[i] == entry[i + 1]).
+ */
+struct OCTREEBUILDER_API RayTraversal {
+    ::std::vector<size_t> nodeIndices;
+    ::std::vector<double> entry;
+    ::std::vector<double> exit;
+};
+}
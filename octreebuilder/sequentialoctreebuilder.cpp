@@ -4,7 +4,10 @@
 #include "octree_impl.h"
 #include "octree_utils.h"
 
+#include "memoryusage.h"
 #include "perfcounter.h"
+#include "tracer.h"
+#include <algorithm>
 #include <iostream>
 
 namespace octreebuilder {
@@ -27,22 +30,100 @@ morton_t SequentialOctreeBuilder::addLevelZeroLeaf(const Vector3i& c) {
     return mortonCode;
 }
 
-::std::unique_ptr<Octree> SequentialOctreeBuilder::finishBuilding() {
-    PerfCounter perfCounter;
+/**
+ * @brief Creates the balanced octree from all level zero leafs and the leafs above level zero
+ */
+static LinearOctree createBalancedOctree(const uint depth, const ::std::unordered_set<morton_t>& levelZeroLeafsSet,
+                                         const ::std::vector<morton_t>& levelZeroLeafsFromFiles,
+                                         const ::std::unordered_map<morton_t, uint>& leafsAboveLevelZero, const uint maxLevel, BuildStats& stats,
+                                         PerfCounter& perfCounter, MemoryTracker& memory) {
+    const size_t inputBytes = memoryUsage(levelZeroLeafsSet) + memoryUsage(levelZeroLeafsFromFiles) + memoryUsage(leafsAboveLevelZero);
 
     perfCounter.start();
-    LinearOctree linearOctree(OctantID(0, getOctreeDepthForBounding(m_maxXYZ)), m_levelZeroLeafsSet.size());
+    LinearOctree linearOctree(OctantID(0, depth), levelZeroLeafsFromFiles.size() + levelZeroLeafsSet.size() + leafsAboveLevelZero.size());
 
-    for (const morton_t& mcode : m_levelZeroLeafsSet) {
+    for (const morton_t& mcode : levelZeroLeafsFromFiles) {
         linearOctree.insert(OctantID(mcode, 0));
     }
 
-    LOG_PROF("Created initial tree: " << perfCounter);
+    for (const morton_t& mcode : levelZeroLeafsSet) {
+        if (!::std::binary_search(levelZeroLeafsFromFiles.begin(), levelZeroLeafsFromFiles.end(), mcode)) {
+            linearOctree.insert(OctantID(mcode, 0));
+        }
+    }
+
+    // createBalancedSubtree splits the leafs that overlap finer ones
+    for (const auto& leaf : leafsAboveLevelZero) {
+        linearOctree.insert(OctantID(leaf.first, leaf.second));
+    }
+    recordPhase(stats, BuildStats::Phase::CREATE_INPUT, perfCounter);
+    memory.recordPhase(BuildStats::Phase::CREATE_INPUT, inputBytes + memoryUsage(linearOctree));
+    stats.numLevelZeroLeafs = linearOctree.leafs().size();
+
+    perfCounter.start();
+    size_t temporaryBytes;
+    createBalancedSubtree(linearOctree, maxLevel, temporaryBytes);
+    recordPhase(stats, BuildStats::Phase::SUBTREE_BUILD, perfCounter);
+    memory.sample(inputBytes + memoryUsage(linearOctree) + temporaryBytes);
+    memory.recordPhase(BuildStats::Phase::SUBTREE_BUILD, inputBytes + memoryUsage(linearOctree));
+    stats.numBlocks = 1;
+    stats.numLeafs = linearOctree.leafs().size();
+
+    // The whole tree is a single block that is created by one thread
+    BlockStats block;
+    block.numInputOctants = stats.numLevelZeroLeafs;
+    block.numOutputOctants = stats.numLeafs;
+    block.time = stats.phaseTime(BuildStats::Phase::SUBTREE_BUILD);
+    stats.subtreeBuildLoad.blocks = {block};
+    stats.subtreeBuildLoad.busyTimePerThread = {block.time};
+    stats.subtreeBuildLoad.wallTime = block.time;
+
+    return linearOctree;
+}
+
+::std::unique_ptr<Octree> SequentialOctreeBuilder::finishBuilding() {
+    TraceScope trace("SequentialOctreeBuilder::finishBuilding");
+    m_buildStats = BuildStats();
+
+    ::std::unique_ptr<HardwareCounters> hardwareCounters(m_hardwareCountersEnabled ? new HardwareCounters() : nullptr);
+    PerfCounter perfCounter(hardwareCounters.get());
+    MemoryTracker memory(m_buildStats);
+
+    LinearOctree linearOctree =
+        createBalancedOctree(getOctreeDepthForBounding(m_maxXYZ), m_levelZeroLeafsSet, m_levelZeroLeafsFromFiles, m_leafsAboveLevelZero, maxLevel(), m_buildStats,
+                             perfCounter, memory);
+
+    perfCounter.start();
+    OctreeImpl* octree = new OctreeImpl(::std::move(linearOctree));
+    ::std::unique_ptr<Octree> result(octree);
+    recordPhase(m_buildStats, BuildStats::Phase::INDEX_FILL, perfCounter);
+    // the leafs are moved into the result, its lookup sets are filled on the first lookup
+    memory.sample(m_buildStats.liveBytes() + octree->nodeLookupBytes());
+    memory.recordPhase(BuildStats::Phase::INDEX_FILL, m_buildStats.liveBytes());
+
+    LOG_PROF("Build statistics: " << m_buildStats);
+
+    return result;
+}
+
+void SequentialOctreeBuilder::finishBuilding(const LeafSink& sink) {
+    TraceScope trace("SequentialOctreeBuilder::finishBuilding");
+    m_buildStats = BuildStats();
+
+    ::std::unique_ptr<HardwareCounters> hardwareCounters(m_hardwareCountersEnabled ? new HardwareCounters() : nullptr);
+    PerfCounter perfCounter(hardwareCounters.get());
+    MemoryTracker memory(m_buildStats);
+
+    const LinearOctree linearOctree =
+        createBalancedOctree(getOctreeDepthForBounding(m_maxXYZ), m_levelZeroLeafsSet, m_levelZeroLeafsFromFiles, m_leafsAboveLevelZero, maxLevel(), m_buildStats,
+                             perfCounter, memory);
 
     perfCounter.start();
-    createBalancedSubtree(linearOctree, maxLevel());
-    LOG_PROF("Created balanced tree: " << perfCounter);
+    passLeafsToSink(sink, linearOctree.leafs().begin(), linearOctree.leafs().end());
+    recordPhase(m_buildStats, BuildStats::Phase::MERGE, perfCounter);
+    // the leafs are passed in small chunks
+    memory.recordPhase(BuildStats::Phase::MERGE, m_buildStats.liveBytes());
 
-    return ::std::unique_ptr<Octree>(new OctreeImpl(::std::move(linearOctree)));
+    LOG_PROF("Build statistics: " << m_buildStats);
 }
 }
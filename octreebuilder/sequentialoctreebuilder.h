@@ -18,6 +18,7 @@ public:
     virtual morton_t addLevelZeroLeaf(const Vector3i& c) override;
 
     virtual ::std::unique_ptr<Octree> finishBuilding() override;
+    virtual void finishBuilding(const LeafSink& sink) override;
 
 private:
     ::std::unordered_set<morton_t> m_levelZeroLeafsSet;
@@ -0,0 +1,146 @@
+#include "tracer.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+namespace octreebuilder {
+
+static ::std::atomic<Tracer*> s_activeTracer(nullptr);
+
+Tracer::Tracer() : m_origin(clock::now()) {
+}
+
+Tracer::~Tracer() {
+    deactivate();
+}
+
+void Tracer::activate() {
+    Tracer* expected = nullptr;
+    if (!s_activeTracer.compare_exchange_strong(expected, this) && expected != this) {
+        throw ::std::runtime_error("Tracer::activate: Another tracer is already active.");
+    }
+}
+
+void Tracer::deactivate() {
+    Tracer* expected = this;
+    s_activeTracer.compare_exchange_strong(expected, nullptr);
+}
+
+Tracer* Tracer::activeTracer() {
+    return s_activeTracer.load(::std::memory_order_acquire);
+}
+
+void Tracer::recordCompletedEvent(const ::std::string& name, const ::std::string& category, const clock::duration& duration,
+                                  const ::std::vector<::std::pair<::std::string, long long>>& args) {
+    Tracer* tracer = activeTracer();
+    if (tracer != nullptr) {
+        const clock::time_point end = clock::now();
+        tracer->addEvent(name, category, end - duration, end, args);
+    }
+}
+
+void Tracer::addEvent(const ::std::string& name, const ::std::string& category, const clock::time_point& start, const clock::time_point& end,
+                      const ::std::vector<::std::pair<::std::string, long long>>& args) {
+    ::std::lock_guard<::std::mutex> lock(m_mutex);
+
+    auto thread = m_threads.insert(::std::make_pair(::std::this_thread::get_id(), m_threads.size())).first;
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.thread = thread->second;
+    event.start = start;
+    event.duration = end - start;
+    event.args = args;
+    m_events.push_back(event);
+}
+
+::std::vector<Tracer::Event> Tracer::events() const {
+    ::std::lock_guard<::std::mutex> lock(m_mutex);
+    return m_events;
+}
+
+static void writeJSONString(::std::ostream& os, const ::std::string& str) {
+    os << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << ::std::hex << ::std::setw(4) << ::std::setfill('0') << static_cast<int>(c) << ::std::dec << ::std::setfill(' ');
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+void Tracer::writeChromeTrace(::std::ostream& os) const {
+    ::std::lock_guard<::std::mutex> lock(m_mutex);
+
+    const auto toMicroseconds = [](const clock::duration& d) { return ::std::chrono::duration<double, ::std::micro>(d).count(); };
+
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    for (const auto& thread : m_threads) {
+        os << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.second
+           << ",\"args\":{\"name\":\"thread " << thread.second << "\"}}";
+        first = false;
+    }
+
+    const ::std::streamsize precision = os.precision();
+    os << ::std::fixed << ::std::setprecision(3);
+
+    for (const Event& event : m_events) {
+        os << (first ? "" : ",") << "\n{\"name\":";
+        writeJSONString(os, event.name);
+        os << ",\"cat\":";
+        writeJSONString(os, event.category);
+        os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << toMicroseconds(event.start - m_origin)
+           << ",\"dur\":" << toMicroseconds(event.duration);
+
+        if (!event.args.empty()) {
+            os << ",\"args\":{";
+            for (size_t i = 0; i < event.args.size(); i++) {
+                os << (i > 0 ? "," : "");
+                writeJSONString(os, event.args[i].first);
+                os << ":" << event.args[i].second;
+            }
+            os << "}";
+        }
+        os << "}";
+        first = false;
+    }
+
+    os << ::std::defaultfloat << ::std::setprecision(static_cast<int>(precision));
+    os << "\n]}\n";
+}
+
+void Tracer::writeChromeTrace(const ::std::string& fileName) const {
+    ::std::ofstream file(fileName);
+    writeChromeTrace(file);
+
+    if (!file) {
+        throw ::std::runtime_error("Tracer::writeChromeTrace: Failed to write file '" + fileName + "'.");
+    }
+}
+
+TraceScope::TraceScope(const char* name, const char* category)
+    : m_tracer(Tracer::activeTracer()), m_name(name), m_category(category), m_start(m_tracer != nullptr ? Tracer::clock::now() : Tracer::clock::time_point()) {
+}
+
+void TraceScope::addArg(const char* name, long long value) {
+    if (m_tracer != nullptr) {
+        m_args.push_back(::std::make_pair(::std::string(name), value));
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (m_tracer != nullptr) {
+        m_tracer->addEvent(m_name, m_category, m_start, Tracer::clock::now(), m_args);
+    }
+}
+}
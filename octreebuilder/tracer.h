@@ -0,0 +1,125 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <iosfwd>
+
+namespace octreebuilder {
+
+/**
+ * @brief Records a timeline of (nested) events of all threads, e.g. the phases of an octree build
+ *
+ * Events are only recorded while the tracer is active. At most one tracer can be active at a time.
+ * The recorded events can be exported in the Chrome trace event format (viewable in chrome://tracing or Perfetto).
+ */
+class OCTREEBUILDER_API Tracer {
+public:
+    typedef ::std::chrono::steady_clock clock;
+
+    struct OCTREEBUILDER_API Event {
+        ::std::string name;
+        ::std::string category;
+
+        /**
+         * @brief A small number that identifies the thread that recorded the event (in order of the first event of each thread)
+         */
+        size_t thread;
+
+        clock::time_point start;
+        clock::duration duration;
+        ::std::vector<::std::pair<::std::string, long long>> args;
+    };
+
+    Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    /**
+     * @brief Deactivates the tracer if its active
+     */
+    ~Tracer();
+
+    /**
+     * @brief Starts recording events
+     * @note Throws an error if another tracer is active
+     */
+    void activate();
+
+    /**
+     * @brief Stops recording events
+     */
+    void deactivate();
+
+    /**
+     * @brief The active tracer or nullptr if no tracer is active
+     */
+    static Tracer* activeTracer();
+
+    /**
+     * @brief Records an event of the calling thread that ended now (does nothing if no tracer is active)
+     */
+    static void recordCompletedEvent(const ::std::string& name, const ::std::string& category, const clock::duration& duration,
+                                     const ::std::vector<::std::pair<::std::string, long long>>& args = {});
+
+    /**
+     * @brief Records an event of the calling thread (thread-safe)
+     */
+    void addEvent(const ::std::string& name, const ::std::string& category, const clock::time_point& start, const clock::time_point& end,
+                  const ::std::vector<::std::pair<::std::string, long long>>& args = {});
+
+    /**
+     * @brief The recorded events in the order they were recorded (ended)
+     */
+    ::std::vector<Event> events() const;
+
+    /**
+     * @brief Writes the recorded events as Chrome trace event JSON
+     */
+    void writeChromeTrace(::std::ostream& os) const;
+
+    /**
+     * @brief Writes the recorded events as Chrome trace event JSON into a file
+     * @note Throws an error if the file can't be written
+     */
+    void writeChromeTrace(const ::std::string& fileName) const;
+
+private:
+    mutable ::std::mutex m_mutex;
+    clock::time_point m_origin;
+    ::std::vector<Event> m_events;
+    ::std::unordered_map<::std::thread::id, size_t> m_threads;
+};
+
+/**
+ * @brief Records an event for the lifetime of the scope (if a tracer is active)
+ */
+class OCTREEBUILDER_API TraceScope {
+public:
+    explicit TraceScope(const char* name, const char* category = "octreebuilder");
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    /**
+     * @brief Attaches a value to the event (e.g. a size)
+     */
+    void addArg(const char* name, long long value);
+
+    ~TraceScope();
+
+private:
+    Tracer* m_tracer;
+    const char* m_name;
+    const char* m_category;
+    Tracer::clock::time_point m_start;
+    ::std::vector<::std::pair<::std::string, long long>> m_args;
+};
+}
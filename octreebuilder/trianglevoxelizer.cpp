@@ -0,0 +1,136 @@
+#include "trianglevoxelizer.h"
+
+#include "mortoncode_utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace octreebuilder {
+
+typedef ::std::array<double, 3> Point;
+
+static Point subtract(const Point& a, const Point& b) {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+static Point cross(const Point& a, const Point& b) {
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+static double dot(const Point& a, const Point& b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/**
+ * @brief Tests whether the projections of the triangle and the box onto the axis are disjoint
+ * @param vertices The vertices of the triangle relative to the center of the box
+ */
+static bool isSeparatingAxis(const Point& axis, const Point* vertices, const Point& halfSize) {
+    const double p0 = dot(axis, vertices[0]);
+    const double p1 = dot(axis, vertices[1]);
+    const double p2 = dot(axis, vertices[2]);
+    const double r = halfSize[0] * ::std::abs(axis[0]) + halfSize[1] * ::std::abs(axis[1]) + halfSize[2] * ::std::abs(axis[2]);
+
+    return ::std::min(p0, ::std::min(p1, p2)) > r || ::std::max(p0, ::std::max(p1, p2)) < -r;
+}
+
+bool triangleIntersectsBox(const Triangle& triangle, const Box& box) {
+    Point center;
+    Point halfSize;
+    for (uint i = 0; i < 3; i++) {
+        center[i] = (static_cast<double>(box.llf()[i]) + static_cast<double>(box.urb()[i])) / 2;
+        halfSize[i] = (static_cast<double>(box.urb()[i]) - static_cast<double>(box.llf()[i])) / 2;
+    }
+
+    const Point vertices[3] = {subtract(triangle[0], center), subtract(triangle[1], center), subtract(triangle[2], center)};
+
+    // the face normals of the box
+    for (uint i = 0; i < 3; i++) {
+        Point axis = {0, 0, 0};
+        axis[i] = 1;
+        if (isSeparatingAxis(axis, vertices, halfSize)) {
+            return false;
+        }
+    }
+
+    const Point edges[3] = {subtract(vertices[1], vertices[0]), subtract(vertices[2], vertices[1]), subtract(vertices[0], vertices[2])};
+
+    // the normal of the triangle
+    if (isSeparatingAxis(cross(edges[0], edges[1]), vertices, halfSize)) {
+        return false;
+    }
+
+    // the cross products of the edges and the face normals of the box
+    for (const Point& edge : edges) {
+        for (uint i = 0; i < 3; i++) {
+            Point boxNormal = {0, 0, 0};
+            boxNormal[i] = 1;
+            if (isSeparatingAxis(cross(edge, boxNormal), vertices, halfSize)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends the voxels of the octant inside of bounding that intersect the triangle (the children are visited in morton order)
+ */
+static void voxelizeOctant(const Triangle& triangle, const Box& bounding, const Vector3i& llf, const uint level, ::std::vector<morton_t>& codes) {
+    const coord_t size = getOctantSizeForLevel(level);
+    const Box octant(llf, llf + Vector3i(size));
+
+    if (!octant.intersection(bounding).valid() || !triangleIntersectsBox(triangle, octant)) {
+        return;
+    }
+
+    if (level == 0) {
+        codes.push_back(getMortonCodeForCoordinate(llf));
+        return;
+    }
+
+    const coord_t childSize = size / 2;
+    for (uint child = 0; child < 8; child++) {
+        const Vector3i childOffset(child & 4 ? childSize : 0, child & 2 ? childSize : 0, child & 1 ? childSize : 0);
+        voxelizeOctant(triangle, bounding, llf + childOffset, level - 1, codes);
+    }
+}
+
+void voxelizeTriangle(const Triangle& triangle, const Box& domain, ::std::vector<morton_t>& codes) {
+    // the voxels of the bounding box of the triangle (clamped to the domain before the conversion to avoid overflows)
+    coord_t llf[3];
+    coord_t urb[3];
+    for (uint i = 0; i < 3; i++) {
+        if (::std::isnan(triangle[0][i]) || ::std::isnan(triangle[1][i]) || ::std::isnan(triangle[2][i])) {
+            return;
+        }
+
+        double min = ::std::floor(::std::min(triangle[0][i], ::std::min(triangle[1][i], triangle[2][i])));
+        double max = ::std::floor(::std::max(triangle[0][i], ::std::max(triangle[1][i], triangle[2][i])));
+        min = min > static_cast<double>(domain.llf()[i]) ? min : static_cast<double>(domain.llf()[i]);
+        max = max < static_cast<double>(domain.urb()[i] - 1) ? max : static_cast<double>(domain.urb()[i] - 1);
+
+        // outside of the domain
+        if (!(min <= max)) {
+            return;
+        }
+
+        llf[i] = static_cast<coord_t>(min);
+        urb[i] = static_cast<coord_t>(max) + 1;
+    }
+
+    const Box bounding(Vector3i(llf[0], llf[1], llf[2]), Vector3i(urb[0], urb[1], urb[2]));
+
+    // the smallest octant that contains the bounding box
+    uint level = 0;
+    for (uint i = 0; i < 3; i++) {
+        while ((llf[i] >> level) != ((urb[i] - 1) >> level)) {
+            level++;
+        }
+    }
+
+    const Vector3i octantLLF(llf[0] >> level << level, llf[1] >> level << level, llf[2] >> level << level);
+    voxelizeOctant(triangle, bounding, octantLLF, level, codes);
+}
+}
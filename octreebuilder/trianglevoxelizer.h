@@ -0,0 +1,32 @@
+#pragma once
+
+#include "octreebuilder_api.h"
+
+#include "box.h"
+#include "mortoncode.h"
+
+#include <array>
+#include <vector>
+
+namespace octreebuilder {
+
+/**
+ * @brief The vertices of a triangle in voxel space (the voxel (x, y, z) covers [x, x + 1] x [y, y + 1] x [z, z + 1])
+ */
+typedef ::std::array<::std::array<double, 3>, 3> Triangle;
+
+/**
+ * @brief Tests whether the triangle intersects the closed box (separating axis test by Akenine-Möller)
+ */
+OCTREEBUILDER_API bool triangleIntersectsBox(const Triangle& triangle, const Box& box);
+
+/**
+ * @brief Appends the morton codes of all voxels of the domain that intersect the triangle (conservative voxelization)
+ * @param domain The voxels that may be appended (the urb is exclusive)
+ *
+ * The smallest octant that contains the bounding box of the triangle is subdivided recursively, octants that don't intersect the triangle are skipped
+ * with all their voxels. Hence the number of tested octants grows with the area of the triangle and not with the volume of its bounding box.
+ * The codes are appended in ascending order.
+ */
+OCTREEBUILDER_API void voxelizeTriangle(const Triangle& triangle, const Box& domain, ::std::vector<morton_t>& codes);
+}
@@ -78,3 +78,12 @@ TEST(BoxTest, containsBox) {
 
     EXPECT_FALSE(testBox.contains(Box(Vector3i(3), Vector3i(5))));
 }
+
+TEST(BoxTest, intersectionTest) {
+    const Box testBox(Vector3i(0), Vector3i(4));
+
+    EXPECT_EQ(Box(Vector3i(2, 0, 1), Vector3i(4, 3, 4)), testBox.intersection(Box(Vector3i(2, -1, 1), Vector3i(6, 3, 5))));
+    EXPECT_EQ(testBox, testBox.intersection(Box(Vector3i(-1), Vector3i(5))));
+    EXPECT_FALSE(testBox.intersection(Box(Vector3i(4, 0, 0), Vector3i(6))).valid());
+    EXPECT_FALSE(testBox.intersection(Box()).valid());
+}
@@ -0,0 +1,79 @@
+#include <gmock/gmock.h>
+
+#include <hardwarecounters.h>
+
+using namespace octreebuilder;
+
+TEST(HardwareCountersTest, addValuesTest) {
+    HardwareCounterValues sum;
+    EXPECT_FALSE(sum.valid);
+
+    HardwareCounterValues values;
+    values.valid = true;
+    values.instructions = 10;
+    values.cycles = 20;
+    values.cacheReferences = 5;
+    values.cacheMisses = 1;
+    values.branchInstructions = 4;
+    values.branchMisses = 2;
+
+    sum += values;
+    sum += values;
+    sum += HardwareCounterValues();
+
+    EXPECT_TRUE(sum.valid);
+    EXPECT_EQ(20, sum.instructions);
+    EXPECT_EQ(40, sum.cycles);
+    EXPECT_EQ(10, sum.cacheReferences);
+    EXPECT_EQ(2, sum.cacheMisses);
+    EXPECT_EQ(8, sum.branchInstructions);
+    EXPECT_EQ(4, sum.branchMisses);
+}
+
+TEST(HardwareCountersTest, differenceTest) {
+    HardwareCounterValues start;
+    start.valid = true;
+    start.instructions = 10;
+    start.cycles = 20;
+    start.cacheReferences = 5;
+    start.cacheMisses = 1;
+    start.branchInstructions = 4;
+    start.branchMisses = 2;
+
+    HardwareCounterValues end = start;
+    end.instructions = 15;
+    end.cycles = 18; // multiplexed counters may decrease
+    end.cacheMisses = 3;
+
+    const HardwareCounterValues diff = difference(end, start);
+    EXPECT_TRUE(diff.valid);
+    EXPECT_EQ(5, diff.instructions);
+    EXPECT_EQ(0, diff.cycles);
+    EXPECT_EQ(0, diff.cacheReferences);
+    EXPECT_EQ(2, diff.cacheMisses);
+    EXPECT_EQ(0, diff.branchInstructions);
+    EXPECT_EQ(0, diff.branchMisses);
+
+    EXPECT_FALSE(difference(end, HardwareCounterValues()).valid);
+    EXPECT_FALSE(difference(HardwareCounterValues(), start).valid);
+}
+
+TEST(HardwareCountersTest, readTest) {
+    HardwareCounters counters;
+
+    const HardwareCounterValues first = counters.read();
+    EXPECT_EQ(counters.available(), first.valid);
+
+    volatile unsigned long long sum = 0;
+    for (unsigned long long i = 0; i < 100000; i++) {
+        sum = sum + i;
+    }
+
+    const HardwareCounterValues second = counters.read();
+    EXPECT_EQ(counters.available(), second.valid);
+
+    if (counters.available()) {
+        EXPECT_GT(second.instructions, first.instructions);
+        EXPECT_GT(second.cycles, first.cycles);
+    }
+}
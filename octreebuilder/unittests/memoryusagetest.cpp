@@ -0,0 +1,85 @@
+#include <gmock/gmock.h>
+
+#include <memoryusage.h>
+#include <octree_impl.h>
+#include <octree_utils.h>
+#include <vector_utils.h>
+
+#include <limits>
+
+using namespace octreebuilder;
+
+TEST(MemoryUsageTest, containerMemoryUsageTest) {
+    std::vector<uint64_t> values;
+    EXPECT_EQ(0, memoryUsage(values));
+
+    values.reserve(1000);
+    EXPECT_EQ(1000 * sizeof(uint64_t), memoryUsage(values));
+
+    std::unordered_set<uint64_t> set;
+    const size_t emptySetBytes = memoryUsage(set);
+    set.insert(values.begin(), values.end());
+    set.insert(1);
+    EXPECT_GT(memoryUsage(set), emptySetBytes + sizeof(uint64_t));
+
+    const LinearOctree octree(OctantID(0, 2), 64);
+    EXPECT_EQ(64 * sizeof(OctantID), memoryUsage(octree));
+
+    const std::vector<std::vector<uint64_t>> all = {std::vector<uint64_t>(10), std::vector<uint64_t>(20)};
+    EXPECT_EQ(all.capacity() * sizeof(std::vector<uint64_t>) + 30 * sizeof(uint64_t), memoryUsageOfAll(all));
+}
+
+TEST(MemoryUsageTest, addPhaseMemoryTest) {
+    BuildStats stats;
+    EXPECT_EQ(0, stats.peakLiveBytes());
+    EXPECT_EQ(0, stats.liveBytes());
+
+    stats.addPhaseMemory(BuildStats::Phase::MERGE, MemoryStats(80, 50));
+    stats.addPhaseMemory(BuildStats::Phase::MERGE, MemoryStats(60, 40));
+    stats.addPhaseMemory(BuildStats::Phase::FLATTEN, MemoryStats(60, 30));
+
+    const MemoryStats& merge = stats.phaseMemory(BuildStats::Phase::MERGE);
+    EXPECT_EQ(80, merge.peakLiveBytes);
+    EXPECT_EQ(40, merge.liveBytes);
+    EXPECT_EQ(80, stats.peakLiveBytes());
+    EXPECT_EQ(30, stats.liveBytes());
+}
+
+TEST(MemoryUsageTest, memoryTrackerTest) {
+    BuildStats stats;
+
+    MemoryTracker memory(stats);
+    memory.recordPhase(BuildStats::Phase::CREATE_INPUT, 100);
+    memory.sample(300);
+    memory.recordPhase(BuildStats::Phase::SORT_INPUT, 100);
+
+    EXPECT_EQ(100, stats.phaseMemory(BuildStats::Phase::CREATE_INPUT).peakLiveBytes);
+    EXPECT_EQ(300, stats.phaseMemory(BuildStats::Phase::SORT_INPUT).peakLiveBytes);
+    EXPECT_EQ(100, stats.phaseMemory(BuildStats::Phase::SORT_INPUT).liveBytes);
+
+    // a tracker of a later part of the build starts with the live bytes (the bytes live at the start of a phase are part of its peak)
+    MemoryTracker laterMemory(stats);
+    laterMemory.recordPhase(BuildStats::Phase::PARTITION, 20);
+    laterMemory.recordPhase(BuildStats::Phase::SUBTREE_BUILD, 0);
+
+    EXPECT_EQ(120, stats.phaseMemory(BuildStats::Phase::PARTITION).liveBytes);
+    EXPECT_EQ(120, stats.phaseMemory(BuildStats::Phase::SUBTREE_BUILD).peakLiveBytes);
+    EXPECT_EQ(100, stats.phaseMemory(BuildStats::Phase::SUBTREE_BUILD).liveBytes);
+    EXPECT_EQ(300, stats.peakLiveBytes());
+}
+
+TEST(MemoryUsageTest, temporaryMemoryTest) {
+    // the node sets of the creation are sampled (at least one node per level zero leaf)
+    LinearOctree tree(OctantID(0, 4));
+    for (Vector3i c : VectorSpace(Vector3i(4))) {
+        tree.insert(OctantID(c, 0));
+    }
+
+    size_t temporaryBytes;
+    createBalancedSubtree(tree, std::numeric_limits<uint>::max(), temporaryBytes);
+    EXPECT_GE(temporaryBytes, hashSetMemoryUsage<OctantID>(0, 64));
+
+    // the lookup sets are estimated before they are filled on the first lookup
+    const OctreeImpl octree(std::move(tree));
+    EXPECT_GE(octree.nodeLookupBytes(), hashSetMemoryUsage<morton_t>(octree.getNumNodes(), octree.getNumNodes()));
+}
@@ -49,6 +49,12 @@ TEST(MortonCodeUtilsTest, getMortonCodeForCoordinateTest) {
     EXPECT_EQ(5376, getMortonCodeForCoordinate(Vector3i(4, 8, 16)));
 }
 
+TEST(MortonCodeUtilsTest, getMortonCodeForCoordinateAbove16BitsTest) {
+    EXPECT_EQ(morton_t(1) << 48, getMortonCodeForCoordinate(Vector3i(0, 0, 1 << 16)));
+    EXPECT_EQ(morton_t(1) << 62, getMortonCodeForCoordinate(Vector3i(1 << 20, 0, 0)));
+    EXPECT_EQ(Vector3i(65537, 1048575, 131072), getCoordinateForMortonCode(getMortonCodeForCoordinate(Vector3i(65537, 1048575, 131072))));
+}
+
 TEST(MortonCodeUtilsTest, getCoordinateForMortonCodeUtilsTest) {
     EXPECT_EQ(Vector3i(0), getCoordinateForMortonCode(0));
     EXPECT_EQ(Vector3i(1, 1, 1), getCoordinateForMortonCode(7));
@@ -89,6 +95,15 @@ TEST(MortonCodeUtilsTest, getMortonCodeForAncestorTest) {
     EXPECT_ANY_THROW(getMortonCodeForAncestor(0, 1, 0));
 }
 
+TEST(MortonCodeUtilsTest, getMortonCodeForDeepestLastDecendantTest) {
+    EXPECT_EQ(0, getMortonCodeForDeepestLastDecendant(0, 0));
+    EXPECT_EQ(7, getMortonCodeForDeepestLastDecendant(0, 1));
+    EXPECT_EQ(63, getMortonCodeForDeepestLastDecendant(0, 2));
+    EXPECT_EQ(getMortonCodeForCoordinate(Vector3i(5, 5, 5)), getMortonCodeForDeepestLastDecendant(getMortonCodeForCoordinate(Vector3i(4, 4, 4)), 1));
+    EXPECT_EQ(getMortonCodeForCoordinate(Vector3i(7, 3, 3)), getMortonCodeForDeepestLastDecendant(getMortonCodeForCoordinate(Vector3i(4, 0, 0)), 2));
+    EXPECT_EQ(getMortonCodeForCoordinate(Vector3i(6, 3, 1)), getMortonCodeForDeepestLastDecendant(getMortonCodeForCoordinate(Vector3i(6, 3, 1)), 0));
+}
+
 TEST(MortonCodeUtilsTest, getMortonCodesForChildrenTest) {
     EXPECT_ANY_THROW(getMortonCodesForChildren(getMortonCodeForCoordinate({0, 0, 0}), 0)) << "Leaf nodes can't have children.";
 
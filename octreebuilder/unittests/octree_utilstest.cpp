@@ -113,6 +113,30 @@ TEST(OctreeUtilsTest, propagateRippleInIncompleteUnbalancedTreeTest) {
     }
 }
 
+TEST(OctreeUtilsTest, balanceTreeCountsSplitOctantsTest) {
+    LinearOctree unbalancedOctree(OctantID(0, 4));
+
+    for (Vector3i c : VectorSpace(Vector3i(2))) {
+        unbalancedOctree.insert(OctantID(c + Vector3i(6), 0));
+
+        if (c != Vector3i(0)) {
+            unbalancedOctree.insert(OctantID(c * 8, 3));
+        }
+    }
+
+    unbalancedOctree.sortAndRemove();
+
+    size_t numSplits = 0;
+    const LinearOctree balancedTree = balanceTree(unbalancedOctree, numSplits);
+
+    EXPECT_EQ(7, numSplits);
+    EXPECT_EQ(balanceTree(unbalancedOctree).leafs(), balancedTree.leafs());
+
+    numSplits = 1;
+    EXPECT_EQ(balancedTree.leafs(), balanceTree(balancedTree, numSplits).leafs());
+    EXPECT_EQ(0, numSplits);
+}
+
 TEST(OctreeUtilsTest, createBalancedSubtreeNoLeafsTest) {
     ASSERT_THAT(createBalancedSubtree(OctantID(Vector3i(0), 0), {}).leafs(), ::testing::ElementsAre(OctantID(Vector3i(0), 0)));
     ASSERT_THAT(createBalancedSubtree(OctantID(Vector3i(0), 4), {}).leafs(), ::testing::ElementsAre(OctantID(Vector3i(0), 4)));
@@ -151,6 +175,56 @@ TEST(OctreeUtilsTest, createBalancedSubtreeNotAtOriginTest) {
     }
 }
 
+TEST(OctreeUtilsTest, createBalancedSubtreeWithCoarseLeafsTest) {
+    // a leaf of level 2 is kept, the remaining space is filled with its siblings and the siblings of its parent
+    LinearOctree octree = createBalancedSubtree(OctantID(Vector3i(0), 4), {OctantID(Vector3i(0), 2)});
+
+    ASSERT_THAT(octree.leafs(), ::testing::SizeIs(15));
+    for (Vector3i c : VectorSpace(Vector3i(2))) {
+        ASSERT_THAT(octree.leafs(), ::testing::Contains(::testing::Eq(OctantID(c * 4, 2))));
+
+        if (c != Vector3i(0)) {
+            ASSERT_THAT(octree.leafs(), ::testing::Contains(::testing::Eq(OctantID(c * 8, 3))));
+        }
+    }
+
+    // a leaf that contains a finer leaf is replaced by the octants around the finer one
+    EXPECT_THAT(createBalancedSubtree(OctantID(Vector3i(0), 4), {OctantID(Vector3i(0), 2), OctantID(Vector3i(0), 0)}).leafs(),
+                ::testing::ContainerEq(createBalancedSubtree(OctantID(Vector3i(0), 4), {OctantID(Vector3i(0), 0)}).leafs()));
+
+    // a leaf of level 3 next to a leaf of level 0 is split to balance the tree
+    octree = createBalancedSubtree(OctantID(Vector3i(0), 4), {OctantID(Vector3i(7, 0, 0), 0), OctantID(Vector3i(8, 0, 0), 3)});
+    EXPECT_THAT(octree.leafs(), ::testing::Not(::testing::Contains(::testing::Eq(OctantID(Vector3i(8, 0, 0), 3)))));
+    EXPECT_THAT(octree.leafs(), ::testing::Contains(::testing::Eq(OctantID(Vector3i(8, 0, 0), 1))));
+
+    // leafs above the max level are replaced by octants of the max level
+    octree = createBalancedSubtree(OctantID(Vector3i(0), 3), {OctantID(Vector3i(0), 2)}, 1);
+    EXPECT_THAT(octree.leafs(), ::testing::AllOf(::testing::SizeIs(64), ::testing::Each(::testing::Property(&OctantID::level, 1))));
+
+    // a block that isn't at the origin is filled inside of its own bounds
+    octree = createBalancedSubtree(OctantID(Vector3i(8, 0, 0), 3), {OctantID(Vector3i(8, 0, 0), 0)}, 1);
+    EXPECT_THAT(octree.leafs(), ::testing::AllOf(::testing::SizeIs(71), ::testing::Each(::testing::Property(&OctantID::level, ::testing::Le(1u)))));
+    for (const OctantID& leaf : octree.leafs()) {
+        ASSERT_TRUE(octree.insideTreeBounds(leaf));
+    }
+
+    // the root itself
+    EXPECT_THAT(createBalancedSubtree(OctantID(Vector3i(0), 3), {OctantID(Vector3i(0), 3)}).leafs(), ::testing::ElementsAre(OctantID(Vector3i(0), 3)));
+}
+
+TEST(OctreeUtilsTest, removeAncestorOctantsTest) {
+    LinearOctree::container_type octants{OctantID(0, 2), OctantID(0, 1), OctantID(0, 0), OctantID(0, 0), OctantID(8, 1),
+                                         OctantID(64, 2), OctantID(72, 0), OctantID(128, 1), OctantID(448, 2)};
+
+    removeAncestorOctants(octants);
+
+    EXPECT_THAT(octants, ::testing::ElementsAre(OctantID(0, 0), OctantID(8, 1), OctantID(72, 0), OctantID(128, 1), OctantID(448, 2)));
+
+    LinearOctree::container_type empty;
+    removeAncestorOctants(empty);
+    EXPECT_THAT(empty, ::testing::IsEmpty());
+}
+
 TEST(OctreeUtilsTest, nearestCommonAncestorTest) {
     ASSERT_THAT(nearestCommonAncestor(OctantID(0, 0), OctantID(0, 0)), ::testing::Eq(OctantID(0, 0)));
     ASSERT_THAT(nearestCommonAncestor(OctantID(1, 0), OctantID(0, 0)), ::testing::Eq(OctantID(0, 1)));
@@ -207,7 +281,7 @@ MATCHER_P2(IsValidPartition, levelZeroLeafs, globalTree, std::string(negation ?
         }
     }
 
-    std::vector<OctantID> partitionLeafs;
+    LinearOctree::container_type partitionLeafs;
     for (const LinearOctree& block : partition.partitions) {
         for (const OctantID& leaf : block.leafs()) {
             partitionLeafs.push_back(leaf);
@@ -229,7 +303,7 @@ TEST(OctreeUtilsTest, computePartitionTest) {
 
     const LinearOctree globalTree(OctantID(0, 3));
 
-    std::vector<OctantID> levelZeroLeafs;
+    LinearOctree::container_type levelZeroLeafs;
     for (morton_t mcode = 32; mcode <= globalTree.deepestLastDecendant().mcode() - 32; mcode += 8) {
         levelZeroLeafs.push_back(OctantID(mcode, 0));
     }
@@ -246,12 +320,26 @@ TEST(OctreeUtilsTest, computePartitionTest) {
 
 TEST(OctreeUtilsTest, computePartitionWithLessLeafsThenThreadsTest) {
     const LinearOctree globalTree(OctantID(0, 3));
-    const std::vector<OctantID> levelZeroLeafs{OctantID(0, 0), OctantID(511, 0)};
+    const LinearOctree::container_type levelZeroLeafs{OctantID(0, 0), OctantID(511, 0)};
 
     Partition partition = computePartition(globalTree.root(), levelZeroLeafs, 4);
     ASSERT_THAT(partition, IsValidPartition(levelZeroLeafs, globalTree));
 }
 
+TEST(OctreeUtilsTest, computePartitionWithCoarseLeafsTest) {
+    const LinearOctree globalTree(OctantID(0, 4));
+
+    LinearOctree::container_type leafs;
+    for (morton_t mcode = 0; mcode < 4096; mcode += 64) {
+        leafs.push_back(OctantID(mcode, mcode % 512 == 0 ? 2 : 0));
+    }
+
+    for (int numThreads : {2, 4, 8}) {
+        Partition partition = computePartition(globalTree.root(), leafs, numThreads);
+        ASSERT_THAT(partition, IsValidPartition(leafs, globalTree));
+    }
+}
+
 TEST(OctreeUtilsTest, completeRegionTest) {
     const auto result = completeRegion(OctantID(36, 0), OctantID(294, 0));
 
@@ -0,0 +1,303 @@
+#include <gmock/gmock.h>
+
+#include <octreefile.h>
+#include <octree_impl.h>
+#include <octreefileformat.h>
+#include <octreefilewriter.h>
+#include <vector_utils.h>
+#include <mortoncode_utils.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace octreebuilder;
+
+class OctreeFileTest : public ::testing::Test {
+protected:
+    virtual void SetUp() override {
+        // A 4x4x4 octree with a refined first octant (see OctreeTest)
+        std::vector<std::unordered_set<morton_t>> tree(3);
+        for (Vector3i c : VectorSpace(Vector3i(2))) {
+            tree.at(0).insert(getMortonCodeForCoordinate(c));
+
+            if (c != Vector3i(0)) {
+                tree.at(1).insert(getMortonCodeForCoordinate(c * 2));
+            }
+        }
+
+        octree = std::unique_ptr<Octree>(new OctreeImpl(std::move(tree)));
+
+        // the files are named after the test and removed in TearDown (also if an assertion failed)
+        path = std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".octree";
+        tempDirectory = path + ".temp";
+    }
+
+    virtual void TearDown() override {
+        std::remove(path.c_str());
+        std::remove((path + ".levels").c_str());
+        std::remove((tempDirectory + "/" + path + ".levels").c_str());
+        std::remove(tempDirectory.c_str());
+    }
+
+    size_t fileSize() const {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        return static_cast<size_t>(file.tellg());
+    }
+
+    void flipByteAt(const size_t offset) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(offset));
+        const char byte = static_cast<char>(file.get());
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(static_cast<char>(~byte));
+    }
+
+    std::unique_ptr<Octree> octree;
+    std::string path;
+
+    /**
+     * @brief A directory for the temporary files of the writer (not created by SetUp)
+     */
+    std::string tempDirectory;
+};
+
+TEST_F(OctreeFileTest, writeAndMapTest) {
+    writeOctreeFile(*octree, path);
+
+    const std::unique_ptr<Octree> mapped = mapOctreeFile(path, true);
+
+    EXPECT_EQ(octree->getDepth(), mapped->getDepth());
+    EXPECT_EQ(octree->getMaxXYZ(), mapped->getMaxXYZ());
+    EXPECT_EQ(octree->getMaxLevel(), mapped->getMaxLevel());
+    ASSERT_EQ(octree->getNumNodes(), mapped->getNumNodes());
+
+    for (size_t i = 0; i < octree->getNumNodes(); i++) {
+        const OctreeNode node = octree->getNode(i);
+        EXPECT_EQ(node, mapped->getNode(i));
+        EXPECT_EQ(node, mapped->tryGetNodeAt(node.getLLF(), node.getLevel()));
+        EXPECT_EQ(octree->getAllNeighbourNodes(node), mapped->getAllNeighbourNodes(mapped->getNode(i)));
+    }
+
+    EXPECT_FALSE(mapped->tryGetNodeAt(Vector3i(0), 1).isValid());
+    EXPECT_FALSE(mapped->tryGetNodeAt(Vector3i(2), 0).isValid());
+    EXPECT_THROW(mapped->getNode(mapped->getNumNodes()), std::out_of_range);
+
+    EXPECT_EQ(Octree::OctreeState::VALID, mapped->checkState());
+}
+
+TEST_F(OctreeFileTest, writeWithoutChecksumsTest) {
+    writeOctreeFile(*octree, path, false);
+
+    const std::unique_ptr<Octree> mapped = mapOctreeFile(path, true);
+
+    ASSERT_EQ(octree->getNumNodes(), mapped->getNumNodes());
+    for (size_t i = 0; i < octree->getNumNodes(); i++) {
+        EXPECT_EQ(octree->getNode(i), mapped->getNode(i));
+    }
+}
+
+TEST_F(OctreeFileTest, emptyOctreeTest) {
+    const OctreeImpl empty(LinearOctree(OctantID(0, 2), {}));
+    writeOctreeFile(empty, path);
+
+    const std::unique_ptr<Octree> mapped = mapOctreeFile(path, true);
+
+    EXPECT_EQ(2, mapped->getDepth());
+    EXPECT_EQ(0, mapped->getNumNodes());
+    EXPECT_EQ(Octree::OctreeState::INCOMPLETE, mapped->checkState());
+}
+
+TEST_F(OctreeFileTest, corruptedLeafsTest) {
+    writeOctreeFile(*octree, path);
+    flipByteAt(sizeof(octreefile::Header) + 8);
+
+    EXPECT_THROW(mapOctreeFile(path, true), std::runtime_error);
+
+    // the leafs are only verified on request
+    EXPECT_NO_THROW(mapOctreeFile(path, false));
+}
+
+TEST_F(OctreeFileTest, corruptedHeaderTest) {
+    writeOctreeFile(*octree, path);
+    flipByteAt(offsetof(octreefile::Header, numLeafs));
+
+    EXPECT_THROW(mapOctreeFile(path), std::runtime_error);
+}
+
+TEST_F(OctreeFileTest, invalidFileTest) {
+    EXPECT_THROW(mapOctreeFile("does_not_exist.octree"), std::runtime_error);
+
+    {
+        std::ofstream file(path);
+        file << *octree;
+    }
+    EXPECT_THROW(mapOctreeFile(path), std::runtime_error);
+
+    writeOctreeFile(*octree, path);
+    {
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        file << "trailing data";
+    }
+    EXPECT_THROW(mapOctreeFile(path), std::runtime_error);
+}
+
+TEST_F(OctreeFileTest, writeCompressedAndReadTest) {
+    for (bool withChecksums : {true, false}) {
+        writeCompressedOctreeFile(*octree, path, withChecksums);
+
+        EXPECT_THROW(mapOctreeFile(path), std::runtime_error);
+
+        const std::unique_ptr<Octree> read = readOctreeFile(path, true);
+
+        EXPECT_EQ(octree->getDepth(), read->getDepth());
+        EXPECT_EQ(octree->getMaxXYZ(), read->getMaxXYZ());
+        EXPECT_EQ(octree->getMaxLevel(), read->getMaxLevel());
+        ASSERT_EQ(octree->getNumNodes(), read->getNumNodes());
+
+        for (size_t i = 0; i < octree->getNumNodes(); i++) {
+            const OctreeNode node = octree->getNode(i);
+            EXPECT_EQ(node, read->getNode(i));
+            EXPECT_EQ(node, read->tryGetNodeAt(node.getLLF(), node.getLevel()));
+        }
+
+        EXPECT_EQ(Octree::OctreeState::VALID, read->checkState());
+    }
+}
+
+TEST_F(OctreeFileTest, readUncompressedTest) {
+    writeOctreeFile(*octree, path);
+
+    const std::unique_ptr<Octree> read = readOctreeFile(path, true);
+
+    ASSERT_EQ(octree->getNumNodes(), read->getNumNodes());
+    for (size_t i = 0; i < octree->getNumNodes(); i++) {
+        EXPECT_EQ(octree->getNode(i), read->getNode(i));
+    }
+}
+
+TEST_F(OctreeFileTest, compressedIncompleteOctreeTest) {
+    // gaps, overlapping and unsorted leafs can't be predicted from the previous leaf
+    const LinearOctree::container_type leafs{OctantID(Vector3i(0), 0), OctantID(Vector3i(4, 0, 0), 1), OctantID(Vector3i(6, 6, 6), 0),
+                                             OctantID(Vector3i(6, 6, 6), 1), OctantID(Vector3i(2, 2, 2), 0)};
+    const OctreeImpl incomplete(LinearOctree(OctantID(0, 3), leafs));
+
+    writeCompressedOctreeFile(incomplete, path);
+    const std::unique_ptr<Octree> read = readOctreeFile(path, true);
+
+    ASSERT_EQ(incomplete.getNumNodes(), read->getNumNodes());
+    for (size_t i = 0; i < incomplete.getNumNodes(); i++) {
+        EXPECT_EQ(incomplete.getNode(i), read->getNode(i));
+    }
+}
+
+TEST_F(OctreeFileTest, compressedEmptyOctreeTest) {
+    const OctreeImpl empty(LinearOctree(OctantID(0, 2), {}));
+    writeCompressedOctreeFile(empty, path);
+
+    const std::unique_ptr<Octree> read = readOctreeFile(path, true);
+
+    EXPECT_EQ(2, read->getDepth());
+    EXPECT_EQ(0, read->getNumNodes());
+}
+
+TEST_F(OctreeFileTest, compressedMultipleBlocksTest) {
+    // all level zero leafs of a tree of depth 7 (more than one block)
+    const uint depth = 7;
+    LinearOctree::container_type leafs(size_t(1) << (3 * depth));
+    for (size_t i = 0; i < leafs.size(); i++) {
+        leafs[i] = OctantID(morton_t(i), 0);
+    }
+    ASSERT_LT(octreefile::BLOCK_SIZE, leafs.size());
+
+    const OctreeImpl full(LinearOctree(OctantID(0, depth), leafs));
+
+    writeOctreeFile(full, path);
+    const size_t uncompressedSize = fileSize();
+
+    writeCompressedOctreeFile(full, path);
+    EXPECT_LT(fileSize() * 1000, uncompressedSize);
+
+    const std::unique_ptr<Octree> read = readOctreeFile(path, true);
+
+    ASSERT_EQ(full.getNumNodes(), read->getNumNodes());
+    for (size_t i = 0; i < full.getNumNodes(); i++) {
+        ASSERT_EQ(full.getNode(i), read->getNode(i));
+    }
+}
+
+TEST_F(OctreeFileTest, corruptedCompressedLeafsTest) {
+    writeCompressedOctreeFile(*octree, path);
+    flipByteAt(fileSize() - 2);
+
+    EXPECT_THROW(readOctreeFile(path, true), std::runtime_error);
+
+    writeCompressedOctreeFile(*octree, path, false);
+    {
+        // the last block ends within a varint
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(fileSize() - 1));
+        file.put(static_cast<char>(0x80));
+    }
+
+    EXPECT_THROW(readOctreeFile(path), std::runtime_error);
+}
+
+TEST_F(OctreeFileTest, writerTempDirectoryTest) {
+    ASSERT_EQ(0, ::mkdir(tempDirectory.c_str(), 0700));
+
+    {
+        OctreeFileWriter writer(path, octree->getDepth(), true, tempDirectory);
+        for (size_t i = 0; i < octree->getNumNodes(); i++) {
+            const OctreeNode node = octree->getNode(i);
+            writer.append(OctantID(node.getMortonEncodedLLF(), node.getLevel()));
+        }
+
+        // the levels are written to the temporary directory
+        EXPECT_TRUE(std::ifstream(tempDirectory + "/" + path + ".levels").good());
+        EXPECT_FALSE(std::ifstream(path + ".levels").good());
+
+        writer.finish();
+    }
+
+    // the writer removes its temporary file
+    EXPECT_EQ(0, ::rmdir(tempDirectory.c_str()));
+
+    const std::unique_ptr<Octree> mapped = mapOctreeFile(path, true);
+    ASSERT_EQ(octree->getNumNodes(), mapped->getNumNodes());
+    for (size_t i = 0; i < octree->getNumNodes(); i++) {
+        EXPECT_EQ(octree->getNode(i), mapped->getNode(i));
+    }
+}
+
+TEST_F(OctreeFileTest, writerBufferSizeTest) {
+    writeOctreeFile(*octree, path);
+    std::ifstream expectedFile(path, std::ios::binary);
+    const std::string expected((std::istreambuf_iterator<char>(expectedFile)), std::istreambuf_iterator<char>());
+    expectedFile.close();
+
+    // the block doesn't fit into the buffer, so its checksum is computed from the levels read back from the temporary file
+    {
+        OctreeFileWriter writer(path, octree->getDepth(), true, "", 3);
+        for (size_t i = 0; i < octree->getNumNodes(); i++) {
+            const OctreeNode node = octree->getNode(i);
+            writer.append(OctantID(node.getMortonEncodedLLF(), node.getLevel()));
+        }
+        writer.finish();
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(expected, written);
+
+    const std::unique_ptr<Octree> mapped = mapOctreeFile(path, true);
+    ASSERT_EQ(octree->getNumNodes(), mapped->getNumNodes());
+    for (size_t i = 0; i < octree->getNumNodes(); i++) {
+        EXPECT_EQ(octree->getNode(i), mapped->getNode(i));
+    }
+}
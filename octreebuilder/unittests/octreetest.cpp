@@ -87,6 +87,57 @@ TEST_F(OctreeTest, tryGetNodeAtTest) {
     EXPECT_FALSE(octree4x4x4->tryGetNodeAt(Vector3i(2), 0).isValid());
 }
 
+TEST_F(OctreeTest, lookupOfOctreeFromLinearOctreeTest) {
+    // The lookup structure of an octree created from a linear octree is built on first use
+    LinearOctree::container_type leafs;
+    for (size_t i = 0; i < octree4x4x4->getNumNodes(); i++) {
+        const OctreeNode node = octree4x4x4->getNode(i);
+        leafs.push_back(OctantID(node.getMortonEncodedLLF(), node.getLevel()));
+    }
+    const OctreeImpl octree(LinearOctree(OctantID(0, 2), std::move(leafs)));
+
+    EXPECT_EQ(1, octree.getMaxLevel());
+
+    std::vector<int> found(octree.getNumNodes(), 0);
+#pragma omp parallel for
+    for (size_t i = 0; i < found.size(); i++) {
+        const OctreeNode node = octree.getNode(i);
+        found[i] = octree.tryGetNodeAt(node.getLLF(), node.getLevel()) == node;
+    }
+    EXPECT_THAT(found, ::testing::Each(1));
+
+    EXPECT_FALSE(octree.tryGetNodeAt(Vector3i(0), 1).isValid());
+    EXPECT_FALSE(octree.tryGetNodeAt(Vector3i(2), 0).isValid());
+}
+
+TEST_F(OctreeTest, traceRayOctree4x4x4Test) {
+    // Along the x-axis through the nodes (0,0,0), (1,0,0) and (2,0,0)
+    RayTraversal traversal = octree4x4x4->traceRay(Ray{{{-1, 0.5, 0.5}}, {{1, 0, 0}}});
+
+    ASSERT_EQ(3, traversal.nodeIndices.size());
+    EXPECT_EQ(OctreeNode(getMortonCodeForCoordinate(Vector3i(0, 0, 0)), 0), octree4x4x4->getNode(traversal.nodeIndices[0]));
+    EXPECT_EQ(OctreeNode(getMortonCodeForCoordinate(Vector3i(1, 0, 0)), 0), octree4x4x4->getNode(traversal.nodeIndices[1]));
+    EXPECT_EQ(OctreeNode(getMortonCodeForCoordinate(Vector3i(2, 0, 0)), 1), octree4x4x4->getNode(traversal.nodeIndices[2]));
+    EXPECT_THAT(traversal.entry, ::testing::ElementsAre(1, 2, 3));
+    EXPECT_THAT(traversal.exit, ::testing::ElementsAre(2, 3, 5));
+
+    // Diagonal from the urb to the llf of the tree (passes the shared vertices of the nodes)
+    traversal = octree4x4x4->traceRay(Ray{{{4, 4, 4}}, {{-1, -1, -1}}});
+
+    ASSERT_EQ(3, traversal.nodeIndices.size());
+    EXPECT_EQ(OctreeNode(getMortonCodeForCoordinate(Vector3i(2, 2, 2)), 1), octree4x4x4->getNode(traversal.nodeIndices[0]));
+    EXPECT_EQ(OctreeNode(getMortonCodeForCoordinate(Vector3i(1, 1, 1)), 0), octree4x4x4->getNode(traversal.nodeIndices[1]));
+    EXPECT_EQ(OctreeNode(getMortonCodeForCoordinate(Vector3i(0, 0, 0)), 0), octree4x4x4->getNode(traversal.nodeIndices[2]));
+    EXPECT_THAT(traversal.entry, ::testing::ElementsAre(0, 2, 3));
+    EXPECT_THAT(traversal.exit, ::testing::ElementsAre(2, 3, 4));
+
+    // Misses the tree
+    EXPECT_TRUE(octree4x4x4->traceRay(Ray{{{-1, 0.5, 0.5}}, {{-1, 0, 0}}}).nodeIndices.empty());
+    EXPECT_TRUE(octree4x4x4->traceRay(Ray{{{0.5, 5, 0.5}}, {{1, 0, 0}}}).nodeIndices.empty());
+
+    EXPECT_THROW(octree4x4x4->traceRay(Ray{{{0.5, 0.5, 0.5}}, {{0, 0, 0}}}), std::runtime_error);
+}
+
 static OctreeNode findNodeWithLLF(const std::vector<OctreeNode>& nodes, const Vector3i& llf) {
     auto it = std::find_if(nodes.begin(), nodes.end(), [&llf](const OctreeNode& n) {
         return n.getLLF() == llf;
@@ -260,6 +311,115 @@ TEST_F(OctreeTest, getNeighbourNodeOctree4x4x4InverseTest) {
     EXPECT_THAT(octree4x4x4_inverse->getNeighbourNodes(nodeAt_2_0_2, OctreeNode::Face::BOTTOM), ::testing::ElementsAre(nodeAt_2_0_0));
 }
 
+TEST_F(OctreeTest, getEdgeAndVertexNeighbourNodesOctree4x4x4Test) {
+
+    // get all nodes
+    std::vector<OctreeNode> nodes;
+    for (size_t i = 0; i < octree4x4x4->getNumNodes(); i++) {
+        nodes.push_back(octree4x4x4->getNode(i));
+    }
+
+    OctreeNode nodeAt_0_0_0 = findNodeWithLLF(nodes, Vector3i(0, 0, 0));
+    OctreeNode nodeAt_1_1_0 = findNodeWithLLF(nodes, Vector3i(1, 1, 0));
+    OctreeNode nodeAt_1_1_1 = findNodeWithLLF(nodes, Vector3i(1, 1, 1));
+
+    OctreeNode nodeAt_0_2_0 = findNodeWithLLF(nodes, Vector3i(0, 2, 0));
+    OctreeNode nodeAt_2_0_0 = findNodeWithLLF(nodes, Vector3i(2, 0, 0));
+    OctreeNode nodeAt_2_0_2 = findNodeWithLLF(nodes, Vector3i(2, 0, 2));
+    OctreeNode nodeAt_2_2_0 = findNodeWithLLF(nodes, Vector3i(2, 2, 0));
+    OctreeNode nodeAt_2_2_2 = findNodeWithLLF(nodes, Vector3i(2, 2, 2));
+
+    // same level
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_0_0_0, OctreeNode::Vertex::RIGHT_BACK_TOP), ::testing::ElementsAre(nodeAt_1_1_1));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_0_0_0, OctreeNode::Vertex::LEFT_FRONT_BOTTOM), ::testing::IsEmpty());
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_0_0_0, OctreeNode::Edge::RIGHT_BACK), ::testing::ElementsAre(nodeAt_1_1_0));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_0_0_0, OctreeNode::Edge::LEFT_TOP), ::testing::IsEmpty());
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_2_0_0, OctreeNode::Edge::LEFT_BACK), ::testing::ElementsAre(nodeAt_0_2_0));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_0_2_0, OctreeNode::Edge::RIGHT_FRONT), ::testing::ElementsAre(nodeAt_2_0_0));
+
+    // parent level
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_1_1_1, OctreeNode::Vertex::RIGHT_BACK_TOP), ::testing::ElementsAre(nodeAt_2_2_2));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_1_1_1, OctreeNode::Edge::RIGHT_TOP), ::testing::ElementsAre(nodeAt_2_0_2));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_1_1_1, OctreeNode::Vertex::LEFT_FRONT_BOTTOM), ::testing::ElementsAre(nodeAt_0_0_0));
+
+    // child level
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_2_2_2, OctreeNode::Vertex::LEFT_FRONT_BOTTOM), ::testing::ElementsAre(nodeAt_1_1_1));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_2_2_0, OctreeNode::Edge::LEFT_FRONT), ::testing::UnorderedElementsAre(nodeAt_1_1_0, nodeAt_1_1_1));
+    EXPECT_THAT(octree4x4x4->getNeighbourNodes(nodeAt_2_2_0, OctreeNode::Edge::LEFT_BOTTOM), ::testing::IsEmpty());
+}
+
+TEST_F(OctreeTest, getAllNeighbourNodesOctree4x4x4Test) {
+
+    // get all nodes
+    std::vector<OctreeNode> nodes;
+    for (size_t i = 0; i < octree4x4x4->getNumNodes(); i++) {
+        nodes.push_back(octree4x4x4->getNode(i));
+    }
+
+    OctreeNode nodeAt_0_0_0 = findNodeWithLLF(nodes, Vector3i(0, 0, 0));
+    OctreeNode nodeAt_1_1_1 = findNodeWithLLF(nodes, Vector3i(1, 1, 1));
+    OctreeNode nodeAt_2_2_2 = findNodeWithLLF(nodes, Vector3i(2, 2, 2));
+
+    // the level zero nodes only
+    EXPECT_THAT(octree4x4x4->getAllNeighbourNodes(nodeAt_0_0_0),
+                ::testing::AllOf(::testing::SizeIs(7), ::testing::Each(::testing::Property(&OctreeNode::getLevel, 0)),
+                                 ::testing::Not(::testing::Contains(nodeAt_0_0_0))));
+
+    // all other nodes
+    EXPECT_THAT(octree4x4x4->getAllNeighbourNodes(nodeAt_1_1_1), ::testing::AllOf(::testing::SizeIs(14), ::testing::Not(::testing::Contains(nodeAt_1_1_1))));
+
+    // the other level one nodes and the level zero node at (1,1,1)
+    EXPECT_THAT(octree4x4x4->getAllNeighbourNodes(nodeAt_2_2_2),
+                ::testing::AllOf(::testing::SizeIs(7), ::testing::Contains(nodeAt_1_1_1), ::testing::Not(::testing::Contains(nodeAt_2_2_2))));
+
+    const std::vector<std::vector<OctreeNode>> neighbourNodesOfAllNodes = octree4x4x4->getAllNeighbourNodesOfAllNodes();
+
+    ASSERT_EQ(octree4x4x4->getNumNodes(), neighbourNodesOfAllNodes.size());
+    for (size_t i = 0; i < octree4x4x4->getNumNodes(); i++) {
+        EXPECT_THAT(neighbourNodesOfAllNodes.at(i), ::testing::ElementsAreArray(octree4x4x4->getAllNeighbourNodes(octree4x4x4->getNode(i))));
+    }
+}
+
+TEST_F(OctreeTest, computeVertexNumberingOctree4x4x4Test) {
+    const VertexNumbering numbering = octree4x4x4->computeVertexNumbering();
+
+    // 27 vertices of the level zero nodes and 27 vertices of the level one nodes (8 are shared)
+    EXPECT_THAT(numbering.vertices, ::testing::SizeIs(46));
+    EXPECT_TRUE(std::is_sorted(numbering.vertices.begin(), numbering.vertices.end()));
+    EXPECT_TRUE(std::adjacent_find(numbering.vertices.begin(), numbering.vertices.end()) == numbering.vertices.end());
+
+    ASSERT_THAT(numbering.nodeVertices, ::testing::SizeIs(8 * octree4x4x4->getNumNodes()));
+    for (size_t i = 0; i < octree4x4x4->getNumNodes(); i++) {
+        const OctreeNode node = octree4x4x4->getNode(i);
+
+        for (size_t v = 0; v < 8; v++) {
+            const Vector3i direction = OctreeNode::getDirectionOfVertex(static_cast<OctreeNode::Vertex>(v));
+            const Vector3i expectedVertex = node.getLLF() + Vector3i(direction.x() > 0 ? 1 : 0, direction.y() > 0 ? 1 : 0, direction.z() > 0 ? 1 : 0) * node.getSize();
+
+            EXPECT_EQ(expectedVertex, getCoordinateForMortonCode(numbering.vertices.at(numbering.nodeVertices.at(8 * i + v))));
+        }
+    }
+
+    // The vertices of the level zero nodes at the boundary to the level one nodes that aren't vertices of the level one nodes
+    std::vector<Vector3i> hangingVertices;
+    ASSERT_THAT(numbering.isHanging, ::testing::SizeIs(numbering.vertices.size()));
+    for (size_t i = 0; i < numbering.vertices.size(); i++) {
+        if (numbering.isHanging.at(i)) {
+            hangingVertices.push_back(getCoordinateForMortonCode(numbering.vertices.at(i)));
+        }
+    }
+
+    EXPECT_THAT(hangingVertices, ::testing::SizeIs(12));
+    EXPECT_THAT(hangingVertices, ::testing::Each(::testing::AllOf(::testing::Property(&Vector3i::x, ::testing::Le(2)),
+                                                                  ::testing::Property(&Vector3i::y, ::testing::Le(2)),
+                                                                  ::testing::Property(&Vector3i::z, ::testing::Le(2)))));
+    EXPECT_THAT(hangingVertices, ::testing::Contains(Vector3i(2, 1, 0)));
+    EXPECT_THAT(hangingVertices, ::testing::Contains(Vector3i(1, 2, 2)));
+    EXPECT_THAT(hangingVertices, ::testing::Contains(Vector3i(2, 1, 1)));
+    EXPECT_THAT(hangingVertices, ::testing::Not(::testing::Contains(Vector3i(1, 0, 0))));
+    EXPECT_THAT(hangingVertices, ::testing::Not(::testing::Contains(Vector3i(2, 2, 2))));
+}
+
 TEST_F(OctreeTest, checkStateOfValidTreeTest) {
     EXPECT_EQ(octree4x4x4->checkState(), Octree::OctreeState::VALID);
     EXPECT_EQ(octree4x4x4_inverse->checkState(), Octree::OctreeState::VALID);
@@ -0,0 +1,94 @@
+#include <gmock/gmock.h>
+
+#include <tracer.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace octreebuilder;
+
+TEST(TracerTest, recordOnlyWhileActiveTest) {
+    Tracer tracer;
+
+    { TraceScope scope("before"); }
+
+    tracer.activate();
+    EXPECT_EQ(&tracer, Tracer::activeTracer());
+
+    {
+        TraceScope outer("outer");
+        outer.addArg("size", 42);
+        { TraceScope inner("inner", "test"); }
+    }
+
+    tracer.deactivate();
+    EXPECT_EQ(nullptr, Tracer::activeTracer());
+
+    { TraceScope scope("after"); }
+
+    const std::vector<Tracer::Event> events = tracer.events();
+    ASSERT_EQ(2, events.size());
+
+    // Events are recorded when they end
+    EXPECT_EQ("inner", events[0].name);
+    EXPECT_EQ("test", events[0].category);
+    EXPECT_EQ("outer", events[1].name);
+    EXPECT_THAT(events[1].args, ::testing::ElementsAre(std::make_pair(std::string("size"), 42LL)));
+
+    // inner is nested in outer
+    EXPECT_LE(events[1].start, events[0].start);
+    EXPECT_GE(events[1].start + events[1].duration, events[0].start + events[0].duration);
+    EXPECT_EQ(events[0].thread, events[1].thread);
+}
+
+TEST(TracerTest, onlyOneActiveTracerTest) {
+    Tracer tracer;
+    tracer.activate();
+
+    {
+        Tracer other;
+        EXPECT_THROW(other.activate(), std::runtime_error);
+    }
+
+    EXPECT_EQ(&tracer, Tracer::activeTracer());
+    tracer.deactivate();
+}
+
+TEST(TracerTest, threadsTest) {
+    Tracer tracer;
+    tracer.activate();
+
+    Tracer::recordCompletedEvent("main", "test", std::chrono::milliseconds(1));
+    std::thread thread([]() { Tracer::recordCompletedEvent("thread", "test", std::chrono::milliseconds(1)); });
+    thread.join();
+
+    tracer.deactivate();
+
+    const std::vector<Tracer::Event> events = tracer.events();
+    ASSERT_EQ(2, events.size());
+    EXPECT_EQ(0, events[0].thread);
+    EXPECT_EQ(1, events[1].thread);
+    EXPECT_EQ(std::chrono::milliseconds(1), events[0].duration);
+}
+
+TEST(TracerTest, writeChromeTraceTest) {
+    Tracer tracer;
+    tracer.activate();
+
+    {
+        TraceScope scope("a \"quoted\" name");
+        scope.addArg("block", 3);
+    }
+
+    tracer.deactivate();
+
+    std::ostringstream json;
+    tracer.writeChromeTrace(json);
+
+    const std::string trace = json.str();
+    EXPECT_THAT(trace, ::testing::StartsWith("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_THAT(trace, ::testing::HasSubstr("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"thread 0\"}}"));
+    EXPECT_THAT(trace, ::testing::HasSubstr("{\"name\":\"a \\\"quoted\\\" name\",\"cat\":\"octreebuilder\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":"));
+    EXPECT_THAT(trace, ::testing::HasSubstr(",\"args\":{\"block\":3}}"));
+    EXPECT_THAT(trace, ::testing::EndsWith("\n]}\n"));
+}
@@ -0,0 +1,95 @@
+#include <gmock/gmock.h>
+
+#include <trianglevoxelizer.h>
+#include <mortoncode_utils.h>
+#include <vector_utils.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+using namespace octreebuilder;
+
+TEST(TriangleVoxelizerTest, triangleIntersectsBoxTest) {
+    const Box unitBox(Vector3i(0), Vector3i(1));
+
+    // crosses the box
+    EXPECT_TRUE(triangleIntersectsBox({{{-1, 0.5, -1}, {2, 0.5, -1}, {0.5, 0.5, 2}}}, unitBox));
+
+    // inside of the box
+    EXPECT_TRUE(triangleIntersectsBox({{{0.1, 0.1, 0.1}, {0.2, 0.1, 0.1}, {0.1, 0.2, 0.1}}}, unitBox));
+
+    // touches a face of the box (closed box)
+    EXPECT_TRUE(triangleIntersectsBox({{{1, 0, 0}, {2, 0, 0}, {1, 1, 1}}}, unitBox));
+
+    // beside the box
+    EXPECT_FALSE(triangleIntersectsBox({{{1.5, 0, 0}, {2, 0, 0}, {1.5, 1, 1}}}, unitBox));
+
+    // the bounding boxes overlap, but the plane of the triangle passes the corner (1, 1, 1)
+    EXPECT_FALSE(triangleIntersectsBox({{{3.5, 0, 0}, {0, 3.5, 0}, {0, 0, 3.5}}}, Box(Vector3i(0), Vector3i(1))));
+    EXPECT_TRUE(triangleIntersectsBox({{{2.5, 0, 0}, {0, 2.5, 0}, {0, 0, 2.5}}}, Box(Vector3i(0), Vector3i(1))));
+}
+
+TEST(TriangleVoxelizerTest, voxelizeTriangleTest) {
+    std::default_random_engine generator(1234);
+    std::uniform_real_distribution<double> vertexDistribution(-2.0, 18.0);
+    std::uniform_real_distribution<double> barycentricDistribution(0.0, 1.0);
+
+    const Box domain(Vector3i(16));
+
+    for (size_t i = 0; i < 100; i++) {
+        Triangle triangle;
+        for (std::array<double, 3>& vertex : triangle) {
+            for (double& c : vertex) {
+                c = vertexDistribution(generator);
+            }
+        }
+
+        std::vector<morton_t> codes;
+        voxelizeTriangle(triangle, domain, codes);
+
+        // the same voxels as testing every voxel of the domain
+        std::vector<morton_t> expected;
+        for (const Vector3i& voxel : VectorSpace(domain.urb())) {
+            if (triangleIntersectsBox(triangle, Box(voxel, voxel + Vector3i(1)))) {
+                expected.push_back(getMortonCodeForCoordinate(voxel));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        ASSERT_EQ(expected, std::vector<morton_t>(codes.begin(), codes.end()));
+
+        // all points of the triangle inside of the domain are covered
+        const std::set<morton_t> voxels(codes.begin(), codes.end());
+        for (size_t p = 0; p < 100; p++) {
+            double u = barycentricDistribution(generator);
+            double v = barycentricDistribution(generator);
+            if (u + v > 1) {
+                u = 1 - u;
+                v = 1 - v;
+            }
+
+            coord_t point[3];
+            for (uint c = 0; c < 3; c++) {
+                point[c] = static_cast<coord_t>(std::floor(triangle[0][c] + u * (triangle[1][c] - triangle[0][c]) + v * (triangle[2][c] - triangle[0][c])));
+            }
+
+            const Vector3i voxel(point[0], point[1], point[2]);
+            if (domain.contains(voxel) && voxel.x() < 16 && voxel.y() < 16 && voxel.z() < 16) {
+                EXPECT_EQ(1u, voxels.count(getMortonCodeForCoordinate(voxel)));
+            }
+        }
+    }
+}
+
+TEST(TriangleVoxelizerTest, voxelizeTriangleOutsideOfDomainTest) {
+    std::vector<morton_t> codes;
+
+    voxelizeTriangle({{{-5, -5, -5}, {-1.5, -5, -5}, {-5, -1.5, -5}}}, Box(Vector3i(8)), codes);
+    voxelizeTriangle({{{0, 0, 0}, {0, 0, 0}, {0, 0, NAN}}}, Box(Vector3i(8)), codes);
+    EXPECT_TRUE(codes.empty());
+
+    // a single voxel
+    voxelizeTriangle({{{2.25, 3.25, 4.25}, {2.5, 3.25, 4.25}, {2.25, 3.5, 4.5}}}, Box(Vector3i(8)), codes);
+    EXPECT_THAT(codes, ::testing::ElementsAre(getMortonCodeForCoordinate(Vector3i(2, 3, 4))));
+}